@@ -8,6 +8,24 @@
 #define BINARY_NAME "bling"
 #define INSTALL_PATH "/usr/local/bin/" BINARY_NAME
 
+#define LIB_STATIC BUILD_FOLDER "libbling.a"
+#define LIB_STATIC_OBJECT BUILD_FOLDER "libbling.o"
+#define LIB_INTERNAL BUILD_FOLDER "libbling-internal.a"
+#define LIB_SONAME "libbling.so.1"
+#define LIB_SHARED BUILD_FOLDER LIB_SONAME
+#define LIB_SHARED_LINK BUILD_FOLDER "libbling.so"
+
+#define INSTRUMENTED_BINARY BUILD_FOLDER "bling-instrumented"
+#define BENCH_BINARY BUILD_FOLDER "bling-bench"
+#define BENCH_RESULTS BUILD_FOLDER "bench"
+#define FIXTUREGEN_BINARY BUILD_FOLDER "bling-fixturegen"
+#define FIXTURES BUILD_FOLDER "fixtures"
+#define RELEASE_FOLDER BUILD_FOLDER "release/"
+#define RELEASE_BINARY RELEASE_FOLDER BINARY_NAME
+#define PROFILE_FOLDER RELEASE_FOLDER "profile"
+#define TRAINING_FIXTURE FIXTURES "/scale-0.01"
+#define STARTUP_RUNS 101
+
 int create_database(const char *sources[], size_t sources_count, const char *cflags[], size_t cflags_count, const char *cc) {
 
     Nob_String_Builder sb = { 0 };
@@ -60,65 +78,272 @@ int create_database(const char *sources[], size_t sources_count, const char *cfl
     return 0;
 }
 
+/**
+ * Compile each source to BUILD_FOLDER/<name>.o, appending the object paths to object_files.
+ * Compilation runs async on procs; the caller waits.
+ */
+int compile_sources(const char *sources[], size_t sources_count, const char *cflags[], size_t cflags_count,
+                    const char *cc, Nob_File_Paths *object_files, Nob_Procs *procs) {
+    Nob_Cmd cmd = { 0 };
+
+    for (size_t i = 0; i < sources_count; ++i) {
+        const char *src_path = sources[i];
+
+        const char *obj_path = nob_temp_sprintf("%s%s.o", BUILD_FOLDER, nob_path_name(src_path));
+
+        // Add to the list of objects for the linker later
+        nob_da_append(object_files, obj_path);
+
+        // Check if the source needs recompilation
+        if (nob_needs_rebuild1(obj_path, src_path)) {
+            cmd.count = 0;
+            nob_cmd_append(&cmd, cc);
+            nob_cmd_append(&cmd, "-c", src_path);
+            nob_cmd_append(&cmd, "-o", obj_path);
+            nob_da_append_many(&cmd, cflags, cflags_count);
+
+            // Run async
+            if (!nob_cmd_run(&cmd, .async = procs)) {
+                nob_cmd_free(cmd);
+                return 1;
+            }
+        }
+    }
+
+    nob_cmd_free(cmd);
+    return 0;
+}
+
+/**
+ * Compile each source to RELEASE_FOLDER/<name>.o with flags, appending the object paths to object_files.
+ * Always recompiles: the same objects are built twice per release, first instrumented and then with the profile.
+ * Compilation runs async on procs; the caller waits.
+ */
+int compile_release(const char *sources[], size_t sources_count, const Nob_Cmd *flags, const char *cc,
+                    Nob_File_Paths *object_files, Nob_Procs *procs) {
+    Nob_Cmd cmd = { 0 };
+
+    for (size_t i = 0; i < sources_count; ++i) {
+        const char *obj_path = nob_temp_sprintf("%s%s.o", RELEASE_FOLDER, nob_path_name(sources[i]));
+        nob_da_append(object_files, obj_path);
+
+        cmd.count = 0;
+        nob_cmd_append(&cmd, cc, "-c", sources[i], "-o", obj_path);
+        nob_da_append_many(&cmd, flags->items, flags->count);
+        if (!nob_cmd_run(&cmd, .async = procs)) {
+            nob_cmd_free(cmd);
+            return 1;
+        }
+    }
+
+    nob_cmd_free(cmd);
+    return 0;
+}
+
+/**
+ * Run cmd with its output discarded, logging only failures.
+ */
+bool run_quiet(Nob_Cmd *cmd) {
+    Nob_Log_Level level = nob_minimal_log_level;
+    nob_minimal_log_level = NOB_WARNING;
+    bool ok = nob_cmd_run(cmd, .stdout_path = "/dev/null");
+    nob_minimal_log_level = level;
+    return ok;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Median wall time of STARTUP_RUNS runs (a full report to /dev/null) of each of the count binaries, into median_ns.
+ * Runs alternate between the binaries so that drift in machine load hits all of them alike.
+ */
+bool median_run_ns(const char *binaries[], size_t count, uint64_t median_ns[]) {
+    uint64_t *times = malloc(count * STARTUP_RUNS * sizeof(*times));
+    Nob_Cmd cmd = { 0 };
+    bool ok = times != NULL;
+
+    for (size_t i = 0; ok && i < STARTUP_RUNS; ++i) {
+        for (size_t b = 0; ok && b < count; ++b) {
+            cmd.count = 0;
+            nob_cmd_append(&cmd, binaries[b]);
+            uint64_t start = nob_nanos_since_unspecified_epoch();
+            ok = run_quiet(&cmd);
+            times[b * STARTUP_RUNS + i] = nob_nanos_since_unspecified_epoch() - start;
+        }
+    }
+    for (size_t b = 0; ok && b < count; ++b) {
+        qsort(times + b * STARTUP_RUNS, STARTUP_RUNS, sizeof(*times), compare_u64);
+        median_ns[b] = times[b * STARTUP_RUNS + STARTUP_RUNS / 2];
+    }
+
+    nob_cmd_free(cmd);
+    free(times);
+    return ok;
+}
+
+long long file_size(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long long)st.st_size : -1;
+}
+
 int main(int argc, char **argv) {
     NOB_GO_REBUILD_URSELF(argc, argv);
 
     // Configuration
     const char *cc = "clang";
     const char *cflags[] = { "-Wall", "-Wextra", "-g", "-std=c99" }; // Add common flags here
-    const char *libs[] = {};
+    // libbling objects are position independent and only export the BLING_API symbols from bling.h
+    const char *lib_cflags[] = { "-Wall", "-Wextra", "-g", "-std=c99", "-fPIC", "-fvisibility=hidden" };
+    // The --bench kernels measure the machine, not the compiler, so they are always optimized
+    const char *bench_cflags[] = { "-Wall", "-Wextra", "-g", "-std=c99", "-O2" };
+    const char *libs[] = { "-pthread" };
+    // Only bling-bench and bling-instrumented are linked with the counting shim in instrument.c: every listed call
+    // from bling code goes through it
+    const char *instrument_ldflags[] = { "-Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=free,--wrap=strdup,"
+                                         "--wrap=strndup,--wrap=posix_memalign,--wrap=open,--wrap=openat,--wrap=fopen,"
+                                         "--wrap=opendir,--wrap=read,--wrap=pread,--wrap=fgets" };
 
     // Sources
-    const char *sources[] = { SRC_FOLDER "main.c", SRC_FOLDER "file.c", SRC_FOLDER "util.c", SRC_FOLDER "system.c" };
+    const char *lib_sources[] = { SRC_FOLDER "bling.c", SRC_FOLDER "file.c", SRC_FOLDER "util.c", SRC_FOLDER "system.c",
+                                  SRC_FOLDER "worker.c", SRC_FOLDER "mounts.c",
+                                  SRC_FOLDER "topology.c", SRC_FOLDER "cpustat.c",
+                                  SRC_FOLDER "pressure.c", SRC_FOLDER "cgroup.c",
+                                  SRC_FOLDER "procs.c", SRC_FOLDER "sockets.c",
+                                  SRC_FOLDER "netdev.c", SRC_FOLDER "diskstats.c",
+                                  SRC_FOLDER "vmstat.c",
+                                  SRC_FOLDER "memfrag.c",
+                                  SRC_FOLDER "audit.c",
+                                  SRC_FOLDER "virt.c",
+                                  SRC_FOLDER "thermal.c",
+                                  SRC_FOLDER "ioprobe.c",
+                                  SRC_FOLDER "trace.c" };
+    const char *bin_sources[] = { SRC_FOLDER "main.c", SRC_FOLDER "report.c", SRC_FOLDER "json.c" };
+    const char *bench_sources[] = { SRC_FOLDER "bench.c" };
+    const char *collector_bench_sources[] = { SRC_FOLDER "collector_bench.c", SRC_FOLDER "instrument.c" };
+    const char *fixturegen_sources[] = { SRC_FOLDER "fixturegen.c" };
+    const char *instrument_sources[] = { SRC_FOLDER "instrument.c" };
+    // Fixture sizes for `./nob scale`, as fractions of the largest host bling-fixturegen writes (4096 CPUs, 200k PIDs)
+    const char *default_scales[] = { "0.01", "0.03", "0.1", "0.3" };
 
     if (!nob_mkdir_if_not_exists(BUILD_FOLDER))
         return 1;
 
     Nob_Cmd cmd = { 0 };
-    Nob_File_Paths object_files = { 0 };
+    Nob_File_Paths lib_objects = { 0 };
+    Nob_File_Paths bin_objects = { 0 };
+    Nob_File_Paths fixturegen_objects = { 0 };
+    Nob_File_Paths instrument_objects = { 0 };
     Nob_Procs procs = { 0 };
 
-    if (create_database(sources, NOB_ARRAY_LEN(sources), cflags, NOB_ARRAY_LEN(cflags), cc) != 0) {
-        return 1;
+    {
+        const char *all_sources[NOB_ARRAY_LEN(lib_sources) + NOB_ARRAY_LEN(bin_sources) + NOB_ARRAY_LEN(bench_sources) +
+                                NOB_ARRAY_LEN(collector_bench_sources) + NOB_ARRAY_LEN(fixturegen_sources)];
+        size_t n = 0;
+        for (size_t i = 0; i < NOB_ARRAY_LEN(lib_sources); ++i)
+            all_sources[n++] = lib_sources[i];
+        for (size_t i = 0; i < NOB_ARRAY_LEN(bin_sources); ++i)
+            all_sources[n++] = bin_sources[i];
+        for (size_t i = 0; i < NOB_ARRAY_LEN(bench_sources); ++i)
+            all_sources[n++] = bench_sources[i];
+        for (size_t i = 0; i < NOB_ARRAY_LEN(collector_bench_sources); ++i)
+            all_sources[n++] = collector_bench_sources[i];
+        for (size_t i = 0; i < NOB_ARRAY_LEN(fixturegen_sources); ++i)
+            all_sources[n++] = fixturegen_sources[i];
+
+        if (create_database(all_sources, n, lib_cflags, NOB_ARRAY_LEN(lib_cflags), cc) != 0) {
+            return 1;
+        }
     }
 
     // Compile source files to objects
-    for (size_t i = 0; i < NOB_ARRAY_LEN(sources); ++i) {
-        const char *src_path = sources[i];
+    if (compile_sources(lib_sources, NOB_ARRAY_LEN(lib_sources), lib_cflags, NOB_ARRAY_LEN(lib_cflags), cc,
+                        &lib_objects, &procs) != 0)
+        return 1;
+    if (compile_sources(bin_sources, NOB_ARRAY_LEN(bin_sources), cflags, NOB_ARRAY_LEN(cflags), cc, &bin_objects,
+                        &procs) != 0)
+        return 1;
+    if (compile_sources(bench_sources, NOB_ARRAY_LEN(bench_sources), bench_cflags, NOB_ARRAY_LEN(bench_cflags), cc,
+                        &bin_objects, &procs) != 0)
+        return 1;
+    // Writing 200k-PID trees is I/O bound, but the generator is optimized so the CPU side never is
+    if (compile_sources(fixturegen_sources, NOB_ARRAY_LEN(fixturegen_sources), bench_cflags,
+                        NOB_ARRAY_LEN(bench_cflags), cc, &fixturegen_objects, &procs) != 0)
+        return 1;
+    if (compile_sources(instrument_sources, NOB_ARRAY_LEN(instrument_sources), cflags, NOB_ARRAY_LEN(cflags), cc,
+                        &instrument_objects, &procs) != 0)
+        return 1;
 
-        const char *obj_path = nob_temp_sprintf("%s%s.o", BUILD_FOLDER, nob_path_name(src_path));
+    // Wait for comp to finish
+    if (!nob_procs_wait(procs))
+        return 1;
 
-        // Add to the list of objects for the linker later
-        nob_da_append(&object_files, obj_path);
+    // Internal static library, every symbol global: bling and the in-tree tools call collectors bling.h doesn't have
+    if (nob_needs_rebuild(LIB_INTERNAL, lib_objects.items, lib_objects.count)) {
+        cmd.count = 0;
+        nob_cmd_append(&cmd, "ar", "rcs", LIB_INTERNAL);
+        nob_da_append_many(&cmd, lib_objects.items, lib_objects.count);
 
-        // Check if the source needs recompilation
-        if (nob_needs_rebuild1(obj_path, src_path)) {
-            cmd.count = 0;
-            nob_cmd_append(&cmd, cc);
-            nob_cmd_append(&cmd, "-c", src_path);
-            nob_cmd_append(&cmd, "-o", obj_path);
-            nob_da_append_many(&cmd, cflags, NOB_ARRAY_LEN(cflags));
+        // ar adds to an existing archive, start from scratch so removed sources don't linger
+        remove(LIB_INTERNAL);
+        if (!nob_cmd_run(&cmd))
+            return 1;
+    }
 
-            // Run async
-            if (!nob_cmd_run(&cmd, .async = &procs))
-                return 1;
-        }
+    // Static library: the objects linked into one, with the hidden symbols made local, so a static consumer only
+    // sees the BLING_API symbols (-fvisibility=hidden alone does that for the shared library only)
+    if (nob_needs_rebuild(LIB_STATIC, lib_objects.items, lib_objects.count)) {
+        cmd.count = 0;
+        nob_cmd_append(&cmd, "ld", "-r", "-o", LIB_STATIC_OBJECT);
+        nob_da_append_many(&cmd, lib_objects.items, lib_objects.count);
+        if (!nob_cmd_run(&cmd))
+            return 1;
+
+        cmd.count = 0;
+        nob_cmd_append(&cmd, "objcopy", "--localize-hidden", LIB_STATIC_OBJECT);
+        if (!nob_cmd_run(&cmd))
+            return 1;
+
+        cmd.count = 0;
+        nob_cmd_append(&cmd, "ar", "rcs", LIB_STATIC, LIB_STATIC_OBJECT);
+        remove(LIB_STATIC);
+        if (!nob_cmd_run(&cmd))
+            return 1;
     }
 
-    // Wait for comp to finish
-    if (!nob_procs_wait(procs))
-        return 1;
+    // Shared library
+    if (nob_needs_rebuild(LIB_SHARED, lib_objects.items, lib_objects.count)) {
+        cmd.count = 0;
+        nob_cmd_append(&cmd, cc, "-shared", "-Wl,-soname," LIB_SONAME);
+        nob_cmd_append(&cmd, "-o", LIB_SHARED);
+        nob_da_append_many(&cmd, lib_objects.items, lib_objects.count);
+        nob_da_append_many(&cmd, libs, NOB_ARRAY_LEN(libs));
+
+        if (!nob_cmd_run(&cmd))
+            return 1;
+
+        // Development symlink so consumers can link with -lbling
+        remove(LIB_SHARED_LINK);
+        if (symlink(LIB_SONAME, LIB_SHARED_LINK) != 0) {
+            nob_log(NOB_ERROR, "Could not link %s: %s", LIB_SHARED_LINK, strerror(errno));
+            return 1;
+        }
+    }
 
     const char *binary_path = BUILD_FOLDER BINARY_NAME;
 
     // Check if the binary needs relinking (if binary is missing OR any object file is newer)
-    if (nob_needs_rebuild(binary_path, object_files.items, object_files.count)) {
+    nob_da_append(&bin_objects, LIB_INTERNAL);
+    if (nob_needs_rebuild(binary_path, bin_objects.items, bin_objects.count)) {
         cmd.count = 0;
 
         nob_cmd_append(&cmd, cc);
         nob_cmd_append(&cmd, "-o", binary_path);
-        // Append all object files
-        nob_da_append_many(&cmd, object_files.items, object_files.count);
+        // Append all object files, then libbling itself
+        nob_da_append_many(&cmd, bin_objects.items, bin_objects.count);
         // Append libraries (usually last)
         nob_da_append_many(&cmd, libs, NOB_ARRAY_LEN(libs));
 
@@ -126,8 +351,272 @@ int main(int argc, char **argv) {
             return 1;
     }
 
-    // Install Step
+    // The same bling with the counting shim, so --timings can show files opened, bytes read and allocations
+    // per collector on a host where the plain binary is slow
+    {
+        Nob_File_Paths inputs = { 0 };
+        nob_da_append_many(&inputs, instrument_objects.items, instrument_objects.count);
+        nob_da_append_many(&inputs, bin_objects.items, bin_objects.count); // Ends with libbling-internal.a
+        if (nob_needs_rebuild(INSTRUMENTED_BINARY, inputs.items, inputs.count)) {
+            cmd.count = 0;
+            nob_cmd_append(&cmd, cc, "-o", INSTRUMENTED_BINARY);
+            nob_da_append_many(&cmd, inputs.items, inputs.count);
+            nob_da_append_many(&cmd, instrument_ldflags, NOB_ARRAY_LEN(instrument_ldflags));
+            nob_da_append_many(&cmd, libs, NOB_ARRAY_LEN(libs));
+            if (!nob_cmd_run(&cmd))
+                return 1;
+        }
+        nob_da_free(inputs);
+    }
+
+    // Synthetic fixture generator, standalone: it only writes files
+    if (nob_needs_rebuild(FIXTUREGEN_BINARY, fixturegen_objects.items, fixturegen_objects.count)) {
+        cmd.count = 0;
+        nob_cmd_append(&cmd, cc, "-o", FIXTUREGEN_BINARY);
+        nob_da_append_many(&cmd, fixturegen_objects.items, fixturegen_objects.count);
+        if (!nob_cmd_run(&cmd))
+            return 1;
+    }
+
+    // Benchmark step: time every collector with the instrumented bling-bench, keeping JSON results under
+    // build/bench so runs at different commits can be compared. Extra arguments go to bling-bench.
+    // The scale step runs it against generated fixtures of growing size (extra arguments: the scales) and fails
+    // when a collector's cost grows faster than the host.
+    int bench_step = argc > 1 && strcmp(argv[1], "bench") == 0;
+    int scale_step = argc > 1 && strcmp(argv[1], "scale") == 0;
+    if (bench_step || scale_step) {
+        Nob_File_Paths bench_objects = { 0 };
+        Nob_Procs bench_procs = { 0 };
+        if (compile_sources(collector_bench_sources, NOB_ARRAY_LEN(collector_bench_sources), cflags,
+                            NOB_ARRAY_LEN(cflags), cc, &bench_objects, &bench_procs) != 0)
+            return 1;
+        if (!nob_procs_wait(bench_procs))
+            return 1;
+
+        nob_da_append(&bench_objects, LIB_INTERNAL);
+        if (nob_needs_rebuild(BENCH_BINARY, bench_objects.items, bench_objects.count)) {
+            cmd.count = 0;
+            nob_cmd_append(&cmd, cc, "-o", BENCH_BINARY);
+            nob_da_append_many(&cmd, bench_objects.items, bench_objects.count);
+            nob_da_append_many(&cmd, instrument_ldflags, NOB_ARRAY_LEN(instrument_ldflags));
+            nob_da_append_many(&cmd, libs, NOB_ARRAY_LEN(libs));
+            nob_cmd_append(&cmd, "-lm");
+            if (!nob_cmd_run(&cmd))
+                return 1;
+        }
+
+        nob_da_free(bench_objects);
+        nob_da_free(bench_procs);
+    }
+
+    if (bench_step) {
+        cmd.count = 0;
+        nob_cmd_append(&cmd, BENCH_BINARY, "--save", BENCH_RESULTS);
+        for (int i = 2; i < argc; i++)
+            nob_cmd_append(&cmd, argv[i]);
+        if (!nob_cmd_run(&cmd))
+            return 1;
+    }
+
+    if (scale_step) {
+        const char **scales = argc > 2 ? (const char **)argv + 2 : default_scales;
+        size_t scale_count = argc > 2 ? (size_t)(argc - 2) : NOB_ARRAY_LEN(default_scales);
+        Nob_File_Paths results = { 0 };
+        if (!nob_mkdir_if_not_exists(FIXTURES))
+            return 1;
+
+        for (size_t i = 0; i < scale_count; i++) {
+            const char *fixture = nob_temp_sprintf(FIXTURES "/scale-%s", scales[i]);
+            // Trees are deterministic for a scale, and the manifest is written last: reuse complete ones
+            if (nob_file_exists(nob_temp_sprintf("%s/bling-fixture", fixture)) <= 0) {
+                cmd.count = 0;
+                nob_cmd_append(&cmd, FIXTUREGEN_BINARY, "--scale", scales[i], fixture);
+                if (!nob_cmd_run(&cmd))
+                    return 1;
+            }
+            cmd.count = 0;
+            nob_cmd_append(&cmd, BENCH_BINARY, "--root", fixture, "--save", BENCH_RESULTS);
+            if (!nob_cmd_run(&cmd))
+                return 1;
+            nob_da_append(&results, nob_temp_sprintf(BENCH_RESULTS "/latest-scale-%s.json", scales[i]));
+        }
+
+        cmd.count = 0;
+        nob_cmd_append(&cmd, BENCH_BINARY, "--save", BENCH_RESULTS, "--scaling");
+        nob_da_append_many(&cmd, results.items, results.count);
+        if (!nob_cmd_run(&cmd))
+            return 1;
+        nob_da_free(results);
+    }
+
+    // Release step: an optimized, profile-guided, link-time optimized bling in build/release, trained on the
+    // collector benchmarks and a set of report runs, live and against a generated fixture. Linked statically when
+    // the toolchain has a static libc. A unity build is not an option: sources rely on their own feature macros
+    // and static helper names.
+    if (argc > 1 && strcmp(argv[1], "release") == 0) {
+        const char *release_cflags[] = { "-Wall", "-Wextra", "-std=c99", "-O2" };
+        Nob_Cmd flags = { 0 };
+        Nob_File_Paths train_objects = { 0 };
+        Nob_File_Paths bench_train_objects = { 0 };
+        Nob_File_Paths release_objects = { 0 };
+        Nob_File_Paths profiles = { 0 };
+        Nob_Procs release_procs = { 0 };
+
+        if (!nob_mkdir_if_not_exists(RELEASE_FOLDER) || !nob_mkdir_if_not_exists(PROFILE_FOLDER) ||
+            !nob_mkdir_if_not_exists(FIXTURES))
+            return 1;
+        // Counts from an older build of the sources would not match the new objects
+        if (!nob_read_entire_dir(PROFILE_FOLDER, &profiles))
+            return 1;
+        for (size_t i = 0; i < profiles.count; ++i) {
+            if (profiles.items[i][0] != '.' &&
+                !nob_delete_file(nob_temp_sprintf(PROFILE_FOLDER "/%s", profiles.items[i])))
+                return 1;
+        }
+
+        // Stage 1: instrumented build; workers run collectors in parallel, so the counters are updated atomically
+        nob_da_append_many(&flags, release_cflags, NOB_ARRAY_LEN(release_cflags));
+        nob_cmd_append(&flags, "-fprofile-generate=" PROFILE_FOLDER, "-fprofile-update=atomic");
+        if (compile_release(lib_sources, NOB_ARRAY_LEN(lib_sources), &flags, cc, &train_objects, &release_procs) != 0 ||
+            compile_release(bin_sources, NOB_ARRAY_LEN(bin_sources), &flags, cc, &train_objects, &release_procs) != 0 ||
+            compile_release(bench_sources, NOB_ARRAY_LEN(bench_sources), &flags, cc, &train_objects,
+                            &release_procs) != 0 ||
+            compile_release(collector_bench_sources, NOB_ARRAY_LEN(collector_bench_sources), &flags, cc,
+                            &bench_train_objects, &release_procs) != 0)
+            return 1;
+        if (!nob_procs_wait(release_procs))
+            return 1;
+        release_procs.count = 0;
+
+        cmd.count = 0;
+        nob_cmd_append(&cmd, cc, "-fprofile-generate", "-o", RELEASE_FOLDER "bling-train");
+        nob_da_append_many(&cmd, train_objects.items, train_objects.count);
+        nob_da_append_many(&cmd, libs, NOB_ARRAY_LEN(libs));
+        if (!nob_cmd_run(&cmd))
+            return 1;
+        // libbling's objects are the head of train_objects, compiled before main, report, json and bench
+        cmd.count = 0;
+        nob_cmd_append(&cmd, cc, "-fprofile-generate", "-o", RELEASE_FOLDER "bling-bench-train");
+        nob_da_append_many(&cmd, bench_train_objects.items, bench_train_objects.count);
+        nob_da_append_many(&cmd, train_objects.items, NOB_ARRAY_LEN(lib_sources));
+        nob_da_append_many(&cmd, instrument_ldflags, NOB_ARRAY_LEN(instrument_ldflags));
+        nob_da_append_many(&cmd, libs, NOB_ARRAY_LEN(libs));
+        nob_cmd_append(&cmd, "-lm");
+        if (!nob_cmd_run(&cmd))
+            return 1;
+
+        // Training: every collector on this host and on the smallest scale fixture, then the report in both formats
+        if (nob_file_exists(TRAINING_FIXTURE "/bling-fixture") <= 0) {
+            cmd.count = 0;
+            nob_cmd_append(&cmd, FIXTUREGEN_BINARY, "--scale", "0.01", TRAINING_FIXTURE);
+            if (!nob_cmd_run(&cmd))
+                return 1;
+        }
+        const char *roots[] = { NULL, TRAINING_FIXTURE };
+        const char *report_args[][13] = {
+            { NULL },
+            { "--json", NULL },
+            { "--topology", "--heatmap", "--mounts", "--sockets", "--top", "--net", "--io", "--frag", "all",
+              "--thermal", "--audit", NULL },
+            { "--json", "--topology", "--heatmap", "--mounts", "--sockets", "--top", "--net", "--io", "--frag",
+              "all", "--thermal", "--audit", NULL },
+        };
+        nob_log(NOB_INFO, "Training on the collector benchmarks and report runs...");
+        for (size_t r = 0; r < NOB_ARRAY_LEN(roots); ++r) {
+            cmd.count = 0;
+            nob_cmd_append(&cmd, RELEASE_FOLDER "bling-bench-train");
+            if (roots[r] != NULL)
+                nob_cmd_append(&cmd, "--root", roots[r]);
+            if (!run_quiet(&cmd))
+                return 1;
+
+            for (size_t i = 0; i < NOB_ARRAY_LEN(report_args); ++i) {
+                cmd.count = 0;
+                nob_cmd_append(&cmd, RELEASE_FOLDER "bling-train");
+                if (roots[r] != NULL)
+                    nob_cmd_append(&cmd, "--root", roots[r]);
+                for (size_t j = 0; report_args[i][j] != NULL; ++j)
+                    nob_cmd_append(&cmd, report_args[i][j]);
+                if (!run_quiet(&cmd))
+                    return 1;
+            }
+        }
+
+        // gcc reads its per-object .gcda files from the folder; clang's raw profiles have to be merged first
+        const char *profile_use = "-fprofile-use=" PROFILE_FOLDER;
+        profiles.count = 0;
+        if (!nob_read_entire_dir(PROFILE_FOLDER, &profiles))
+            return 1;
+        cmd.count = 0;
+        nob_cmd_append(&cmd, "llvm-profdata", "merge", "-o", PROFILE_FOLDER "/default.profdata");
+        size_t raw_profiles = 0;
+        for (size_t i = 0; i < profiles.count; ++i) {
+            if (nob_sv_end_with(nob_sv_from_cstr(profiles.items[i]), ".profraw")) {
+                nob_cmd_append(&cmd, nob_temp_sprintf(PROFILE_FOLDER "/%s", profiles.items[i]));
+                raw_profiles++;
+            }
+        }
+        int clang_profile = raw_profiles > 0;
+        if (clang_profile) {
+            if (!nob_cmd_run(&cmd))
+                return 1;
+            profile_use = "-fprofile-use=" PROFILE_FOLDER "/default.profdata";
+        }
+
+        // Stage 2: the same objects, optimized with the profile and left as LTO bitcode for the link
+        flags.count = 0;
+        nob_da_append_many(&flags, release_cflags, NOB_ARRAY_LEN(release_cflags));
+        nob_cmd_append(&flags, "-flto", profile_use);
+        if (!clang_profile)
+            nob_cmd_append(&flags, "-Wno-missing-profile"); // Sources no training run reaches, e.g. ioprobe.c
+        if (compile_release(bin_sources, NOB_ARRAY_LEN(bin_sources), &flags, cc, &release_objects, &release_procs) != 0 ||
+            compile_release(bench_sources, NOB_ARRAY_LEN(bench_sources), &flags, cc, &release_objects,
+                            &release_procs) != 0 ||
+            compile_release(lib_sources, NOB_ARRAY_LEN(lib_sources), &flags, cc, &release_objects, &release_procs) != 0)
+            return 1;
+        if (!nob_procs_wait(release_procs))
+            return 1;
+
+        // A static binary skips the dynamic loader and symbol resolution at every start
+        cmd.count = 0;
+        nob_cmd_append(&cmd, cc, "-print-file-name=libc.a");
+        Nob_String_Builder libc_path = { 0 };
+        int is_static = nob_cmd_run(&cmd, .stdout_path = RELEASE_FOLDER "libc-path") &&
+                        nob_read_entire_file(RELEASE_FOLDER "libc-path", &libc_path) &&
+                        memchr(libc_path.items, '/', libc_path.count) != NULL; // Bare "libc.a" if there is none
+        nob_sb_free(libc_path);
+
+        cmd.count = 0;
+        // gcc otherwise runs the link-time code generation on one core, and warns about it
+        nob_cmd_append(&cmd, cc, "-O2", clang_profile ? "-flto" : "-flto=auto", "-s", "-o", RELEASE_BINARY);
+        if (is_static)
+            nob_cmd_append(&cmd, "-static");
+        nob_da_append_many(&cmd, release_objects.items, release_objects.count);
+        nob_da_append_many(&cmd, libs, NOB_ARRAY_LEN(libs));
+        if (!nob_cmd_run(&cmd))
+            return 1;
+
+        const char *compared[] = { binary_path, RELEASE_BINARY };
+        uint64_t median_ns[NOB_ARRAY_LEN(compared)];
+        if (!median_run_ns(compared, NOB_ARRAY_LEN(compared), median_ns))
+            return 1;
+        nob_log(NOB_INFO, "%-20s %10s %12s", "", "size", "median run");
+        nob_log(NOB_INFO, "%-20s %8lld K %9.2f ms", binary_path, file_size(binary_path) / 1024, median_ns[0] / 1e6);
+        nob_log(NOB_INFO, "%-20s %8lld K %9.2f ms  (-O2, LTO, PGO%s)", RELEASE_BINARY, file_size(RELEASE_BINARY) / 1024,
+                median_ns[1] / 1e6, is_static ? ", static" : "");
+
+        nob_cmd_free(flags);
+        nob_da_free(train_objects);
+        nob_da_free(bench_train_objects);
+        nob_da_free(release_objects);
+        nob_da_free(profiles);
+        nob_da_free(release_procs);
+    }
+
+    // Install Step: the release build when `./nob release` made one from the current sources
     if (argc > 1 && strcmp(argv[1], "install") == 0) {
+        if (nob_file_exists(RELEASE_BINARY) > 0 && !nob_needs_rebuild1(RELEASE_BINARY, binary_path))
+            binary_path = RELEASE_BINARY;
         nob_log(NOB_INFO, "Installing %s to %s...", binary_path, INSTALL_PATH);
 
         if (!nob_copy_file(binary_path, INSTALL_PATH)) {
@@ -139,7 +628,10 @@ int main(int argc, char **argv) {
 
     // Cleanup
     nob_cmd_free(cmd);
-    nob_da_free(object_files);
+    nob_da_free(lib_objects);
+    nob_da_free(bin_objects);
+    nob_da_free(fixturegen_objects);
+    nob_da_free(instrument_objects);
     nob_da_free(procs);
 
     return 0;
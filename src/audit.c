@@ -0,0 +1,401 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "audit.h"
+#include "bling.h"
+#include "file.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SYSFS_CPUFREQ "/sys/devices/system/cpu/cpufreq"
+#define SYSFS_THP "/sys/kernel/mm/transparent_hugepage"
+#define POLICY_PATH_SIZE 96
+#define ARENA_PER_FILE 128
+#define CMDLINE_SIZE 4096
+
+#define UNAVAILABLE "unavailable"
+
+enum knob {
+    KNOB_CMDLINE, // First in the batch so the long one always fits the arena
+    KNOB_THP_ENABLED,
+    KNOB_THP_DEFRAG,
+    KNOB_SWAPPINESS,
+    KNOB_DIRTY_RATIO,
+    KNOB_DIRTY_BG_RATIO,
+    KNOB_DIRTY_BYTES,
+    KNOB_DIRTY_BG_BYTES,
+    KNOB_CLOCKSOURCE,
+    KNOB_FILE_NR,
+    KNOBS
+};
+
+static const char *const knob_paths[KNOBS] = {
+    [KNOB_CMDLINE] = "/proc/cmdline",
+    [KNOB_THP_ENABLED] = SYSFS_THP "/enabled",
+    [KNOB_THP_DEFRAG] = SYSFS_THP "/defrag",
+    [KNOB_SWAPPINESS] = "/proc/sys/vm/swappiness",
+    [KNOB_DIRTY_RATIO] = "/proc/sys/vm/dirty_ratio",
+    [KNOB_DIRTY_BG_RATIO] = "/proc/sys/vm/dirty_background_ratio",
+    [KNOB_DIRTY_BYTES] = "/proc/sys/vm/dirty_bytes",
+    [KNOB_DIRTY_BG_BYTES] = "/proc/sys/vm/dirty_background_bytes",
+    [KNOB_CLOCKSOURCE] = "/sys/devices/system/clocksource/clocksource0/current_clocksource",
+    [KNOB_FILE_NR] = "/proc/sys/fs/file-nr",
+};
+
+enum rule {
+    RULE_GOVERNOR,
+    RULE_EPP,
+    RULE_THP_ENABLED,
+    RULE_THP_DEFRAG,
+    RULE_SWAPPINESS,
+    RULE_DIRTY_RATIO,
+    RULE_DIRTY_BG_RATIO,
+    RULE_ISOLCPUS,
+    RULE_NOHZ_FULL,
+    RULE_CLOCKSOURCE,
+    RULE_FILE_HANDLES,
+    RULES
+};
+
+/**
+ * @brief What each profile wants from a knob.
+ *
+ * Expectations are '|'-separated words, where "!word" matches anything else, or a
+ * comparison ("<=10", ">=20") against the number the value starts with.
+ */
+struct audit_rule {
+    const char *knob;
+    const char *expect[AUDIT_PROFILES];
+    unsigned int advisory; // Bit per profile: a miss is a suggestion (INFO), not a warning
+};
+
+// Clocksources with a vDSO fast path; hpet and acpi_pm turn every clock_gettime into a syscall
+#define VDSO_CLOCKSOURCES "tsc|kvm-clock|arch_sys_counter|hyperv_clocksource_tsc_page"
+
+static const struct audit_rule rules[RULES] = {
+    [RULE_GOVERNOR] = { "cpufreq governor", { "performance", "performance|schedutil" }, 0 },
+    [RULE_EPP] = { "energy_perf_preference", { "performance", "performance|balance_performance" }, 0 },
+    // khugepaged collapses and direct compaction show up as latency spikes
+    [RULE_THP_ENABLED] = { "thp enabled", { "madvise|never", "always|madvise" }, 0 },
+    [RULE_THP_DEFRAG] = { "thp defrag", { "defer|defer+madvise|never", "madvise|defer+madvise|defer" }, 0 },
+    [RULE_SWAPPINESS] = { "vm.swappiness", { "<=10", "<=60" }, 0 },
+    // Small dirty limits keep writeback bursts short; large ones let writes batch up
+    [RULE_DIRTY_RATIO] = { "vm.dirty_ratio", { "<=10", ">=20" }, 0 },
+    [RULE_DIRTY_BG_RATIO] = { "vm.dirty_background_ratio", { "<=5", ">=10" }, 0 },
+    // Only pays off when the latency-critical threads are pinned to the isolated CPUs
+    [RULE_ISOLCPUS] = { "isolcpus", { "!none", "none" }, 1u << AUDIT_LATENCY },
+    [RULE_NOHZ_FULL] = { "nohz_full", { "!none", "none" }, 1u << AUDIT_LATENCY },
+    [RULE_CLOCKSOURCE] = { "clocksource", { VDSO_CLOCKSOURCES, VDSO_CLOCKSOURCES }, 0 },
+    [RULE_FILE_HANDLES] = { "file handles used %", { "<80", "<80" }, 0 },
+};
+
+static const char *const profile_names[AUDIT_PROFILES] = { "latency", "throughput" };
+
+const char *audit_profile_name(enum audit_profile profile) {
+    return profile >= 0 && profile < AUDIT_PROFILES ? profile_names[profile] : "unknown";
+}
+
+int audit_parse_profile(const char *name) {
+    for (int p = 0; p < AUDIT_PROFILES; p++) {
+        if (strcmp(name, profile_names[p]) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+static int matches(const char *expect, const char *value) {
+    if (expect[0] == '<' || expect[0] == '>') {
+        int or_equal = expect[1] == '=';
+        double limit = strtod(expect + 1 + or_equal, NULL);
+        char *end;
+        double v = strtod(value, &end);
+        if (end == value) {
+            return 0;
+        }
+        if (expect[0] == '<') {
+            return or_equal ? v <= limit : v < limit;
+        }
+        return or_equal ? v >= limit : v > limit;
+    }
+
+    size_t value_len = strlen(value);
+    for (const char *alt = expect; *alt != '\0';) {
+        size_t len = strcspn(alt, "|");
+        int negate = alt[0] == '!';
+        int equal = len - negate == value_len && memcmp(alt + negate, value, value_len) == 0;
+        if (negate ? !equal : equal) {
+            return 1;
+        }
+        alt += len + (alt[len] == '|');
+    }
+    return 0;
+}
+
+static struct audit_finding *add_finding(struct audit *a, enum rule rule, const char *value) {
+    if (a->count == a->capacity) {
+        size_t capacity = a->capacity ? a->capacity * 2 : 16;
+        struct audit_finding *findings = realloc(a->findings, capacity * sizeof(*findings));
+        if (findings == NULL) {
+            return NULL;
+        }
+        a->findings = findings;
+        a->capacity = capacity;
+    }
+
+    struct audit_finding *f = &a->findings[a->count++];
+    memset(f, 0, sizeof(*f));
+    f->knob = rules[rule].knob;
+    snprintf(f->value, sizeof(f->value), "%s", value);
+    f->expected = rules[rule].expect[a->profile];
+
+    if (strcmp(value, UNAVAILABLE) == 0) {
+        f->verdict = AUDIT_INFO;
+    } else if (f->expected == NULL || matches(f->expected, value)) {
+        f->verdict = AUDIT_OK;
+    } else {
+        f->verdict = (rules[rule].advisory >> a->profile) & 1 ? AUDIT_INFO : AUDIT_WARN;
+    }
+    return f;
+}
+
+/**
+ * @brief The selected entry of a sysfs choice list ("always [madvise] never"), or the first word.
+ */
+static void selected_word(char *out, size_t size, const struct file_read *file) {
+    if (file->data == NULL) {
+        snprintf(out, size, UNAVAILABLE);
+        return;
+    }
+    const char *word = file->data;
+    const char *open = strchr(word, '[');
+    size_t len;
+    if (open != NULL && strchr(open, ']') != NULL) {
+        word = open + 1;
+        len = (size_t)(strchr(open, ']') - word);
+    } else {
+        word += strspn(word, " \t");
+        len = strcspn(word, " \t\n");
+    }
+    snprintf(out, size, "%.*s", (int)len, word);
+}
+
+/**
+ * @brief Value of a kernel parameter on the command line, "none" if absent. Parameters after "--" go to init.
+ */
+static void cmdline_param(char *out, size_t size, const char *cmdline, const char *name) {
+    size_t name_len = strlen(name);
+    snprintf(out, size, "none");
+
+    for (const char *p = cmdline; *p != '\0';) {
+        p += strspn(p, " \n");
+        size_t len = strcspn(p, " \n");
+        if (len == 2 && strncmp(p, "--", 2) == 0) {
+            return;
+        }
+        if (len > name_len && strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            snprintf(out, size, "%.*s", (int)(len - name_len - 1), p + name_len + 1);
+        } else if (len == name_len && strncmp(p, name, name_len) == 0) {
+            snprintf(out, size, "set");
+        }
+        p += len;
+    }
+}
+
+/**
+ * @brief Adds one finding per distinct value of a per-policy knob, with how many policies share it.
+ */
+static int add_policy_findings(struct audit *a, enum rule rule, const struct file_read *files, size_t count) {
+    size_t first = a->count;
+    for (size_t i = 0; i < count; i++) {
+        char value[AUDIT_VALUE_SIZE];
+        selected_word(value, sizeof(value), &files[i]);
+
+        struct audit_finding *f = NULL;
+        for (size_t j = first; j < a->count && f == NULL; j++) {
+            if (strcmp(a->findings[j].value, value) == 0) {
+                f = &a->findings[j];
+            }
+        }
+        if (f == NULL && (f = add_finding(a, rule, value)) == NULL) {
+            return BLING_ERR_NOMEM;
+        }
+        f->policies++;
+    }
+
+    if (count == 0 && add_finding(a, rule, UNAVAILABLE) == NULL) {
+        return BLING_ERR_NOMEM; // No cpufreq driver, as in most VMs
+    }
+    return BLING_OK;
+}
+
+static int add_ratio_finding(struct audit *a, enum rule rule, const struct file_read *ratio,
+                             const struct file_read *bytes) {
+    char value[AUDIT_VALUE_SIZE];
+    unsigned long long limit_bytes = bytes->data != NULL ? strtoull(bytes->data, NULL, 10) : 0;
+
+    if (limit_bytes > 0) {
+        // Setting the _bytes knob zeroes the ratio, which then says nothing
+        snprintf(value, sizeof(value), "%llu bytes", limit_bytes);
+        struct audit_finding *f = add_finding(a, rule, value);
+        if (f == NULL) {
+            return BLING_ERR_NOMEM;
+        }
+        f->verdict = AUDIT_INFO;
+        return BLING_OK;
+    }
+
+    selected_word(value, sizeof(value), ratio);
+    return add_finding(a, rule, value) != NULL ? BLING_OK : BLING_ERR_NOMEM;
+}
+
+/**
+ * @brief Lists cpufreq policy directories as governor/EPP path pairs.
+ */
+static size_t list_policies(char **paths_out) {
+    *paths_out = NULL;
+    DIR *dir = file_opendir(SYSFS_CPUFREQ);
+    if (dir == NULL) {
+        return 0;
+    }
+
+    char *paths = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "policy", 6) != 0) {
+            continue;
+        }
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 16;
+            char *temp = realloc(paths, grown * 2 * POLICY_PATH_SIZE);
+            if (temp == NULL) {
+                break;
+            }
+            paths = temp;
+            capacity = grown;
+        }
+        char *governor = paths + count * 2 * POLICY_PATH_SIZE;
+        snprintf(governor, POLICY_PATH_SIZE, SYSFS_CPUFREQ "/%.32s/scaling_governor", entry->d_name);
+        snprintf(governor + POLICY_PATH_SIZE, POLICY_PATH_SIZE, SYSFS_CPUFREQ "/%.32s/energy_performance_preference",
+                 entry->d_name);
+        count++;
+    }
+    closedir(dir);
+
+    *paths_out = paths;
+    return count;
+}
+
+static long long monotonic_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int audit_run(struct audit *a, enum audit_profile profile) {
+    long long start = monotonic_us();
+    a->profile = profile;
+    a->count = 0;
+
+    char *policy_paths;
+    size_t policies = list_policies(&policy_paths);
+
+    // Fixed knobs first, then governor and EPP for each policy, all in one batch
+    size_t file_count = KNOBS + policies * 2;
+    size_t arena_size = file_count * ARENA_PER_FILE + CMDLINE_SIZE;
+    struct file_read *files = calloc(file_count, sizeof(*files));
+    char *arena = malloc(arena_size);
+    if (files == NULL || arena == NULL) {
+        free(files);
+        free(arena);
+        free(policy_paths);
+        return BLING_ERR_NOMEM;
+    }
+
+    for (int k = 0; k < KNOBS; k++) {
+        files[k].path = knob_paths[k];
+    }
+    struct file_read *governors = files + KNOBS;
+    struct file_read *epps = governors + policies;
+    for (size_t p = 0; p < policies; p++) {
+        governors[p].path = policy_paths + p * 2 * POLICY_PATH_SIZE;
+        epps[p].path = policy_paths + p * 2 * POLICY_PATH_SIZE + POLICY_PATH_SIZE;
+    }
+
+    read_files(files, file_count, arena, arena_size);
+
+    const struct file_read *knobs = files;
+    char value[AUDIT_VALUE_SIZE];
+    int status = add_policy_findings(a, RULE_GOVERNOR, governors, policies);
+    if (status == BLING_OK) {
+        status = add_policy_findings(a, RULE_EPP, epps, policies);
+    }
+
+    static const struct {
+        enum rule rule;
+        enum knob knob;
+    } words[] = {
+        { RULE_THP_ENABLED, KNOB_THP_ENABLED },
+        { RULE_THP_DEFRAG, KNOB_THP_DEFRAG },
+        { RULE_SWAPPINESS, KNOB_SWAPPINESS },
+    };
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]) && status == BLING_OK; i++) {
+        selected_word(value, sizeof(value), &knobs[words[i].knob]);
+        status = add_finding(a, words[i].rule, value) != NULL ? BLING_OK : BLING_ERR_NOMEM;
+    }
+
+    if (status == BLING_OK) {
+        status = add_ratio_finding(a, RULE_DIRTY_RATIO, &knobs[KNOB_DIRTY_RATIO], &knobs[KNOB_DIRTY_BYTES]);
+    }
+    if (status == BLING_OK) {
+        status = add_ratio_finding(a, RULE_DIRTY_BG_RATIO, &knobs[KNOB_DIRTY_BG_RATIO], &knobs[KNOB_DIRTY_BG_BYTES]);
+    }
+
+    const char *cmdline = knobs[KNOB_CMDLINE].data;
+    static const enum rule params[] = { RULE_ISOLCPUS, RULE_NOHZ_FULL };
+    for (size_t i = 0; i < sizeof(params) / sizeof(params[0]) && status == BLING_OK; i++) {
+        if (cmdline != NULL) {
+            cmdline_param(value, sizeof(value), cmdline, rules[params[i]].knob);
+        } else {
+            snprintf(value, sizeof(value), UNAVAILABLE);
+        }
+        status = add_finding(a, params[i], value) != NULL ? BLING_OK : BLING_ERR_NOMEM;
+    }
+
+    if (status == BLING_OK) {
+        selected_word(value, sizeof(value), &knobs[KNOB_CLOCKSOURCE]);
+        status = add_finding(a, RULE_CLOCKSOURCE, value) != NULL ? BLING_OK : BLING_ERR_NOMEM;
+    }
+
+    if (status == BLING_OK) {
+        // "allocated unused max"; unused is always 0 since 2.6
+        unsigned long long allocated = 0, unused = 0, max = 0;
+        if (knobs[KNOB_FILE_NR].data != NULL &&
+            sscanf(knobs[KNOB_FILE_NR].data, "%llu %llu %llu", &allocated, &unused, &max) == 3 && max > 0) {
+            snprintf(value, sizeof(value), "%.0f (%llu of %llu)", (double)allocated * 100.0 / (double)max, allocated,
+                     max);
+        } else {
+            snprintf(value, sizeof(value), UNAVAILABLE);
+        }
+        status = add_finding(a, RULE_FILE_HANDLES, value) != NULL ? BLING_OK : BLING_ERR_NOMEM;
+    }
+
+    free(files);
+    free(arena);
+    free(policy_paths);
+
+    a->elapsed_us = monotonic_us() - start;
+    return status;
+}
+
+void audit_free(struct audit *a) {
+    free(a->findings);
+    memset(a, 0, sizeof(*a));
+}
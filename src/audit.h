@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef AUDIT_H
+#define AUDIT_H
+
+#include <stddef.h>
+
+enum audit_profile {
+    AUDIT_LATENCY,
+    AUDIT_THROUGHPUT,
+    AUDIT_PROFILES
+};
+
+enum audit_verdict {
+    AUDIT_OK,
+    AUDIT_WARN, // The profile wants something else
+    AUDIT_INFO, // Unavailable, overridden, or only a suggestion for this profile
+};
+
+#define AUDIT_VALUE_SIZE 64
+
+struct audit_finding {
+    const char *knob; // "cpufreq governor", "vm.swappiness"
+    char value[AUDIT_VALUE_SIZE];
+    int policies;         // For per-policy cpufreq knobs, how many policies have this value; 0 otherwise
+    const char *expected; // What the profile wants ("performance|schedutil", "<=10"), NULL if no opinion
+    enum audit_verdict verdict;
+};
+
+/**
+ * @brief Kernel tuning knobs checked against a latency or throughput profile.
+ */
+struct audit {
+    enum audit_profile profile;
+    struct audit_finding *findings;
+    size_t count;
+    size_t capacity;
+    long long elapsed_us; // Wall time of audit_run, all reads included
+};
+
+/**
+ * @brief Reads every knob in one read_files() batch and judges it. Zero-initialize the struct first.
+ */
+int audit_run(struct audit *a, enum audit_profile profile);
+
+/**
+ * @brief "latency" or "throughput".
+ */
+const char *audit_profile_name(enum audit_profile profile);
+
+/**
+ * @brief Inverse of audit_profile_name, -1 for unknown names.
+ */
+int audit_parse_profile(const char *name);
+
+void audit_free(struct audit *a);
+
+#endif // AUDIT_H
@@ -0,0 +1,486 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _GNU_SOURCE // sched_setaffinity(), CPU_ALLOC(), syscall()
+
+#include "bench.h"
+#include "bling.h"
+#include "file.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SYSFS_NODE "/sys/devices/system/node"
+#define MAX_TEAM 256
+#define CACHE_LINE 64
+
+// Time budgets, about 1.1 s of measuring plus the setup of the larger buffers
+#define STREAM_BUDGET_NS 400000000LL // Shared by all nodes
+#define STREAM_MIN_NS 10000000LL
+#define LATENCY_BUDGET_NS 60000000LL // Per level
+#define COMPUTE_BUDGET_NS 80000000LL
+#define SYSCALL_BUDGET_NS 50000000LL
+
+#define STREAM_ARRAY_BYTES (32u << 20) // Per array and node, well past the LLC of most parts
+#define CHASE_MAX_CACHE (16u << 20) // Bigger chains cost more to build than to walk
+#define DRAM_MIN_BYTES (64u << 20)
+#define DRAM_MAX_BYTES (128u << 20)
+#define CHASE_BATCH 65536
+#define COMPUTE_BATCH 4096
+#define CALL_BATCH 1024
+
+// Defeats dead-code elimination of results without adding work to the loops
+static volatile uint64_t sink_u64;
+static volatile double sink_double;
+static void *volatile sink_ptr;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+struct member;
+
+/**
+ * @brief A group of pinned threads running one kernel for a fixed time, started together.
+ */
+struct team {
+    int (*setup)(struct member *m);   // Optional, on the pinned thread before the start (first touch)
+    double (*batch)(struct member *m); // One short run of the kernel, returns the work done
+    long long budget_ns;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int ready;
+    int go;
+};
+
+struct member {
+    struct team *team;
+    pthread_t thread;
+    int cpu;
+    int ok; // setup succeeded
+
+    double work;
+    long long elapsed_ns;
+
+    // Kernel state
+    double *a, *b, *c;
+    size_t n;
+    void *chase;
+    void *buf;
+};
+
+static void pin_to(int cpu) {
+    cpu_set_t *set = CPU_ALLOC(MAX_CPUS);
+    if (set == NULL) {
+        return;
+    }
+    size_t size = CPU_ALLOC_SIZE(MAX_CPUS);
+    CPU_ZERO_S(size, set);
+    CPU_SET_S((size_t)cpu, size, set);
+    sched_setaffinity(0, size, set);
+    CPU_FREE(set);
+}
+
+static void *member_main(void *arg) {
+    struct member *m = arg;
+    struct team *team = m->team;
+
+    pin_to(m->cpu);
+    m->ok = team->setup == NULL || team->setup(m) == BLING_OK;
+
+    pthread_mutex_lock(&team->lock);
+    team->ready++;
+    pthread_cond_broadcast(&team->cond);
+    while (!team->go) {
+        pthread_cond_wait(&team->cond, &team->lock);
+    }
+    pthread_mutex_unlock(&team->lock);
+
+    if (!m->ok) {
+        return NULL;
+    }
+    long long start = now_ns();
+    long long end = start + team->budget_ns;
+    long long t;
+    do {
+        m->work += team->batch(m);
+        t = now_ns();
+    } while (t < end);
+    m->elapsed_ns = t - start;
+    return NULL;
+}
+
+/**
+ * @brief Runs the team's kernel on one thread per member and returns total work per second.
+ */
+static double run_team(struct team *team, struct member *members, int count) {
+    pthread_mutex_init(&team->lock, NULL);
+    pthread_cond_init(&team->cond, NULL);
+    team->ready = 0;
+    team->go = 0;
+
+    int started = 0;
+    for (; started < count; started++) {
+        members[started].team = team;
+        if (pthread_create(&members[started].thread, NULL, member_main, &members[started]) != 0) {
+            break;
+        }
+    }
+
+    // Everyone finishes setup (page faults, chain building) before anyone starts the clock
+    pthread_mutex_lock(&team->lock);
+    while (team->ready < started) {
+        pthread_cond_wait(&team->cond, &team->lock);
+    }
+    team->go = 1;
+    pthread_cond_broadcast(&team->cond);
+    pthread_mutex_unlock(&team->lock);
+
+    double work = 0.0;
+    long long elapsed = 0;
+    for (int i = 0; i < started; i++) {
+        pthread_join(members[i].thread, NULL);
+        if (members[i].ok) {
+            work += members[i].work;
+            elapsed = members[i].elapsed_ns > elapsed ? members[i].elapsed_ns : elapsed;
+        }
+    }
+
+    pthread_cond_destroy(&team->cond);
+    pthread_mutex_destroy(&team->lock);
+    return elapsed > 0 ? work * 1e9 / (double)elapsed : 0.0;
+}
+
+static int stream_setup(struct member *m) {
+    // First touch from the pinned thread places the pages on its node
+    for (size_t i = 0; i < m->n; i++) {
+        m->a[i] = 0.0;
+        m->b[i] = 1.0;
+        m->c[i] = 2.0;
+    }
+    return BLING_OK;
+}
+
+static double stream_triad(struct member *m) {
+    double *restrict a = m->a;
+    const double *restrict b = m->b;
+    const double *restrict c = m->c;
+    const double scalar = 3.0;
+    for (size_t i = 0; i < m->n; i++) {
+        a[i] = b[i] + scalar * c[i];
+    }
+    sink_double = a[m->n / 2];
+    return 3.0 * sizeof(double) * (double)m->n;
+}
+
+static double int_batch(struct member *m) {
+    (void)m;
+    // Eight independent chains keep every multiplier port busy
+    uint64_t x0 = 1, x1 = 2, x2 = 3, x3 = 4, x4 = 5, x5 = 6, x6 = 7, x7 = 8;
+    const uint64_t k = 6364136223846793005ull;
+    for (int i = 0; i < COMPUTE_BATCH; i++) {
+        x0 = x0 * k + 1;
+        x1 = x1 * k + 1;
+        x2 = x2 * k + 1;
+        x3 = x3 * k + 1;
+        x4 = x4 * k + 1;
+        x5 = x5 * k + 1;
+        x6 = x6 * k + 1;
+        x7 = x7 * k + 1;
+    }
+    sink_u64 = x0 ^ x1 ^ x2 ^ x3 ^ x4 ^ x5 ^ x6 ^ x7;
+    return 16.0 * COMPUTE_BATCH;
+}
+
+static double fp_batch(struct member *m) {
+    (void)m;
+    double x0 = 1.0, x1 = 1.1, x2 = 1.2, x3 = 1.3, x4 = 1.4, x5 = 1.5, x6 = 1.6, x7 = 1.7;
+    const double mul = 0.9999999, add = 1e-7; // Converges to 1, never overflows or goes subnormal
+    for (int i = 0; i < COMPUTE_BATCH; i++) {
+        x0 = x0 * mul + add;
+        x1 = x1 * mul + add;
+        x2 = x2 * mul + add;
+        x3 = x3 * mul + add;
+        x4 = x4 * mul + add;
+        x5 = x5 * mul + add;
+        x6 = x6 * mul + add;
+        x7 = x7 * mul + add;
+    }
+    sink_double = x0 + x1 + x2 + x3 + x4 + x5 + x6 + x7;
+    return 16.0 * COMPUTE_BATCH;
+}
+
+/**
+ * @brief Links every cache line of the buffer into one random cycle (Sattolo's shuffle), so each
+ * load depends on the previous one and the prefetchers cannot guess the next address.
+ */
+static int chase_setup(struct member *m) {
+    size_t lines = m->n / CACHE_LINE;
+    if (lines < 16) {
+        lines = 16;
+    }
+    if (posix_memalign(&m->buf, CACHE_LINE, lines * CACHE_LINE) != 0) {
+        m->buf = NULL;
+        return BLING_ERR_NOMEM;
+    }
+    size_t *order = malloc(lines * sizeof(*order));
+    if (order == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+
+    for (size_t i = 0; i < lines; i++) {
+        order[i] = i;
+    }
+    uint64_t state = 0x9e3779b97f4a7c15ull;
+    for (size_t i = lines - 1; i > 0; i--) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        size_t j = (size_t)(state % i);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    char *base = m->buf;
+    for (size_t i = 0; i < lines; i++) {
+        *(void **)(base + order[i] * CACHE_LINE) = base + order[(i + 1) % lines] * CACHE_LINE;
+    }
+    free(order);
+
+    // One lap to warm the caches and TLB
+    void *p = base;
+    for (size_t i = 0; i < lines; i++) {
+        p = *(void **)p;
+    }
+    m->chase = p;
+    return BLING_OK;
+}
+
+static double chase_batch(struct member *m) {
+    void *p = m->chase;
+    for (int i = 0; i < CHASE_BATCH; i++) {
+        p = *(void **)p;
+    }
+    m->chase = p;
+    sink_ptr = p;
+    return CHASE_BATCH;
+}
+
+static double syscall_batch(struct member *m) {
+    (void)m;
+    for (int i = 0; i < CALL_BATCH; i++) {
+        sink_u64 = (uint64_t)syscall(SYS_getppid);
+    }
+    return CALL_BATCH;
+}
+
+static double vdso_batch(struct member *m) {
+    (void)m;
+    struct timespec ts;
+    for (int i = 0; i < CALL_BATCH; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        sink_u64 = (uint64_t)ts.tv_nsec;
+    }
+    return CALL_BATCH;
+}
+
+/**
+ * @brief CPUs this process may run on, the ones every team is built from.
+ */
+static int allowed_cpus(struct cpuset *allowed) {
+    memset(allowed, 0, sizeof(*allowed));
+    cpu_set_t *set = CPU_ALLOC(MAX_CPUS);
+    if (set == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+    size_t size = CPU_ALLOC_SIZE(MAX_CPUS);
+    int status = sched_getaffinity(0, size, set) == 0 ? BLING_OK : BLING_ERR_IO;
+    for (int cpu = 0; status == BLING_OK && cpu < MAX_CPUS; cpu++) {
+        if (CPU_ISSET_S((size_t)cpu, size, set)) {
+            cpuset_set(allowed, cpu);
+        }
+    }
+    CPU_FREE(set);
+    return status;
+}
+
+/**
+ * @brief Fills members with one CPU each from set, up to MAX_TEAM.
+ */
+static int team_from(struct member *members, const struct cpuset *set) {
+    int count = 0;
+    for (int cpu = cpuset_next(set, 0); cpu >= 0 && count < MAX_TEAM; cpu = cpuset_next(set, cpu + 1)) {
+        memset(&members[count], 0, sizeof(members[count]));
+        members[count++].cpu = cpu;
+    }
+    return count;
+}
+
+static double run_single(struct member *members, int cpu, struct team *team) {
+    memset(&members[0], 0, sizeof(members[0]));
+    members[0].cpu = cpu;
+    return run_team(team, members, 1);
+}
+
+static void bench_stream(struct bench *b, const struct topology *topo, const struct cpuset *allowed,
+                         struct member *members, struct cpuset *node_cpus) {
+    int nodes = topo != NULL && topo->node_count > 0 ? topo->node_count : 1;
+    if (nodes > BENCH_MAX_NODES) {
+        nodes = BENCH_MAX_NODES;
+    }
+    long long budget = STREAM_BUDGET_NS / nodes > STREAM_MIN_NS ? STREAM_BUDGET_NS / nodes : STREAM_MIN_NS;
+
+    size_t total = STREAM_ARRAY_BYTES / sizeof(double);
+    for (int n = 0; n < nodes; n++) {
+        int id = topo != NULL && topo->node_count > 0 ? topo->nodes[n].id : -1;
+        *node_cpus = *allowed;
+        if (id >= 0) {
+            char path[96];
+            char list[1024];
+            snprintf(path, sizeof(path), SYSFS_NODE "/node%d/cpulist", id);
+            struct cpuset cpus;
+            if (read_file(path, list, sizeof(list)) <= 0 || cpuset_parse_list(&cpus, list) != BLING_OK) {
+                continue;
+            }
+            for (size_t w = 0; w < MAX_CPUS / 64; w++) {
+                node_cpus->bits[w] &= cpus.bits[w];
+            }
+        }
+
+        int count = team_from(members, node_cpus);
+        if (count == 0) {
+            continue; // Memory-only node, or none of its CPUs are ours
+        }
+
+        // Fresh arrays per node: large allocations are new mappings, so first touch places them
+        double *a = malloc(STREAM_ARRAY_BYTES);
+        double *bb = malloc(STREAM_ARRAY_BYTES);
+        double *c = malloc(STREAM_ARRAY_BYTES);
+        if (a != NULL && bb != NULL && c != NULL) {
+            size_t slice = total / (size_t)count;
+            for (int i = 0; i < count; i++) {
+                members[i].a = a + (size_t)i * slice;
+                members[i].b = bb + (size_t)i * slice;
+                members[i].c = c + (size_t)i * slice;
+                members[i].n = slice;
+            }
+
+            struct team team = { .setup = stream_setup, .batch = stream_triad, .budget_ns = budget };
+            struct bench_stream *s = &b->stream[b->stream_count++];
+            s->node = id < 0 ? 0 : id;
+            s->threads = count;
+            s->gbps = run_team(&team, members, count) / 1e9;
+        }
+        free(a);
+        free(bb);
+        free(c);
+    }
+}
+
+static size_t cache_bytes(const struct topology *topo, int level, size_t fallback) {
+    if (topo != NULL) {
+        for (int i = 0; i < topo->cache_count; i++) {
+            const struct cache_info *ci = &topo->caches[i];
+            if (ci->level == level && ci->type != 'I' && ci->size_kb > 0) {
+                return (size_t)ci->size_kb * 1024;
+            }
+        }
+    }
+    return fallback;
+}
+
+static void bench_latency(struct bench *b, const struct topology *topo, struct member *members, int cpu) {
+    size_t l1 = cache_bytes(topo, 1, 32 << 10);
+    size_t l2 = cache_bytes(topo, 2, 1 << 20);
+    size_t l3 = cache_bytes(topo, 3, 0);
+    size_t llc = l3 > 0 ? l3 : l2;
+    size_t dram = llc * 4 > DRAM_MIN_BYTES ? llc * 4 : DRAM_MIN_BYTES;
+    if (dram > DRAM_MAX_BYTES) {
+        dram = DRAM_MAX_BYTES;
+    }
+    // Half of each level, so the chain fits with room for the code and stack. Guests often see
+    // the L3 of a whole socket or several CCXs as one cache, far more than a core can reach quickly
+    l3 /= 2;
+    if (l3 > CHASE_MAX_CACHE) {
+        l3 = CHASE_MAX_CACHE;
+    }
+
+    const struct {
+        const char *label;
+        size_t bytes;
+    } levels[BENCH_MAX_LEVELS] = { { "L1d", l1 / 2 }, { "L2", l2 / 2 }, { "L3", l3 }, { "DRAM", dram } };
+
+    for (int i = 0; i < BENCH_MAX_LEVELS; i++) {
+        if (levels[i].bytes == 0) {
+            continue; // No L3
+        }
+        struct team team = { .setup = chase_setup, .batch = chase_batch, .budget_ns = LATENCY_BUDGET_NS };
+        memset(&members[0], 0, sizeof(members[0]));
+        members[0].cpu = cpu;
+        members[0].n = levels[i].bytes;
+        double loads_per_s = run_team(&team, members, 1);
+        free(members[0].buf);
+
+        if (loads_per_s > 0.0) {
+            struct bench_latency *l = &b->latency[b->latency_count++];
+            snprintf(l->label, sizeof(l->label), "%s", levels[i].label);
+            l->bytes = levels[i].bytes;
+            l->ns = 1e9 / loads_per_s;
+        }
+    }
+}
+
+int bench_run(struct bench *b, const struct topology *topo) {
+    memset(b, 0, sizeof(*b));
+    long long start = now_ns();
+
+    struct cpuset *sets = malloc(2 * sizeof(*sets));
+    struct member *members = malloc(MAX_TEAM * sizeof(*members));
+    if (sets == NULL || members == NULL) {
+        free(sets);
+        free(members);
+        return BLING_ERR_NOMEM;
+    }
+    struct cpuset *allowed = &sets[0];
+    int status = allowed_cpus(allowed);
+    int first = cpuset_next(allowed, 0);
+    if (status == BLING_OK && first < 0) {
+        status = BLING_ERR_NOTFOUND;
+    }
+
+    if (status == BLING_OK) {
+        bench_stream(b, topo, allowed, members, &sets[1]);
+        bench_latency(b, topo, members, first);
+
+        struct team int_team = { .batch = int_batch, .budget_ns = COMPUTE_BUDGET_NS };
+        struct team fp_team = { .batch = fp_batch, .budget_ns = COMPUTE_BUDGET_NS };
+        b->int_single = run_single(members, first, &int_team) / 1e9;
+        b->fp_single = run_single(members, first, &fp_team) / 1e9;
+        b->threads = team_from(members, allowed);
+        b->int_all = run_team(&int_team, members, b->threads) / 1e9;
+        team_from(members, allowed);
+        b->fp_all = run_team(&fp_team, members, b->threads) / 1e9;
+
+        struct team syscall_team = { .batch = syscall_batch, .budget_ns = SYSCALL_BUDGET_NS };
+        struct team vdso_team = { .batch = vdso_batch, .budget_ns = SYSCALL_BUDGET_NS };
+        double calls = run_single(members, first, &syscall_team);
+        b->syscall_ns = calls > 0.0 ? 1e9 / calls : 0.0;
+        calls = run_single(members, first, &vdso_team);
+        b->vdso_ns = calls > 0.0 ? 1e9 / calls : 0.0;
+    }
+
+    free(members);
+    free(sets);
+    b->elapsed_ms = (now_ns() - start) / 1000000;
+    return status;
+}
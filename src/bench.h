@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "topology.h"
+
+#define BENCH_MAX_NODES 64
+#define BENCH_MAX_LEVELS 4 // L1d, L2, L3, DRAM
+
+struct bench_stream {
+    int node;
+    int threads;
+    double gbps; // STREAM triad, 24 bytes counted per element as STREAM does
+};
+
+struct bench_latency {
+    char label[8]; // "L1d", "L2", "L3", "DRAM"
+    size_t bytes;  // Working set of the chase
+    double ns;     // Per dependent load
+};
+
+/**
+ * @brief A quick host performance fingerprint: memory bandwidth, load latency, compute and syscall cost.
+ */
+struct bench {
+    struct bench_stream stream[BENCH_MAX_NODES];
+    int stream_count;
+
+    struct bench_latency latency[BENCH_MAX_LEVELS];
+    int latency_count;
+
+    int threads;      // CPUs used for the all-core runs
+    double int_single; // 64-bit multiply-adds, Gop/s
+    double int_all;
+    double fp_single; // Double precision, GFLOP/s
+    double fp_all;
+
+    double syscall_ns; // getppid(), which glibc does not cache
+    double vdso_ns;    // clock_gettime(CLOCK_MONOTONIC)
+
+    long long elapsed_ms;
+};
+
+/**
+ * @brief Runs the fixed-duration suite, well under two seconds, with every thread pinned.
+ *
+ * Only CPUs in the process's affinity mask are used, so the numbers describe what this
+ * process can get under taskset or a cgroup cpuset.
+ *
+ * @param topo Cache sizes and NUMA nodes; NULL falls back to one node and typical cache sizes.
+ */
+int bench_run(struct bench *b, const struct topology *topo);
+
+#endif // BENCH_H
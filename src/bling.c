@@ -0,0 +1,540 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "bling.h"
+#include "instrument.h"
+#include "system.h"
+#include "trace.h"
+#include "worker.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Only instrumented binaries link instrument.c; everywhere else this resolves to NULL and counts are -1
+__attribute__((weak)) void instrument_read_thread(struct instrument_counts *out);
+
+#define FIELD_COUNT 7
+
+// Everything a snapshot can hold; one member per enum bling_field bit
+struct bling_data {
+    char *hostname;
+    struct os os;
+    char *kernel;
+    struct mem mem;
+    struct disk disk;
+    struct cpu cpu;
+    struct uptime uptime;
+};
+
+struct bling_snapshot {
+    unsigned int valid;
+    int status[FIELD_COUNT];
+    long ttl_ms[FIELD_COUNT];
+    long long collected_ms[FIELD_COUNT]; // Monotonic time of the last attempt
+    long deadline_ms[FIELD_COUNT];
+    struct worker *quarantined[FIELD_COUNT]; // Timed-out workers that may still be running
+    struct bling_timing timing[FIELD_COUNT];
+    unsigned int timed; // Fields with a completed, timed collection
+    struct bling_data data;
+};
+
+// A single collector run; owned by its worker once handed over
+struct field_job {
+    unsigned int field;
+    struct bling_timing timing;
+    struct bling_data data;
+};
+
+// Indexed like the enum bling_field bits
+static const long default_ttl_ms[FIELD_COUNT] = {
+    60 * 1000,        // hostname
+    BLING_TTL_NEVER,  // os
+    BLING_TTL_NEVER,  // kernel
+    BLING_TTL_ALWAYS, // mem
+    30 * 1000,        // disk
+    BLING_TTL_NEVER,  // cpu
+    BLING_TTL_ALWAYS, // uptime
+};
+
+// Trace span names, indexed like the enum bling_field bits
+static const char *const field_span[FIELD_COUNT] = {
+    "collect hostname", "collect os", "collect kernel", "collect mem", "collect disk", "collect cpu", "collect uptime",
+};
+
+static int field_index(unsigned int field) {
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (field == 1u << i) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Runs the collector for one field, writing only that field of *d.
+ */
+static int collect_field(struct bling_data *d, unsigned int field) {
+    switch (field) {
+    case BLING_FIELD_HOSTNAME:
+        return get_hostname(&d->hostname);
+    case BLING_FIELD_OS:
+        return get_os(&d->os);
+    case BLING_FIELD_KERNEL:
+        return get_kernel(&d->kernel);
+    case BLING_FIELD_MEM:
+        return get_meminfo(&d->mem);
+    case BLING_FIELD_DISK:
+        return get_diskinfo(&d->disk);
+    case BLING_FIELD_CPU:
+        return get_cpu(&d->cpu);
+    case BLING_FIELD_UPTIME:
+        return get_uptime(&d->uptime);
+    default:
+        return BLING_ERR_INVAL;
+    }
+}
+
+/**
+ * @brief Frees whatever one field of *d owns and clears it.
+ */
+static void release_field(struct bling_data *d, unsigned int field) {
+    switch (field) {
+    case BLING_FIELD_HOSTNAME:
+        free(d->hostname);
+        d->hostname = NULL;
+        break;
+    case BLING_FIELD_OS:
+        free(d->os.name);
+        free(d->os.version);
+        free(d->os.build_id);
+        d->os = (struct os){ 0 };
+        break;
+    case BLING_FIELD_KERNEL:
+        free(d->kernel);
+        d->kernel = NULL;
+        break;
+    case BLING_FIELD_CPU:
+        free(d->cpu.name);
+        d->cpu = (struct cpu){ 0 };
+        break;
+    default:
+        break;
+    }
+}
+
+static int str_equal(const char *a, const char *b) {
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    return strcmp(a, b) == 0;
+}
+
+/**
+ * @brief Returns non-zero if one field holds the same value in a and b.
+ */
+static int field_equal(const struct bling_data *a, const struct bling_data *b, unsigned int field) {
+    switch (field) {
+    case BLING_FIELD_HOSTNAME:
+        return str_equal(a->hostname, b->hostname);
+    case BLING_FIELD_OS:
+        return str_equal(a->os.name, b->os.name) && str_equal(a->os.version, b->os.version) &&
+               str_equal(a->os.build_id, b->os.build_id);
+    case BLING_FIELD_KERNEL:
+        return str_equal(a->kernel, b->kernel);
+    case BLING_FIELD_MEM:
+        return a->mem.max_memory == b->mem.max_memory && a->mem.used_memory == b->mem.used_memory;
+    case BLING_FIELD_DISK:
+        return a->disk.total_memory_gb == b->disk.total_memory_gb && a->disk.used_memory_gb == b->disk.used_memory_gb;
+    case BLING_FIELD_CPU:
+        return str_equal(a->cpu.name, b->cpu.name) && a->cpu.cores == b->cpu.cores &&
+               a->cpu.base_frequency == b->cpu.base_frequency;
+    case BLING_FIELD_UPTIME:
+        return a->uptime.total_seconds == b->uptime.total_seconds;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Moves one field from src into dst, releasing what dst held. src gives up ownership.
+ */
+static void move_field(struct bling_data *dst, struct bling_data *src, unsigned int field) {
+    release_field(dst, field);
+
+    switch (field) {
+    case BLING_FIELD_HOSTNAME:
+        dst->hostname = src->hostname;
+        src->hostname = NULL;
+        break;
+    case BLING_FIELD_OS:
+        dst->os = src->os;
+        src->os = (struct os){ 0 };
+        break;
+    case BLING_FIELD_KERNEL:
+        dst->kernel = src->kernel;
+        src->kernel = NULL;
+        break;
+    case BLING_FIELD_MEM:
+        dst->mem = src->mem;
+        break;
+    case BLING_FIELD_DISK:
+        dst->disk = src->disk;
+        break;
+    case BLING_FIELD_CPU:
+        dst->cpu = src->cpu;
+        src->cpu = (struct cpu){ 0 };
+        break;
+    case BLING_FIELD_UPTIME:
+        dst->uptime = src->uptime;
+        break;
+    default:
+        break;
+    }
+}
+
+static long long clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Runs the job's collector, measuring it on whichever thread runs it.
+ */
+static int field_job_run(void *arg) {
+    struct field_job *job = arg;
+    struct instrument_counts before = { 0 };
+    struct instrument_counts after = { 0 };
+
+    if (instrument_read_thread != NULL) {
+        instrument_read_thread(&before);
+    }
+    long long wall = clock_ns(CLOCK_MONOTONIC);
+    long long cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+
+    TRACE_BEGIN(field_span[field_index(job->field)], NULL);
+    int status = collect_field(&job->data, job->field);
+    TRACE_END(field_span[field_index(job->field)]);
+
+    job->timing.cpu_ns = clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu;
+    job->timing.wall_ns = clock_ns(CLOCK_MONOTONIC) - wall;
+    if (instrument_read_thread != NULL) {
+        instrument_read_thread(&after);
+        job->timing.opens = (long long)(after.opens - before.opens);
+        job->timing.bytes_read = (long long)(after.read_bytes - before.read_bytes);
+        job->timing.allocs = (long long)(after.allocs - before.allocs);
+    } else {
+        job->timing.opens = job->timing.bytes_read = job->timing.allocs = -1;
+    }
+    return status;
+}
+
+static void field_job_discard(void *arg) {
+    struct field_job *job = arg;
+    release_field(&job->data, job->field);
+    free(job);
+}
+
+/**
+ * @brief Stores the outcome of one collector run in the snapshot, taking job's data on success.
+ */
+static void apply_field(bling_snapshot *snap, int i, int status, struct field_job *job, unsigned int *changed) {
+    unsigned int field = 1u << i;
+
+    snap->timing[i] = job->timing;
+    snap->timed |= field;
+    if (status == BLING_OK) {
+        if (!(snap->valid & field) || !field_equal(&snap->data, &job->data, field)) {
+            *changed |= field;
+        }
+        move_field(&snap->data, &job->data, field);
+        snap->valid |= field;
+    }
+    snap->status[i] = status;
+}
+
+/**
+ * @brief Collects the fields in the mask, recording which ones changed value.
+ *
+ * Every field with a deadline gets its own worker so they run in parallel; the
+ * caller then waits on each until that field's deadline.
+ *
+ * @return BLING_OK if every field was collected, otherwise the first error.
+ */
+static int refresh_fields(bling_snapshot *snap, unsigned int fields, unsigned int *changed) {
+    struct worker *workers[FIELD_COUNT] = { 0 };
+    struct field_job *jobs[FIELD_COUNT] = { 0 };
+    long long now = worker_now_ms();
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        unsigned int field = 1u << i;
+        if ((fields & field) == 0) {
+            continue;
+        }
+        snap->collected_ms[i] = now;
+
+        if (snap->quarantined[i] != NULL) {
+            if (!worker_finished(snap->quarantined[i])) {
+                snap->status[i] = BLING_ERR_TIMEOUT; // Still stuck, don't pile up another thread behind it
+                continue;
+            }
+            worker_release(snap->quarantined[i]);
+            snap->quarantined[i] = NULL;
+        }
+
+        jobs[i] = calloc(1, sizeof(*jobs[i]));
+        if (jobs[i] == NULL) {
+            snap->status[i] = BLING_ERR_NOMEM;
+            continue;
+        }
+        jobs[i]->field = field;
+
+        // Without a deadline, or if no thread is available, collect inline
+        if (snap->deadline_ms[i] == BLING_DEADLINE_NONE ||
+            worker_start(&workers[i], field_job_run, jobs[i], field_job_discard) != BLING_OK) {
+            apply_field(snap, i, field_job_run(jobs[i]), jobs[i], changed);
+            field_job_discard(jobs[i]);
+            jobs[i] = NULL;
+        }
+    }
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (workers[i] == NULL) {
+            continue;
+        }
+
+        int status = worker_wait(workers[i], now + snap->deadline_ms[i]);
+        if (status == BLING_ERR_TIMEOUT) {
+            snap->status[i] = status;
+            snap->quarantined[i] = workers[i];
+        } else {
+            apply_field(snap, i, status, jobs[i], changed);
+            worker_release(workers[i]);
+        }
+    }
+
+    int result = BLING_OK;
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if ((fields & (1u << i)) && snap->status[i] != BLING_OK) {
+            result = snap->status[i];
+            break;
+        }
+    }
+
+    return result;
+}
+
+unsigned int bling_api_version(void) {
+    return BLING_API_VERSION;
+}
+
+int bling_init(bling_snapshot **out) {
+    if (out == NULL) {
+        return BLING_ERR_INVAL;
+    }
+
+    *out = calloc(1, sizeof(**out));
+    if (*out == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+
+    memcpy((*out)->ttl_ms, default_ttl_ms, sizeof(default_ttl_ms));
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        (*out)->deadline_ms[i] = BLING_DEADLINE_DEFAULT;
+    }
+
+    return BLING_OK;
+}
+
+int bling_collect(bling_snapshot *snap, unsigned int fields) {
+    if (snap == NULL || (fields & ~BLING_FIELD_ALL) != 0) {
+        return BLING_ERR_INVAL;
+    }
+
+    unsigned int changed = 0;
+    return refresh_fields(snap, fields, &changed);
+}
+
+unsigned int bling_refresh(bling_snapshot *snap, unsigned int fields) {
+    if (snap == NULL) {
+        return 0;
+    }
+
+    unsigned int changed = 0;
+    refresh_fields(snap, fields & BLING_FIELD_ALL, &changed);
+    return changed;
+}
+
+unsigned int bling_refresh_due(bling_snapshot *snap) {
+    if (snap == NULL) {
+        return 0;
+    }
+
+    long long now = worker_now_ms();
+    unsigned int due = 0;
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        unsigned int field = 1u << i;
+        long ttl = snap->ttl_ms[i];
+
+        if (!(snap->valid & field) && snap->collected_ms[i] == 0) {
+            due |= field; // Never attempted
+        } else if (ttl == BLING_TTL_NEVER) {
+            continue;
+        } else if (now - snap->collected_ms[i] >= ttl) {
+            due |= field;
+        }
+    }
+
+    unsigned int changed = 0;
+    refresh_fields(snap, due, &changed);
+    return changed;
+}
+
+int bling_set_ttl(bling_snapshot *snap, unsigned int fields, long ttl_ms) {
+    if (snap == NULL || (fields & ~BLING_FIELD_ALL) != 0 || ttl_ms < BLING_TTL_NEVER) {
+        return BLING_ERR_INVAL;
+    }
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (fields & (1u << i)) {
+            snap->ttl_ms[i] = ttl_ms;
+        }
+    }
+
+    return BLING_OK;
+}
+
+void bling_destroy(bling_snapshot *snap) {
+    if (snap == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        release_field(&snap->data, 1u << i);
+        // A still-running worker frees itself when its collector returns
+        worker_release(snap->quarantined[i]);
+    }
+    free(snap);
+}
+
+int bling_set_deadline(bling_snapshot *snap, unsigned int fields, long deadline_ms) {
+    if (snap == NULL || (fields & ~BLING_FIELD_ALL) != 0 || deadline_ms < 0) {
+        return BLING_ERR_INVAL;
+    }
+
+    for (int i = 0; i < FIELD_COUNT; i++) {
+        if (fields & (1u << i)) {
+            snap->deadline_ms[i] = deadline_ms;
+        }
+    }
+
+    return BLING_OK;
+}
+
+int bling_field_stale(const bling_snapshot *snap, unsigned int field) {
+    int i = field_index(field);
+    if (snap == NULL || i < 0) {
+        return 0;
+    }
+    return (snap->valid & field) && snap->status[i] != BLING_OK;
+}
+
+int bling_field_status(const bling_snapshot *snap, unsigned int field) {
+    int i = field_index(field);
+    if (snap == NULL || i < 0) {
+        return BLING_ERR_INVAL;
+    }
+    return snap->status[i];
+}
+
+int bling_field_timing(const bling_snapshot *snap, unsigned int field, struct bling_timing *out) {
+    int i = field_index(field);
+    if (snap == NULL || out == NULL || i < 0) {
+        return BLING_ERR_INVAL;
+    }
+    if (!(snap->timed & field)) {
+        return BLING_ERR_NOTFOUND;
+    }
+    *out = snap->timing[i];
+    return BLING_OK;
+}
+
+unsigned int bling_fields_valid(const bling_snapshot *snap) {
+    return snap != NULL ? snap->valid : 0;
+}
+
+const char *bling_strerror(int status) {
+    switch (status) {
+    case BLING_OK:
+        return "success";
+    case BLING_ERR_NOMEM:
+        return "out of memory";
+    case BLING_ERR_IO:
+        return "I/O error";
+    case BLING_ERR_PARSE:
+        return "unparseable source";
+    case BLING_ERR_INVAL:
+        return "invalid argument";
+    case BLING_ERR_NOTFOUND:
+        return "source not found";
+    case BLING_ERR_TIMEOUT:
+        return "timed out";
+    default:
+        return "unknown error";
+    }
+}
+
+const char *bling_hostname(const bling_snapshot *snap) {
+    return snap->data.hostname;
+}
+
+const char *bling_os_name(const bling_snapshot *snap) {
+    return snap->data.os.name;
+}
+
+const char *bling_os_version(const bling_snapshot *snap) {
+    return snap->data.os.version;
+}
+
+const char *bling_os_build_id(const bling_snapshot *snap) {
+    return snap->data.os.build_id;
+}
+
+const char *bling_kernel(const bling_snapshot *snap) {
+    return snap->data.kernel;
+}
+
+const char *bling_cpu_name(const bling_snapshot *snap) {
+    return snap->data.cpu.name;
+}
+
+int bling_cpu_count(const bling_snapshot *snap) {
+    return snap->data.cpu.cores;
+}
+
+int bling_cpu_max_khz(const bling_snapshot *snap) {
+    return snap->data.cpu.base_frequency;
+}
+
+double bling_mem_total_gib(const bling_snapshot *snap) {
+    return snap->data.mem.max_memory;
+}
+
+double bling_mem_used_gib(const bling_snapshot *snap) {
+    return snap->data.mem.used_memory;
+}
+
+double bling_disk_total_gib(const bling_snapshot *snap) {
+    return snap->data.disk.total_memory_gb;
+}
+
+double bling_disk_used_gib(const bling_snapshot *snap) {
+    return snap->data.disk.used_memory_gb;
+}
+
+unsigned long long bling_uptime_seconds(const bling_snapshot *snap) {
+    return snap->data.uptime.total_seconds;
+}
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef BLING_H
+#define BLING_H
+
+/*
+ * libbling public API.
+ *
+ * Everything in this header is part of the stable C API: functions are only ever
+ * added, never changed, and the snapshot layout stays private so it can grow.
+ * The library never prints, and every call works on the snapshot it is given. The
+ * only process-wide state is in the tools' hooks: the sysroot and capture directory
+ * of file.c (--root, --capture) and the trace switch and ring list of trace.c
+ * (--trace). They are set once at startup; changing them while any thread is
+ * collecting is not thread-safe.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define BLING_API __attribute__((visibility("default")))
+#else
+#define BLING_API
+#endif
+
+#define BLING_API_VERSION 1
+
+enum bling_status {
+    BLING_OK = 0,
+    BLING_ERR_NOMEM = -1,   // Allocation failed
+    BLING_ERR_IO = -2,      // A source file or syscall failed
+    BLING_ERR_PARSE = -3,   // A source was read but held nothing usable
+    BLING_ERR_INVAL = -4,   // Bad argument
+    BLING_ERR_NOTFOUND = -5, // Source does not exist on this system
+    BLING_ERR_TIMEOUT = -6   // Collector missed its deadline
+};
+
+enum bling_field {
+    BLING_FIELD_HOSTNAME = 1u << 0,
+    BLING_FIELD_OS = 1u << 1,
+    BLING_FIELD_KERNEL = 1u << 2,
+    BLING_FIELD_MEM = 1u << 3,
+    BLING_FIELD_DISK = 1u << 4,
+    BLING_FIELD_CPU = 1u << 5,
+    BLING_FIELD_UPTIME = 1u << 6,
+
+    BLING_FIELD_ALL = (1u << 7) - 1
+};
+
+typedef struct bling_snapshot bling_snapshot;
+
+/**
+ * @brief Returns BLING_API_VERSION of the library actually loaded.
+ */
+BLING_API unsigned int bling_api_version(void);
+
+/**
+ * @brief Allocates an empty snapshot. Nothing is collected until bling_collect().
+ *
+ * @return BLING_OK, or BLING_ERR_NOMEM / BLING_ERR_INVAL. *out is NULL on failure.
+ */
+BLING_API int bling_init(bling_snapshot **out);
+
+/**
+ * @brief Collects every field in the mask into the snapshot, each under its deadline.
+ *
+ * Fields that fail keep their previous value; use bling_field_status() to see which.
+ *
+ * @return BLING_OK if all requested fields were collected, otherwise the first error.
+ */
+BLING_API int bling_collect(bling_snapshot *snap, unsigned int fields);
+
+/**
+ * @brief Re-collects every field in the mask, keeping the snapshot's previous values for comparison.
+ *
+ * @return Mask of fields whose value actually changed. A field that fails keeps its
+ * previous value and does not count as changed; see bling_field_status().
+ */
+BLING_API unsigned int bling_refresh(bling_snapshot *snap, unsigned int fields);
+
+/**
+ * @brief Re-collects only the fields whose TTL has expired (or that were never collected).
+ *
+ * Default TTLs: CPU identity, OS and kernel never refresh, hostname every 60s,
+ * disk every 30s, memory and uptime on every call.
+ *
+ * @return Mask of fields whose value actually changed.
+ */
+BLING_API unsigned int bling_refresh_due(bling_snapshot *snap);
+
+#define BLING_TTL_ALWAYS 0L
+#define BLING_TTL_NEVER (-1L)
+
+/**
+ * @brief Sets the TTL used by bling_refresh_due() for every field in the mask.
+ *
+ * @param ttl_ms Milliseconds a value stays fresh, BLING_TTL_ALWAYS or BLING_TTL_NEVER.
+ */
+BLING_API int bling_set_ttl(bling_snapshot *snap, unsigned int fields, long ttl_ms);
+
+#define BLING_DEADLINE_NONE 0L
+#define BLING_DEADLINE_DEFAULT 500L
+
+/**
+ * @brief Sets how long collection waits for each field in the mask.
+ *
+ * Collectors run in parallel on worker threads. A field that misses its deadline
+ * keeps its last value, is marked stale (BLING_ERR_TIMEOUT) and the call returns
+ * without it. Its stuck worker is quarantined: while it is still running, that field
+ * is not collected again, so a hung mount costs one thread rather than one per call.
+ *
+ * @param deadline_ms Milliseconds, or BLING_DEADLINE_NONE to collect inline on the calling thread.
+ */
+BLING_API int bling_set_deadline(bling_snapshot *snap, unsigned int fields, long deadline_ms);
+
+/**
+ * @brief Non-zero if the field holds a value but the last collection of it failed or timed out.
+ */
+BLING_API int bling_field_stale(const bling_snapshot *snap, unsigned int field);
+
+/**
+ * @brief Frees the snapshot and everything it owns. NULL is allowed.
+ */
+BLING_API void bling_destroy(bling_snapshot *snap);
+
+/**
+ * @brief Status of the last collection of a single field (one bit of enum bling_field).
+ */
+BLING_API int bling_field_status(const bling_snapshot *snap, unsigned int field);
+
+/**
+ * @brief What the last collection of one field cost, for self-profiling.
+ *
+ * Wall and CPU time are always measured. The counts come from a counting shim that only
+ * instrumented builds link in (see instrument.h); elsewhere they are -1.
+ */
+struct bling_timing {
+    long long wall_ns; // CLOCK_MONOTONIC around the collector
+    long long cpu_ns;  // CPU time of the thread that ran it
+    long long opens;
+    long long bytes_read;
+    long long allocs;
+};
+
+/**
+ * @brief Copies the cost of the last completed collection of a single field into *out.
+ *
+ * @return BLING_OK, BLING_ERR_INVAL for a bad field, BLING_ERR_NOTFOUND if no collection of it
+ *         has completed (never attempted, or every attempt timed out).
+ */
+BLING_API int bling_field_timing(const bling_snapshot *snap, unsigned int field, struct bling_timing *out);
+
+/**
+ * @brief Mask of fields that currently hold a collected value.
+ */
+BLING_API unsigned int bling_fields_valid(const bling_snapshot *snap);
+
+/**
+ * @brief Human readable description of an enum bling_status value.
+ */
+BLING_API const char *bling_strerror(int status);
+
+// Field accessors. Strings are owned by the snapshot and stay valid until the
+// next collection of that field; NULL means "not known".
+BLING_API const char *bling_hostname(const bling_snapshot *snap);
+BLING_API const char *bling_os_name(const bling_snapshot *snap);
+BLING_API const char *bling_os_version(const bling_snapshot *snap);
+BLING_API const char *bling_os_build_id(const bling_snapshot *snap);
+BLING_API const char *bling_kernel(const bling_snapshot *snap);
+
+BLING_API const char *bling_cpu_name(const bling_snapshot *snap);
+BLING_API int bling_cpu_count(const bling_snapshot *snap);
+BLING_API int bling_cpu_max_khz(const bling_snapshot *snap);
+
+BLING_API double bling_mem_total_gib(const bling_snapshot *snap);
+BLING_API double bling_mem_used_gib(const bling_snapshot *snap);
+
+BLING_API double bling_disk_total_gib(const bling_snapshot *snap);
+BLING_API double bling_disk_used_gib(const bling_snapshot *snap);
+
+BLING_API unsigned long long bling_uptime_seconds(const bling_snapshot *snap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLING_H
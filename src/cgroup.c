@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cgroup.h"
+#include "bling.h"
+#include "file.h"
+#include "topology.h"
+#include "util.h"
+#include "worker.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Copies the whitespace-delimited field at *p into out and advances past it.
+ */
+static void copy_field(const char **p, char *out, size_t size) {
+    size_t n = strcspn(*p, " \n");
+    if (n >= size) {
+        n = size - 1;
+    }
+    memcpy(out, *p, n);
+    out[n] = '\0';
+    skip_field(p);
+}
+
+/**
+ * @brief Finds the cgroup2 mount in mountinfo: its mount point and the root of the hierarchy it exposes.
+ */
+static int find_cgroup2_mount(char *mount_point, char *root, size_t size) {
+    char *buf = read_entire_file("/proc/self/mountinfo", NULL);
+    if (buf == NULL) {
+        return errno_status(errno);
+    }
+
+    int status = BLING_ERR_NOTFOUND;
+    for (const char *line = buf; *line != '\0'; line = next_line(line)) {
+        // "42 32 0:38 / /sys/fs/cgroup rw,relatime - cgroup2 cgroup2 rw"
+        const char *sep = strstr(line, " - cgroup2 ");
+        const char *end = strchr(line, '\n');
+        if (sep == NULL || (end != NULL && sep > end)) {
+            continue;
+        }
+
+        const char *p = line;
+        skip_field(&p); // mount id
+        skip_field(&p); // parent id
+        skip_field(&p); // major:minor
+        copy_field(&p, root, size);
+        copy_field(&p, mount_point, size);
+        status = BLING_OK;
+        break;
+    }
+
+    free(buf);
+    return status;
+}
+
+/**
+ * @brief Reads the "0::/path" line of /proc/self/cgroup, the unified hierarchy entry.
+ */
+static int read_self_cgroup(char *path, size_t size) {
+    char *buf = read_entire_file("/proc/self/cgroup", NULL);
+    if (buf == NULL) {
+        return errno_status(errno);
+    }
+
+    int status = BLING_ERR_NOTFOUND;
+    for (const char *line = buf; *line != '\0'; line = next_line(line)) {
+        if (strncmp(line, "0::", 3) == 0) {
+            const char *p = line + 3;
+            copy_field(&p, path, size);
+            status = BLING_OK;
+            break;
+        }
+    }
+
+    free(buf);
+    return status;
+}
+
+int cgroup_open(struct cgroup *cg) {
+    memset(cg, 0, sizeof(*cg));
+    cg->mem_max = CGROUP_UNLIMITED;
+
+    char path[PATH_MAX];
+    char mount_point[PATH_MAX];
+    char root[PATH_MAX];
+
+    int status = read_self_cgroup(path, sizeof(path));
+    if (status == BLING_OK) {
+        status = find_cgroup2_mount(mount_point, root, sizeof(mount_point));
+    }
+    if (status != BLING_OK) {
+        return status;
+    }
+
+    // A mount made inside a cgroup namespace exposes a subtree; paths are relative to it
+    const char *rel = path;
+    size_t root_len = strlen(root);
+    if (strcmp(root, "/") != 0 && strncmp(path, root, root_len) == 0 && (path[root_len] == '/' || path[root_len] == '\0')) {
+        rel = path + root_len;
+    }
+
+    char dir[PATH_MAX];
+    int n = snprintf(dir, sizeof(dir), "%s%s", mount_point, strcmp(rel, "/") == 0 ? "" : rel);
+    if (n < 0 || (size_t)n >= sizeof(dir)) {
+        return BLING_ERR_INVAL;
+    }
+
+    cg->path = strdup(path);
+    cg->dir = strdup(dir);
+    cg->mount_len = strlen(mount_point);
+    if (cg->path == NULL || cg->dir == NULL) {
+        cgroup_free(cg);
+        return BLING_ERR_NOMEM;
+    }
+    return BLING_OK;
+}
+
+/**
+ * @brief Reads dir/name into the reusable buffer. Returns 0 on success.
+ */
+static int read_group_file(struct cgroup *cg, const char *dir, const char *name) {
+    char path[PATH_MAX];
+    int n = snprintf(path, sizeof(path), "%s/%s", dir, name);
+    if (n < 0 || (size_t)n >= sizeof(path)) {
+        return -1;
+    }
+    return read_file_buf(path, &cg->buf, &cg->buf_capacity) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Walks from the group up to the hierarchy root, keeping the lowest memory.max and cpu.max.
+ *
+ * The walk includes the mount point itself: inside a cgroup namespace that is the
+ * container's own group, where the limits usually are. The real root has neither file.
+ */
+static void read_limits(struct cgroup *cg) {
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", cg->dir);
+    size_t len = strlen(dir);
+
+    cg->mem_max = CGROUP_UNLIMITED;
+    cg->cpu_limit = 0.0;
+
+    for (;;) {
+        // "max" or a byte count
+        if (read_group_file(cg, dir, "memory.max") == 0 && cg->buf[0] >= '0' && cg->buf[0] <= '9') {
+            const char *p = cg->buf;
+            unsigned long long max = scan_ull(&p);
+            if (max < cg->mem_max) {
+                cg->mem_max = max;
+            }
+        }
+
+        // "max 100000" or "50000 100000": quota and period in microseconds
+        if (read_group_file(cg, dir, "cpu.max") == 0 && cg->buf[0] >= '0' && cg->buf[0] <= '9') {
+            const char *p = cg->buf;
+            unsigned long long quota = scan_ull(&p);
+            unsigned long long period = scan_ull(&p);
+            if (period > 0) {
+                double cpus = (double)quota / (double)period;
+                if (cg->cpu_limit == 0.0 || cpus < cg->cpu_limit) {
+                    cg->cpu_limit = cpus;
+                }
+            }
+        }
+
+        if (len <= cg->mount_len) {
+            break;
+        }
+        while (len > cg->mount_len && dir[len - 1] != '/') {
+            len--;
+        }
+        dir[len > 0 ? --len : 0] = '\0';
+    }
+}
+
+static void read_memory(struct cgroup *cg) {
+    cg->has_memory = read_group_file(cg, cg->dir, "memory.current") == 0;
+    if (!cg->has_memory) {
+        return;
+    }
+
+    const char *p = cg->buf;
+    cg->mem_current = scan_ull(&p);
+
+    if (read_group_file(cg, cg->dir, "memory.stat") != 0) {
+        return;
+    }
+    for (p = cg->buf; *p != '\0'; p = next_line(p)) {
+        if (strncmp(p, "anon ", 5) == 0) {
+            const char *v = p + 5;
+            cg->mem_anon = scan_ull(&v);
+        } else if (strncmp(p, "file ", 5) == 0) {
+            const char *v = p + 5;
+            cg->mem_file = scan_ull(&v);
+        }
+    }
+}
+
+static void read_cpu_stat(struct cgroup *cg, long long elapsed_ms, int have_prev) {
+    unsigned long long prev_usage = cg->usage_usec;
+    unsigned long long prev_periods = cg->nr_periods;
+    unsigned long long prev_throttled = cg->nr_throttled;
+    unsigned long long prev_throttled_usec = cg->throttled_usec;
+
+    if (read_group_file(cg, cg->dir, "cpu.stat") != 0) {
+        return;
+    }
+
+    for (const char *p = cg->buf; *p != '\0'; p = next_line(p)) {
+        const char *v;
+        if (strncmp(p, "usage_usec ", 11) == 0) {
+            v = p + 11;
+            cg->usage_usec = scan_ull(&v);
+        } else if (strncmp(p, "nr_periods ", 11) == 0) {
+            v = p + 11;
+            cg->nr_periods = scan_ull(&v);
+        } else if (strncmp(p, "nr_throttled ", 13) == 0) {
+            v = p + 13;
+            cg->nr_throttled = scan_ull(&v);
+        } else if (strncmp(p, "throttled_usec ", 15) == 0) {
+            v = p + 15;
+            cg->throttled_usec = scan_ull(&v);
+        }
+    }
+
+    if (!have_prev) {
+        return;
+    }
+
+    // Counters only go backwards if the group was recreated; treat that as a fresh start
+#define DELTA(cur, old) ((cur) >= (old) ? (cur) - (old) : 0)
+    cg->delta_periods = DELTA(cg->nr_periods, prev_periods);
+    cg->delta_throttled = DELTA(cg->nr_throttled, prev_throttled);
+    cg->delta_throttled_usec = DELTA(cg->throttled_usec, prev_throttled_usec);
+    cg->cpu_used = elapsed_ms > 0 ? (double)DELTA(cg->usage_usec, prev_usage) / ((double)elapsed_ms * 1000.0) : 0.0;
+#undef DELTA
+}
+
+int cgroup_sample(struct cgroup *cg) {
+    if (cg->dir == NULL) {
+        return BLING_ERR_INVAL;
+    }
+
+    long long now = worker_now_ms();
+
+    read_limits(cg);
+    read_memory(cg);
+    read_cpu_stat(cg, now - cg->sample_ms, cg->samples > 0);
+
+    struct cpuset cpus;
+    if (read_group_file(cg, cg->dir, "cpuset.cpus.effective") == 0 && cpuset_parse_list(&cpus, cg->buf) == BLING_OK) {
+        cg->cpuset_cpus = cpuset_count(&cpus);
+    }
+
+    cg->sample_ms = now;
+    cg->samples++;
+
+    return BLING_OK;
+}
+
+double cgroup_effective_cpus(const struct cgroup *cg) {
+    double cpus = cg->cpu_limit;
+    if (cg->cpuset_cpus > 0 && (cpus == 0.0 || cg->cpuset_cpus < cpus)) {
+        cpus = cg->cpuset_cpus;
+    }
+    return cpus;
+}
+
+void cgroup_free(struct cgroup *cg) {
+    free(cg->path);
+    free(cg->dir);
+    free(cg->buf);
+    memset(cg, 0, sizeof(*cg));
+}
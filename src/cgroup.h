@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef CGROUP_H
+#define CGROUP_H
+
+#include <stddef.h>
+
+#define CGROUP_UNLIMITED (~0ull)
+
+/**
+ * @brief The cgroup v2 group this process runs in, with its effective limits and usage.
+ *
+ * Limits are effective ones: memory.max and cpu.max are taken as the lowest value
+ * anywhere between this group and the root of the hierarchy, since a container
+ * runtime usually sets them on a parent of the group the process lands in.
+ */
+struct cgroup {
+    char *path;       // Group path from /proc/self/cgroup, e.g. "/system.slice/foo.service"
+    char *dir;        // The group's directory under the cgroup2 mount
+    size_t mount_len; // Length of the mount point prefix of dir
+
+    int has_memory;                 // memory.current exists (memory controller enabled)
+    unsigned long long mem_max;     // Bytes, CGROUP_UNLIMITED if no group limits memory
+    unsigned long long mem_current; // Bytes charged to the group, page cache included
+    unsigned long long mem_anon;    // From memory.stat
+    unsigned long long mem_file;
+
+    double cpu_limit; // CPUs' worth of quota from cpu.max, 0 if unlimited
+    int cpuset_cpus;  // CPUs in cpuset.cpus.effective, 0 if unknown
+
+    // Cumulative cpu.stat counters
+    unsigned long long usage_usec;
+    unsigned long long nr_periods;
+    unsigned long long nr_throttled;
+    unsigned long long throttled_usec;
+
+    // Change since the previous sample, valid once samples reaches 2
+    unsigned long long delta_periods;
+    unsigned long long delta_throttled;
+    unsigned long long delta_throttled_usec;
+    double cpu_used; // CPUs' worth of usage_usec over the interval
+
+    int samples;
+    long long sample_ms;
+    char *buf;
+    size_t buf_capacity;
+};
+
+/**
+ * @brief Finds this process's cgroup v2 group from /proc/self/cgroup and the cgroup2 mount.
+ *
+ * @return BLING_OK, or BLING_ERR_NOTFOUND on a v1-only system. Free with cgroup_free().
+ */
+int cgroup_open(struct cgroup *cg);
+
+/**
+ * @brief Re-reads limits, memory.current/memory.stat and cpu.stat, computing
+ * throttling deltas against the previous call.
+ */
+int cgroup_sample(struct cgroup *cg);
+
+/**
+ * @brief Effective CPU count: the tighter of the cpu.max quota and the cpuset, or 0 if neither applies.
+ */
+double cgroup_effective_cpus(const struct cgroup *cg);
+
+void cgroup_free(struct cgroup *cg);
+
+#endif // CGROUP_H
@@ -0,0 +1,855 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * bling-bench: times each collector and a whole snapshot, built and run by `./nob bench`.
+ *
+ * Every case runs until BENCH_ITERATIONS calls or BENCH_CASE_BUDGET_MS, whichever comes
+ * first, and reports min/median/p99 wall time per call along with syscall counts from
+ * /proc/self/io and allocation/open counts from the instrument.c shim, both per call.
+ *
+ * --scaling compares saved runs against bling-fixturegen trees of different sizes, and flags
+ * the cases whose cost grows faster than the host.
+ */
+
+#include "audit.h"
+#include "bling.h"
+#include "cgroup.h"
+#include "cpustat.h"
+#include "diskstats.h"
+#include "file.h"
+#include "instrument.h"
+#include "memfrag.h"
+#include "mounts.h"
+#include "netdev.h"
+#include "pressure.h"
+#include "procs.h"
+#include "sockets.h"
+#include "system.h"
+#include "thermal.h"
+#include "topology.h"
+#include "util.h"
+#include "virt.h"
+#include "vmstat.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_ITERATIONS 200
+#define BENCH_MIN_ITERATIONS 5
+#define BENCH_CASE_BUDGET_MS 500
+#define BENCH_LATEST "latest.json"
+#define BENCH_SCALING "scaling.tsv"
+#define FIXTURE_MANIFEST "/bling-fixture" // Written by bling-fixturegen
+
+// Growth exponent over the two largest fixtures above which a case is flagged; 1 is linear in the host size
+#define SCALING_LIMIT 1.25
+// The gate is on work per call (reads, opens, allocations), which is exact. Time only gets a note: on fixture
+// trees it grows with dentry and page cache effects of the tree, not just with bling's code.
+// Below these at the largest fixture, fixed costs dominate and nothing is flagged
+#define SCALING_MIN_COUNT 50.0
+#define SCALING_MIN_US 200.0
+
+struct bench_case {
+    const char *name;
+    // Optional; returns NULL when the case cannot run here (no thermal sensors), which skips it
+    void *(*setup)(void);
+    int (*run)(void *state);
+    void (*teardown)(void *state);
+};
+
+struct case_result {
+    const char *name;
+    int skipped;
+    int failed; // run() returned an error at least once
+    int iterations;
+    double min_us;
+    double median_us;
+    double p99_us;
+    // Per call
+    double reads; // read-type syscalls (syscr); getdents, stat and open are not in the kernel's count
+    double writes;
+    double opens;
+    double allocs;
+    double alloc_bytes;
+};
+
+struct proc_io {
+    unsigned long long syscr;
+    unsigned long long syscw;
+};
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief This process's own counters: opened directly, since read_file() would follow --root into the fixture.
+ */
+static void read_proc_io(struct proc_io *io) {
+    char buf[512];
+    memset(io, 0, sizeof(*io));
+    int fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) {
+        return;
+    }
+    buf[n] = '\0';
+    const char *p = strstr(buf, "syscr:");
+    if (p != NULL) {
+        p += 6;
+        io->syscr = scan_ull(&p);
+    }
+    p = strstr(buf, "syscw:");
+    if (p != NULL) {
+        p += 6;
+        io->syscw = scan_ull(&p);
+    }
+}
+
+static int cmp_ll(const void *a, const void *b) {
+    long long x = *(const long long *)a;
+    long long y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+// Cases. State is whatever setup() returns; stateless cases use a dummy so NULL can mean "skip".
+
+static int dummy;
+
+static void *no_state(void) {
+    return &dummy;
+}
+
+static int run_lines(void *state) {
+    (void)state;
+    int count = 0;
+    char **l = lines("/proc/meminfo", &count);
+    if (l == NULL) {
+        return BLING_ERR_IO;
+    }
+    free_string_array(l);
+    return BLING_OK;
+}
+
+static int run_split(void *state) {
+    (void)state;
+    // A /proc/stat cpu line, the kind of string split() was written for
+    char **parts = split("cpu  2255 34 2290 22625563 6290 127 456 0 0 0", " ");
+    if (parts == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+    free_string_array(parts);
+    return BLING_OK;
+}
+
+static int run_read_entire_file(void *state) {
+    (void)state;
+    char *data = read_entire_file("/proc/stat", NULL);
+    if (data == NULL) {
+        return BLING_ERR_IO;
+    }
+    free(data);
+    return BLING_OK;
+}
+
+static int run_get_os(void *state) {
+    (void)state;
+    struct os os = { 0 };
+    int status = get_os(&os);
+    free(os.name);
+    free(os.version);
+    free(os.build_id);
+    return status;
+}
+
+static int run_get_cpu(void *state) {
+    (void)state;
+    struct cpu cpu = { 0 };
+    int status = get_cpu(&cpu);
+    free(cpu.name);
+    return status;
+}
+
+static int run_get_meminfo(void *state) {
+    (void)state;
+    struct mem mem;
+    return get_meminfo(&mem);
+}
+
+static int run_get_uptime(void *state) {
+    (void)state;
+    struct uptime up;
+    return get_uptime(&up);
+}
+
+static int run_get_diskinfo(void *state) {
+    (void)state;
+    struct disk disk;
+    return get_diskinfo(&disk);
+}
+
+static int run_get_hostname(void *state) {
+    (void)state;
+    char *name = NULL;
+    int status = get_hostname(&name);
+    free(name);
+    return status;
+}
+
+static int run_get_kernel(void *state) {
+    (void)state;
+    char *kernel = NULL;
+    int status = get_kernel(&kernel);
+    free(kernel);
+    return status;
+}
+
+static void *alloc_topology(void) {
+    return malloc(sizeof(struct topology));
+}
+
+static int run_get_topology(void *state) {
+    return get_topology(state);
+}
+
+static void *init_cpustat(void) {
+    struct cpustat *cs = malloc(sizeof(*cs));
+    if (cs != NULL && cpustat_init(cs, MAX_CPUS) != BLING_OK) {
+        free(cs);
+        return NULL;
+    }
+    return cs;
+}
+
+static int run_cpustat(void *state) {
+    return cpustat_sample(state);
+}
+
+static void free_cpustat(void *state) {
+    cpustat_free(state);
+    free(state);
+}
+
+static void *init_vmstat(void) {
+    return calloc(1, sizeof(struct vmstat));
+}
+
+static int run_vmstat(void *state) {
+    return vmstat_sample(state, NULL);
+}
+
+static void free_vmstat(void *state) {
+    vmstat_free(state);
+    free(state);
+}
+
+static void *init_pressure(void) {
+    return calloc(1, sizeof(struct pressure));
+}
+
+static int run_pressure(void *state) {
+    return pressure_sample(state);
+}
+
+static void free_pressure(void *state) {
+    pressure_free(state);
+    free(state);
+}
+
+static void *init_cgroup(void) {
+    struct cgroup *cg = malloc(sizeof(*cg));
+    if (cg != NULL && cgroup_open(cg) != BLING_OK) {
+        free(cg);
+        return NULL;
+    }
+    return cg;
+}
+
+static int run_cgroup(void *state) {
+    return cgroup_sample(state);
+}
+
+static void free_cgroup(void *state) {
+    cgroup_free(state);
+    free(state);
+}
+
+static void *init_memfrag(void) {
+    return calloc(1, sizeof(struct memfrag));
+}
+
+static int run_memfrag(void *state) {
+    return memfrag_sample(state, 1);
+}
+
+static void free_memfrag(void *state) {
+    memfrag_free(state);
+    free(state);
+}
+
+static void *init_diskstats(void) {
+    return calloc(1, sizeof(struct diskstats));
+}
+
+static int run_diskstats(void *state) {
+    return diskstats_sample(state);
+}
+
+static void free_diskstats(void *state) {
+    diskstats_free(state);
+    free(state);
+}
+
+static void *init_netdev(void) {
+    struct netdev *nd = malloc(sizeof(*nd));
+    if (nd != NULL && netdev_init(nd) != BLING_OK) {
+        free(nd);
+        return NULL;
+    }
+    return nd;
+}
+
+static int run_netdev(void *state) {
+    return netdev_sample(state);
+}
+
+static void free_netdev(void *state) {
+    netdev_free(state);
+    free(state);
+}
+
+static int run_sockets(void *state) {
+    (void)state;
+    struct socket_summary summary;
+    return get_socket_summary(&summary);
+}
+
+static void *init_top(void) {
+    struct proc_top *pt = malloc(sizeof(*pt));
+    if (pt != NULL && proc_top_init(pt, 5) != BLING_OK) {
+        free(pt);
+        return NULL;
+    }
+    return pt;
+}
+
+static int run_top(void *state) {
+    return proc_top_sample(state, 2000);
+}
+
+static void free_top(void *state) {
+    proc_top_free(state);
+    free(state);
+}
+
+static int run_mounts(void *state) {
+    (void)state;
+    struct mount_table table;
+    int status = get_mounts(&table, BLING_DEADLINE_DEFAULT);
+    if (status == BLING_OK) {
+        free_mounts(&table);
+    }
+    return status;
+}
+
+static void *alloc_virt(void) {
+    return malloc(sizeof(struct virt));
+}
+
+static int run_virt(void *state) {
+    return virt_detect(state);
+}
+
+static void *init_audit(void) {
+    return calloc(1, sizeof(struct audit));
+}
+
+static int run_audit(void *state) {
+    struct audit *a = state;
+    audit_free(a);
+    memset(a, 0, sizeof(*a));
+    return audit_run(a, AUDIT_LATENCY);
+}
+
+static void free_audit(void *state) {
+    audit_free(state);
+    free(state);
+}
+
+static void *init_thermal(void) {
+    struct thermal *t = malloc(sizeof(*t));
+    if (t != NULL && thermal_init(t) != BLING_OK) {
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+static int run_thermal(void *state) {
+    return thermal_sample(state);
+}
+
+static void free_thermal(void *state) {
+    thermal_free(state);
+    free(state);
+}
+
+static int run_snapshot(void *state) {
+    (void)state;
+    bling_snapshot *snap = NULL;
+    if (bling_init(&snap) != BLING_OK) {
+        return BLING_ERR_NOMEM;
+    }
+    // Field failures are normal on minimal hosts; the cost is what is measured
+    bling_collect(snap, BLING_FIELD_ALL);
+    bling_destroy(snap);
+    return BLING_OK;
+}
+
+static const struct bench_case cases[] = {
+    { "lines", no_state, run_lines, NULL },
+    { "split", no_state, run_split, NULL },
+    { "read_entire_file", no_state, run_read_entire_file, NULL },
+    { "get_os", no_state, run_get_os, NULL },
+    { "get_cpu", no_state, run_get_cpu, NULL },
+    { "get_meminfo", no_state, run_get_meminfo, NULL },
+    { "get_uptime", no_state, run_get_uptime, NULL },
+    { "get_diskinfo", no_state, run_get_diskinfo, NULL },
+    { "get_hostname", no_state, run_get_hostname, NULL },
+    { "get_kernel", no_state, run_get_kernel, NULL },
+    { "get_topology", alloc_topology, run_get_topology, free },
+    { "cpustat_sample", init_cpustat, run_cpustat, free_cpustat },
+    { "vmstat_sample", init_vmstat, run_vmstat, free_vmstat },
+    { "pressure_sample", init_pressure, run_pressure, free_pressure },
+    { "cgroup_sample", init_cgroup, run_cgroup, free_cgroup },
+    { "memfrag_sample", init_memfrag, run_memfrag, free_memfrag },
+    { "diskstats_sample", init_diskstats, run_diskstats, free_diskstats },
+    { "netdev_sample", init_netdev, run_netdev, free_netdev },
+    { "get_socket_summary", no_state, run_sockets, NULL },
+    { "proc_top_sample", init_top, run_top, free_top },
+    { "get_mounts", no_state, run_mounts, NULL },
+    { "virt_detect", alloc_virt, run_virt, free },
+    { "audit_run", init_audit, run_audit, free_audit },
+    { "thermal_sample", init_thermal, run_thermal, free_thermal },
+    { "snapshot", no_state, run_snapshot, NULL },
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+static void run_case(const struct bench_case *c, int max_iterations, struct case_result *r, long long *times) {
+    memset(r, 0, sizeof(*r));
+    r->name = c->name;
+
+    void *state = c->setup();
+    if (state == NULL) {
+        r->skipped = 1;
+        return;
+    }
+
+    // One untimed call first, so one-time work (buffer growth, first sysfs walk) is not in the numbers
+    r->failed = c->run(state) != BLING_OK;
+
+    struct proc_io io_before, io_after, io_overhead;
+    struct instrument_counts before, after;
+    // Reading /proc/self/io is itself a read; measure that once and take it off
+    read_proc_io(&io_overhead);
+    read_proc_io(&io_before);
+    instrument_read(&before);
+
+    long long deadline = now_ns() + BENCH_CASE_BUDGET_MS * 1000000LL;
+    int n = 0;
+    while (n < max_iterations && (n < BENCH_MIN_ITERATIONS || now_ns() < deadline)) {
+        long long start = now_ns();
+        if (c->run(state) != BLING_OK) {
+            r->failed = 1;
+        }
+        times[n++] = now_ns() - start;
+    }
+
+    instrument_read(&after);
+    read_proc_io(&io_after);
+    if (c->teardown != NULL) {
+        c->teardown(state);
+    }
+
+    unsigned long long own_reads = io_before.syscr - io_overhead.syscr;
+    qsort(times, (size_t)n, sizeof(*times), cmp_ll);
+    r->iterations = n;
+    r->min_us = (double)times[0] / 1000.0;
+    r->median_us = (double)times[n / 2] / 1000.0;
+    r->p99_us = (double)times[(size_t)((n - 1) * 0.99)] / 1000.0;
+    r->reads = (double)(io_after.syscr - io_before.syscr - own_reads) / n;
+    r->writes = (double)(io_after.syscw - io_before.syscw) / n;
+    r->opens = (double)(after.opens - before.opens) / n;
+    r->allocs = (double)(after.allocs - before.allocs) / n;
+    r->alloc_bytes = (double)(after.alloc_bytes - before.alloc_bytes) / n;
+}
+
+/**
+ * @brief Short commit id of the tree being measured, read straight from .git; "unknown" outside a checkout.
+ */
+static void git_revision(char *out, size_t size) {
+    char head[256];
+    snprintf(out, size, "unknown");
+    if (read_file(".git/HEAD", head, sizeof(head)) <= 0) {
+        return;
+    }
+    head[strcspn(head, "\n")] = '\0';
+
+    char id[64] = "";
+    if (strncmp(head, "ref: ", 5) != 0) {
+        snprintf(id, sizeof(id), "%.40s", head); // Detached
+    } else {
+        char path[320];
+        snprintf(path, sizeof(path), ".git/%s", head + 5);
+        if (read_file(path, id, sizeof(id)) <= 0) {
+            // Packed: "<id> <ref>" lines
+            char *packed = read_entire_file(".git/packed-refs", NULL);
+            const char *ref = packed != NULL ? strstr(packed, head + 5) : NULL;
+            if (ref != NULL && ref - packed >= 41) {
+                snprintf(id, sizeof(id), "%.40s", ref - 41);
+            }
+            free(packed);
+        }
+    }
+    if (id[0] != '\0') {
+        snprintf(out, size, "%.12s", id);
+    }
+}
+
+/**
+ * @brief The scale recorded in a bling-fixturegen manifest under the current root, 0 when there is none.
+ */
+static double fixture_scale(void) {
+    char buf[256];
+    double scale = 0.0;
+    if (file_rooted() && read_file(FIXTURE_MANIFEST, buf, sizeof(buf)) > 0) {
+        sscanf(buf, "scale %lf", &scale);
+    }
+    return scale;
+}
+
+static void write_json(FILE *f, const char *revision, const char *root, double scale, const struct case_result *results,
+                       size_t count) {
+    // One case per line, so results diff cleanly and --compare can read them back with sscanf
+    fprintf(f, "{\"revision\":\"%s\",\"time\":%lld,\"root\":\"%s\",\"scale\":%g,\"cases\":[\n", revision,
+            (long long)time(NULL), root != NULL ? root : "/", scale);
+    for (size_t i = 0, first = 1; i < count; i++) {
+        const struct case_result *r = &results[i];
+        if (r->skipped) {
+            continue;
+        }
+        fprintf(f,
+                "%s{\"name\":\"%s\",\"iterations\":%d,\"min_us\":%.3f,\"median_us\":%.3f,\"p99_us\":%.3f,"
+                "\"reads\":%.2f,\"writes\":%.2f,\"opens\":%.2f,\"allocs\":%.2f,\"alloc_bytes\":%.0f,\"failed\":%s}",
+                first ? "" : ",\n", r->name, r->iterations, r->min_us, r->median_us, r->p99_us, r->reads, r->writes,
+                r->opens, r->allocs, r->alloc_bytes, r->failed ? "true" : "false");
+        first = 0;
+    }
+    fprintf(f, "\n]}\n");
+}
+
+/**
+ * @brief A numeric field ("median_us") of the named case in a file written by write_json(), or a negative value.
+ */
+static double case_value(const char *json, const char *name, const char *field) {
+    char key[96];
+    snprintf(key, sizeof(key), "{\"name\":\"%s\",", name);
+    const char *p = strstr(json, key);
+    if (p == NULL) {
+        return -1.0;
+    }
+    const char *end = strchr(p, '}');
+    snprintf(key, sizeof(key), "\"%s\":", field);
+    p = strstr(p, key);
+    double value = -1.0;
+    if (p != NULL && p < end) {
+        sscanf(p + strlen(key), "%lf", &value);
+    }
+    return value;
+}
+
+static void print_results(const struct case_result *results, size_t count, const char *baseline, const char *revision) {
+    printf("bling-bench %s\n", revision);
+    printf("%-20s %6s %10s %10s %10s %7s %7s %7s %8s %10s%s\n", "case", "iters", "min us", "median us", "p99 us", "reads",
+           "writes", "opens", "allocs", "bytes", baseline != NULL ? "  vs baseline" : "");
+    for (size_t i = 0; i < count; i++) {
+        const struct case_result *r = &results[i];
+        if (r->skipped) {
+            printf("%-20s skipped, not available on this system\n", r->name);
+            continue;
+        }
+        printf("%-20s %6d %10.1f %10.1f %10.1f %7.1f %7.1f %7.1f %8.1f %10.0f", r->name, r->iterations, r->min_us,
+               r->median_us, r->p99_us, r->reads, r->writes, r->opens, r->allocs, r->alloc_bytes);
+        double before = baseline != NULL ? case_value(baseline, r->name, "median_us") : -1.0;
+        if (before > 0.0) {
+            printf("  %+6.1f%%", (r->median_us - before) / before * 100.0);
+        }
+        printf("%s\n", r->failed ? "  (errors)" : "");
+    }
+}
+
+struct scaling_run {
+    const char *path;
+    char *json;
+    double scale;
+};
+
+static int cmp_scale(const void *a, const void *b) {
+    double x = ((const struct scaling_run *)a)->scale;
+    double y = ((const struct scaling_run *)b)->scale;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Growth exponent of a case's field between the two largest runs, or -1 if it is missing or below floor.
+ */
+static double scaling_growth(const struct scaling_run *runs, int usable, const char *name, const char *field,
+                             double floor) {
+    double last = case_value(runs[usable - 1].json, name, field);
+    double previous = case_value(runs[usable - 2].json, name, field);
+    if (last < floor || previous <= 0.0) {
+        return -1.0;
+    }
+    return log(last / previous) / log(runs[usable - 1].scale / runs[usable - 2].scale);
+}
+
+static void print_growth(double growth) {
+    if (growth < 0.0) {
+        printf(" %6s", "-");
+    } else {
+        printf(" %6.2f", growth);
+    }
+}
+
+/**
+ * @brief Prints each case's fastest time against fixture scale, from runs saved with --root on bling-fixturegen trees.
+ *
+ * The growth exponents are taken between the two largest fixtures, where fixed costs matter least: about 1 for a
+ * collector linear in the host size, 2 for a quadratic one. With save_dir, the table is also written as TSV for
+ * plotting.
+ *
+ * @return 0, 1 when a case's reads, opens or allocations per call grow faster than SCALING_LIMIT or the runs are
+ * unusable. Time growing faster only gets a note.
+ */
+static int print_scaling(char **paths, int count, const char *save_dir) {
+    struct scaling_run *runs = calloc((size_t)count, sizeof(*runs));
+    if (runs == NULL) {
+        return 1;
+    }
+    int usable = 0;
+    for (int i = 0; i < count; i++) {
+        char *json = read_entire_file(paths[i], NULL);
+        const char *p = json != NULL ? strstr(json, "\"scale\":") : NULL;
+        double scale = 0.0;
+        if (p == NULL || sscanf(p + 8, "%lf", &scale) != 1 || scale <= 0.0) {
+            fprintf(stderr, "bling-bench: %s is not a run against a bling-fixturegen tree\n", paths[i]);
+            free(json);
+            continue;
+        }
+        runs[usable++] = (struct scaling_run){ paths[i], json, scale };
+    }
+    qsort(runs, (size_t)usable, sizeof(*runs), cmp_scale);
+    if (usable < 2 || runs[usable - 2].scale == runs[usable - 1].scale) {
+        fprintf(stderr, "bling-bench: --scaling needs runs at two or more different scales\n");
+        for (int i = 0; i < usable; i++) {
+            free(runs[i].json);
+        }
+        free(runs);
+        return 1;
+    }
+
+    FILE *tsv = NULL;
+    if (save_dir != NULL) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/" BENCH_SCALING, save_dir);
+        tsv = fopen(path, "w");
+        if (tsv == NULL) {
+            fprintf(stderr, "bling-bench: cannot write %s: %s\n", path, strerror(errno));
+        } else {
+            fprintf(tsv, "case\tscale\tmin_us\tmedian_us\tp99_us\treads\topens\tallocs\n");
+        }
+    }
+
+    printf("%-20s", "min us at scale");
+    for (int i = 0; i < usable; i++) {
+        printf(" %10g", runs[i].scale);
+    }
+    printf("  %6s %6s\n", "time", "work");
+
+    static const char *const work_fields[] = { "reads", "opens", "allocs" };
+    int flagged = 0;
+    for (size_t c = 0; c < CASE_COUNT; c++) {
+        const char *name = cases[c].name;
+        if (case_value(runs[usable - 1].json, name, "min_us") < 0.0 &&
+            case_value(runs[usable - 2].json, name, "min_us") < 0.0) {
+            continue; // Skipped everywhere
+        }
+
+        printf("%-20s", name);
+        for (int i = 0; i < usable; i++) {
+            double min = case_value(runs[i].json, name, "min_us");
+            if (min < 0.0) {
+                printf(" %10s", "-");
+                continue;
+            }
+            printf(" %10.1f", min);
+            if (tsv != NULL) {
+                fprintf(tsv, "%s\t%g\t%.3f\t%.3f\t%.3f\t%.2f\t%.2f\t%.2f\n", name, runs[i].scale, min,
+                        case_value(runs[i].json, name, "median_us"), case_value(runs[i].json, name, "p99_us"),
+                        case_value(runs[i].json, name, "reads"), case_value(runs[i].json, name, "opens"),
+                        case_value(runs[i].json, name, "allocs"));
+            }
+        }
+
+        // Work grows as fast as its fastest-growing count
+        double time = scaling_growth(runs, usable, name, "min_us", SCALING_MIN_US);
+        double work = -1.0;
+        for (size_t f = 0; f < sizeof(work_fields) / sizeof(work_fields[0]); f++) {
+            double g = scaling_growth(runs, usable, name, work_fields[f], SCALING_MIN_COUNT);
+            work = g > work ? g : work;
+        }
+        int superlinear = work > SCALING_LIMIT;
+        flagged += superlinear;
+        printf(" ");
+        print_growth(time);
+        print_growth(work);
+        if (superlinear) {
+            printf("  superlinear");
+        } else if (time > SCALING_LIMIT) {
+            printf("  (time only)");
+        }
+        printf("\n");
+    }
+
+    if (tsv != NULL) {
+        fclose(tsv);
+        printf("saved %s/" BENCH_SCALING "\n", save_dir);
+    }
+    for (int i = 0; i < usable; i++) {
+        free(runs[i].json);
+    }
+    free(runs);
+    if (flagged > 0) {
+        fprintf(stderr, "bling-bench: %d case%s did work growing faster than n^%.2f with the host\n", flagged,
+                flagged == 1 ? "" : "s", SCALING_LIMIT);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *usage = "usage: bling-bench [--root DIR] [--save DIR] [--compare FILE] [--filter SUBSTRING]\n"
+                        "                   [--iterations N]\n"
+                        "       bling-bench [--save DIR] --scaling FILE...\n"
+                        "  --root DIR: run the collectors against a fixture tree captured with bling --capture\n"
+                        "  --save DIR: write DIR/<revision>-<time>.json and DIR/" BENCH_LATEST
+                        ", comparing against the previous " BENCH_LATEST "\n"
+                        "    (latest-<fixture>.json with --root, so each fixture has its own baseline)\n"
+                        "  --compare FILE: show the change in median against an earlier result\n"
+                        "  --scaling FILE...: compare results saved against bling-fixturegen trees of different sizes,\n"
+                        "    failing when a case's reads, opens or allocations grow faster than n^1.25;\n"
+                        "    --save DIR also writes DIR/" BENCH_SCALING "\n";
+    const char *save_dir = NULL;
+    const char *compare = NULL;
+    const char *filter = NULL;
+    const char *root = NULL;
+    int iterations = BENCH_ITERATIONS;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+            save_dir = argv[++i];
+        } else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) {
+            compare = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (strcmp(argv[i], "--scaling") == 0 && i + 1 < argc) {
+            // Everything after it is a result file
+            return print_scaling(argv + i + 1, argc - i - 1, save_dir);
+        } else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+            iterations = iterations < BENCH_MIN_ITERATIONS ? BENCH_MIN_ITERATIONS : iterations;
+        } else {
+            fprintf(stderr, "%s", usage);
+            return 1;
+        }
+    }
+
+    char latest[512];
+    if (save_dir != NULL) {
+        if (mkdir(save_dir, 0755) != 0 && errno != EEXIST) {
+            fprintf(stderr, "bling-bench: cannot create %s: %s\n", save_dir, strerror(errno));
+            return 1;
+        }
+        if (root != NULL) {
+            const char *name = strrchr(root, '/');
+            name = name != NULL && name[1] != '\0' ? name + 1 : root;
+            snprintf(latest, sizeof(latest), "%s/latest-%s.json", save_dir, name);
+        } else {
+            snprintf(latest, sizeof(latest), "%s/" BENCH_LATEST, save_dir);
+        }
+        if (compare == NULL) {
+            compare = latest;
+        }
+    }
+    char *baseline = compare != NULL ? read_entire_file(compare, NULL) : NULL;
+
+    // After the baseline is read: an absolute --compare path must not resolve inside the fixture
+    if (root != NULL && file_set_root(root) != BLING_OK) {
+        fprintf(stderr, "bling-bench: cannot open root %s\n", root);
+        return 1;
+    }
+
+    struct case_result results[CASE_COUNT];
+    long long *times = malloc((size_t)iterations * sizeof(*times));
+    if (times == NULL) {
+        return 1;
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < CASE_COUNT; i++) {
+        if (filter == NULL || strstr(cases[i].name, filter) != NULL) {
+            run_case(&cases[i], iterations, &results[count++], times);
+        }
+    }
+    free(times);
+
+    double scale = fixture_scale();
+    char revision[16];
+    git_revision(revision, sizeof(revision));
+    print_results(results, count, baseline, revision);
+    free(baseline);
+
+    if (save_dir != NULL) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s-%lld.json", save_dir, revision, (long long)time(NULL));
+        const char *targets[] = { path, latest };
+        for (size_t i = 0; i < 2; i++) {
+            FILE *f = fopen(targets[i], "w");
+            if (f == NULL) {
+                fprintf(stderr, "bling-bench: cannot write %s: %s\n", targets[i], strerror(errno));
+                return 1;
+            }
+            write_json(f, revision, root, scale, results, count);
+            fclose(f);
+        }
+        printf("saved %s\n", path);
+    }
+    return 0;
+}
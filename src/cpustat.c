@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "cpustat.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+int cpustat_init(struct cpustat *cs, int max_cpus) {
+    memset(cs, 0, sizeof(*cs));
+    if (max_cpus <= 0) {
+        return BLING_ERR_INVAL;
+    }
+
+    size_t n = (size_t)max_cpus;
+
+    // One block for every array: 64-bit rows first so everything stays naturally aligned
+    size_t bytes = n * ((3 * CPU_STATES + 1) * sizeof(uint64_t) + sizeof(float) + 1);
+    char *block = calloc(1, bytes);
+    if (block == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+
+    char *p = block;
+    for (int s = 0; s < CPU_STATES; s++) {
+        cs->ticks[s] = (uint64_t *)p;
+        p += n * sizeof(uint64_t);
+        cs->prev[s] = (uint64_t *)p;
+        p += n * sizeof(uint64_t);
+    }
+    for (int s = 0; s < CPU_STATES; s++) {
+        cs->delta[s] = (uint64_t *)p;
+        p += n * sizeof(uint64_t);
+    }
+    cs->total = (uint64_t *)p;
+    p += n * sizeof(uint64_t);
+    cs->busy = (float *)p;
+    p += n * sizeof(float);
+    cs->online = (uint8_t *)p;
+
+    cs->block = block;
+    cs->capacity = max_cpus;
+    return BLING_OK;
+}
+
+/**
+ * @brief Parses the tick columns after "cpu"/"cpuN" into row i of ticks.
+ *
+ * Columns: user nice system idle iowait irq softirq steal [guest guest_nice].
+ * guest time is already counted in user, so it is not added again.
+ */
+static void parse_ticks(const char **p, uint64_t *ticks[CPU_STATES], size_t i) {
+    uint64_t user = scan_ull(p);
+    uint64_t nice = scan_ull(p);
+
+    ticks[CPU_USER][i] = user + nice;
+    ticks[CPU_SYSTEM][i] = scan_ull(p);
+    ticks[CPU_IDLE][i] = scan_ull(p);
+    ticks[CPU_IOWAIT][i] = scan_ull(p);
+    ticks[CPU_IRQ][i] = scan_ull(p);
+    ticks[CPU_SOFTIRQ][i] = scan_ull(p);
+    ticks[CPU_STEAL][i] = scan_ull(p);
+}
+
+/**
+ * @brief delta = cur - prev, clamped at 0 for counters that went backwards (CPU hotplug).
+ *
+ * Plain loops over restrict-qualified arrays: these vectorize at -O2/-O3.
+ */
+static void compute_deltas(struct cpustat *cs) {
+    size_t n = (size_t)cs->count;
+
+    for (int s = 0; s < CPU_STATES; s++) {
+        const uint64_t *restrict cur = cs->ticks[s];
+        const uint64_t *restrict old = cs->prev[s];
+        uint64_t *restrict d = cs->delta[s];
+
+        for (size_t i = 0; i < n; i++) {
+            d[i] = cur[i] > old[i] ? cur[i] - old[i] : 0;
+        }
+    }
+
+    uint64_t *restrict total = cs->total;
+    memset(total, 0, n * sizeof(*total));
+    for (int s = 0; s < CPU_STATES; s++) {
+        const uint64_t *restrict d = cs->delta[s];
+        for (size_t i = 0; i < n; i++) {
+            total[i] += d[i];
+        }
+    }
+
+    const uint64_t *restrict idle = cs->delta[CPU_IDLE];
+    const uint64_t *restrict iowait = cs->delta[CPU_IOWAIT];
+    const uint8_t *restrict online = cs->online;
+    float *restrict busy = cs->busy;
+    for (size_t i = 0; i < n; i++) {
+        float t = (float)total[i];
+        float b = t > 0.0f ? 100.0f * (t - (float)idle[i] - (float)iowait[i]) / t : 0.0f;
+        busy[i] = online[i] ? b : 0.0f;
+    }
+
+    uint64_t all_total = 0;
+    uint64_t all_delta[CPU_STATES];
+    for (int s = 0; s < CPU_STATES; s++) {
+        all_delta[s] = cs->all_ticks[s] > cs->all_prev[s] ? cs->all_ticks[s] - cs->all_prev[s] : 0;
+        all_total += all_delta[s];
+    }
+    for (int s = 0; s < CPU_STATES; s++) {
+        cs->all_pct[s] = all_total > 0 ? 100.0f * (float)all_delta[s] / (float)all_total : 0.0f;
+    }
+    cs->all_busy = 100.0f - cs->all_pct[CPU_IDLE] - cs->all_pct[CPU_IOWAIT];
+}
+
+int cpustat_sample(struct cpustat *cs) {
+    if (cs->capacity == 0) {
+        return BLING_ERR_INVAL;
+    }
+
+    if (read_file_buf("/proc/stat", &cs->buf, &cs->buf_capacity) < 0) {
+        return errno_status(errno);
+    }
+
+    // The previous sample becomes prev; its arrays are overwritten by this one
+    for (int s = 0; s < CPU_STATES; s++) {
+        uint64_t *tmp = cs->prev[s];
+        cs->prev[s] = cs->ticks[s];
+        cs->ticks[s] = tmp;
+    }
+    memcpy(cs->all_prev, cs->all_ticks, sizeof(cs->all_prev));
+    memset(cs->online, 0, (size_t)cs->capacity);
+
+    const char *p = cs->buf;
+    int found = 0;
+
+    while (*p != '\0') {
+        if (p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+            p += 3;
+            if (*p == ' ') {
+                uint64_t *all[CPU_STATES];
+                for (int s = 0; s < CPU_STATES; s++) {
+                    all[s] = &cs->all_ticks[s];
+                }
+                parse_ticks(&p, all, 0);
+                found = 1;
+            } else {
+                unsigned long long cpu = scan_ull(&p);
+                if (cpu < (unsigned long long)cs->capacity) {
+                    parse_ticks(&p, cs->ticks, (size_t)cpu);
+                    cs->online[cpu] = 1;
+                    if ((int)cpu >= cs->count) {
+                        cs->count = (int)cpu + 1;
+                    }
+                }
+            }
+        } else if (strncmp(p, "ctxt ", 5) == 0) {
+            p += 5;
+            cs->ctxt = scan_ull(&p);
+        } else if (strncmp(p, "processes ", 10) == 0) {
+            p += 10;
+            cs->processes = scan_ull(&p);
+        } else if (strncmp(p, "procs_running ", 14) == 0) {
+            p += 14;
+            cs->procs_running = scan_ull(&p);
+        } else if (strncmp(p, "procs_blocked ", 14) == 0) {
+            p += 14;
+            cs->procs_blocked = scan_ull(&p);
+        }
+        p = next_line(p);
+    }
+
+    if (!found) {
+        return BLING_ERR_PARSE;
+    }
+
+    // CPUs missing from this sample (offline) keep their last ticks so they show no activity
+    size_t n = (size_t)cs->count;
+    for (int s = 0; s < CPU_STATES; s++) {
+        uint64_t *restrict cur = cs->ticks[s];
+        const uint64_t *restrict old = cs->prev[s];
+        for (size_t i = 0; i < n; i++) {
+            cur[i] = cs->online[i] ? cur[i] : old[i];
+        }
+    }
+
+    compute_deltas(cs);
+    cs->samples++;
+
+    return BLING_OK;
+}
+
+float cpustat_max_pct(const struct cpustat *cs, enum cpu_state state, int *cpu_out) {
+    float max = 0.0f;
+    int max_cpu = -1;
+    for (int i = 0; i < cs->count; i++) {
+        if (!cs->online[i] || cs->total[i] == 0) {
+            continue;
+        }
+        float pct = (float)cs->delta[state][i] * 100.0f / (float)cs->total[i];
+        if (max_cpu < 0 || pct > max) {
+            max = pct;
+            max_cpu = i;
+        }
+    }
+    if (cpu_out != NULL) {
+        *cpu_out = max_cpu;
+    }
+    return max;
+}
+
+void cpustat_free(struct cpustat *cs) {
+    free(cs->block);
+    free(cs->buf);
+    memset(cs, 0, sizeof(*cs));
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef CPUSTAT_H
+#define CPUSTAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum cpu_state {
+    CPU_USER, // Includes nice
+    CPU_SYSTEM,
+    CPU_IDLE,
+    CPU_IOWAIT,
+    CPU_IRQ,
+    CPU_SOFTIRQ,
+    CPU_STEAL,
+    CPU_STATES
+};
+
+/**
+ * @brief Per-CPU utilization from /proc/stat, kept as deltas between two samples.
+ *
+ * Everything is structure-of-arrays, allocated once in cpustat_init(): one array per
+ * state, indexed by CPU number. cpustat_sample() only reads into the reused buffer and
+ * runs straight-line loops over those arrays, which the compiler vectorizes across CPUs.
+ */
+struct cpustat {
+    int capacity; // Rows per array, CPU numbers >= capacity are ignored
+    int count;    // Highest CPU number seen + 1
+    int samples;  // Number of successful cpustat_sample() calls
+
+    uint64_t *ticks[CPU_STATES]; // Latest cumulative ticks
+    uint64_t *prev[CPU_STATES];  // Ticks at the previous sample
+    uint64_t *delta[CPU_STATES]; // ticks - prev; since boot on the first sample, past 2^32 after 497 days at 100 Hz
+    uint64_t *total;             // Sum of delta over all states
+    float *busy;                 // Percent of the interval not idle or iowait
+    uint8_t *online;             // CPU appeared in the latest sample
+
+    // Aggregate "cpu" line, same layout
+    uint64_t all_ticks[CPU_STATES];
+    uint64_t all_prev[CPU_STATES];
+    float all_pct[CPU_STATES]; // Percent of the interval per state
+    float all_busy;
+
+    // Other /proc/stat counters, for collectors that want them without re-reading the file
+    unsigned long long ctxt;
+    unsigned long long processes;
+    unsigned long long procs_running;
+    unsigned long long procs_blocked;
+
+    void *block; // Every array above lives in this one allocation
+    char *buf;
+    size_t buf_capacity;
+};
+
+/**
+ * @brief Allocates the sample arrays for CPUs 0..max_cpus-1.
+ */
+int cpustat_init(struct cpustat *cs, int max_cpus);
+
+/**
+ * @brief Reads /proc/stat and computes deltas against the previous sample.
+ *
+ * The first sample is measured against zero, i.e. averages since boot.
+ */
+int cpustat_sample(struct cpustat *cs);
+
+/**
+ * @brief Highest per-CPU share of the last interval spent in state, in percent, e.g. the worst steal.
+ *
+ * @param cpu_out (Optional) CPU number it was seen on, -1 if no CPU had ticks.
+ */
+float cpustat_max_pct(const struct cpustat *cs, enum cpu_state state, int *cpu_out);
+
+void cpustat_free(struct cpustat *cs);
+
+#endif // CPUSTAT_H
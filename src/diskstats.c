@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "diskstats.h"
+#include "bling.h"
+#include "file.h"
+#include "system.h"
+#include "util.h"
+#include "worker.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SYSFS_BLOCK "/sys/block"
+#define SECTOR_SIZE 512.0
+
+/**
+ * @brief Builds /sys/block/<name>[/attr]; sysfs spells the '/' in names like "cciss/c0d0" as '!'.
+ */
+static void block_path(char *path, size_t size, const char *name, const char *attr) {
+    char sysfs_name[32];
+    size_t i = 0;
+    for (; name[i] != '\0' && i < sizeof(sysfs_name) - 1; i++) {
+        sysfs_name[i] = name[i] == '/' ? '!' : name[i];
+    }
+    sysfs_name[i] = '\0';
+
+    if (attr != NULL) {
+        snprintf(path, size, SYSFS_BLOCK "/%s/%s", sysfs_name, attr);
+    } else {
+        snprintf(path, size, SYSFS_BLOCK "/%s", sysfs_name);
+    }
+}
+
+static void read_queue_attrs(struct disk_dev *dev) {
+    char path[96];
+    char buf[128];
+
+    block_path(path, sizeof(path), dev->name, "queue/rotational");
+    dev->rotational = read_file(path, buf, sizeof(buf)) > 0 && buf[0] == '1';
+
+    block_path(path, sizeof(path), dev->name, "queue/nr_requests");
+    if (read_file(path, buf, sizeof(buf)) > 0) {
+        const char *p = buf;
+        dev->nr_requests = (int)scan_ull(&p);
+    }
+
+    // "[mq-deadline] kyber bfq none"
+    strcpy(dev->scheduler, "none");
+    block_path(path, sizeof(path), dev->name, "queue/scheduler");
+    if (read_file(path, buf, sizeof(buf)) > 0) {
+        const char *open = strchr(buf, '[');
+        const char *close = open != NULL ? strchr(open, ']') : NULL;
+        if (close != NULL && (size_t)(close - open - 1) < sizeof(dev->scheduler)) {
+            memcpy(dev->scheduler, open + 1, (size_t)(close - open - 1));
+            dev->scheduler[close - open - 1] = '\0';
+        }
+    }
+}
+
+/**
+ * @brief Sets up the slot for a device seen at a line for the first time.
+ */
+static void init_dev(struct disk_dev *dev, unsigned int major, unsigned int minor, const char *name, size_t name_len) {
+    memset(dev, 0, sizeof(*dev));
+    dev->major = major;
+    dev->minor = minor;
+    if (name_len >= sizeof(dev->name)) {
+        name_len = sizeof(dev->name) - 1;
+    }
+    memcpy(dev->name, name, name_len);
+    dev->name[name_len] = '\0';
+
+    char path[96];
+    block_path(path, sizeof(path), dev->name, NULL);
+    dev->whole = file_exists(path);
+    if (dev->whole) {
+        read_queue_attrs(dev);
+    }
+}
+
+/**
+ * @brief cur - prev for counters the kernel may keep in 32 bits (the millisecond fields on older kernels).
+ */
+static unsigned long long counter_delta(unsigned long long cur, unsigned long long prev) {
+    if (cur >= prev) {
+        return cur - prev;
+    }
+    return prev <= 0xffffffffull ? cur + 0x100000000ull - prev : 0;
+}
+
+static void compute_rates(struct disk_dev *dev, double seconds) {
+    unsigned long long d[DISK_COUNTERS];
+    for (int c = 0; c < DISK_COUNTERS; c++) {
+        d[c] = counter_delta(dev->counters[c], dev->prev[c]);
+    }
+
+    if (seconds <= 0.0) {
+        return;
+    }
+    double ms = seconds * 1000.0;
+
+    dev->read_iops = (double)d[DISK_READS] / seconds;
+    dev->write_iops = (double)d[DISK_WRITES] / seconds;
+    dev->read_bps = (double)d[DISK_READ_SECTORS] * SECTOR_SIZE / seconds;
+    dev->write_bps = (double)d[DISK_WRITE_SECTORS] * SECTOR_SIZE / seconds;
+
+    unsigned long long ios = d[DISK_READS] + d[DISK_WRITES] + d[DISK_DISCARDS] + d[DISK_FLUSHES];
+    unsigned long long io_ms = d[DISK_READ_MS] + d[DISK_WRITE_MS] + d[DISK_DISCARD_MS] + d[DISK_FLUSH_MS];
+    dev->await_ms = ios > 0 ? (double)io_ms / (double)ios : 0.0;
+    dev->queue_depth = (double)d[DISK_QUEUE_MS] / ms;
+    dev->util_pct = (double)d[DISK_IO_MS] / ms * 100.0;
+    if (dev->util_pct > 100.0) {
+        dev->util_pct = 100.0;
+    }
+}
+
+int diskstats_sample(struct diskstats *ds) {
+    long long now = worker_now_ms();
+    if (read_file_buf("/proc/diskstats", &ds->buf, &ds->buf_capacity) < 0) {
+        return errno_status(errno);
+    }
+
+    double seconds = ds->samples > 0 ? (double)(now - ds->sample_ms) / 1000.0 : uptime_seconds();
+
+    size_t line = 0;
+    for (const char *p = ds->buf; *p != '\0'; p = next_line(p)) {
+        // "   8       0 sda 6200 3945 1495122 6225 2015 1547 77560 1086 0 2036 7441 401 0 32240 127 53 2"
+        const char *f = p;
+        unsigned int major = (unsigned int)scan_ull(&f);
+        unsigned int minor = (unsigned int)scan_ull(&f);
+        while (*f == ' ') {
+            f++;
+        }
+        const char *name = f;
+        size_t name_len = strcspn(name, " \n");
+        if (name_len == 0) {
+            continue;
+        }
+        f += name_len;
+
+        if (line == ds->capacity) {
+            size_t capacity = ds->capacity ? ds->capacity * 2 : 32;
+            struct disk_dev *devs = realloc(ds->devs, capacity * sizeof(*devs));
+            if (devs == NULL) {
+                return BLING_ERR_NOMEM;
+            }
+            ds->devs = devs;
+            ds->capacity = capacity;
+        }
+
+        struct disk_dev *dev = &ds->devs[line];
+        int known = line < ds->count && dev->major == major && dev->minor == minor;
+        line++;
+        if (!known) {
+            init_dev(dev, major, minor, name, name_len);
+        }
+        if (!dev->whole) {
+            continue; // Partitions: their I/O is already counted in the disk
+        }
+
+        memcpy(dev->prev, dev->counters, sizeof(dev->prev));
+        unsigned long long *c = dev->counters;
+        c[DISK_READS] = scan_ull(&f);
+        scan_ull(&f); // reads merged
+        c[DISK_READ_SECTORS] = scan_ull(&f);
+        c[DISK_READ_MS] = scan_ull(&f);
+        c[DISK_WRITES] = scan_ull(&f);
+        scan_ull(&f); // writes merged
+        c[DISK_WRITE_SECTORS] = scan_ull(&f);
+        c[DISK_WRITE_MS] = scan_ull(&f);
+        dev->in_flight = scan_ull(&f);
+        c[DISK_IO_MS] = scan_ull(&f);
+        c[DISK_QUEUE_MS] = scan_ull(&f);
+        // Discard fields since 4.18, flush since 5.5; absent ones read as 0
+        c[DISK_DISCARDS] = scan_ull(&f);
+        scan_ull(&f); // discards merged
+        scan_ull(&f); // sectors discarded
+        c[DISK_DISCARD_MS] = scan_ull(&f);
+        c[DISK_FLUSHES] = scan_ull(&f);
+        c[DISK_FLUSH_MS] = scan_ull(&f);
+
+        // A device new at this line is measured from zero, like everything on the first sample
+        compute_rates(dev, known || ds->samples == 0 ? seconds : uptime_seconds());
+    }
+    ds->count = line;
+
+    ds->sample_ms = now;
+    ds->samples++;
+
+    return BLING_OK;
+}
+
+void diskstats_free(struct diskstats *ds) {
+    free(ds->devs);
+    free(ds->buf);
+    memset(ds, 0, sizeof(*ds));
+}
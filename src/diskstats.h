@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef DISKSTATS_H
+#define DISKSTATS_H
+
+#include <stddef.h>
+
+enum disk_counter {
+    DISK_READS,
+    DISK_READ_SECTORS,
+    DISK_READ_MS,
+    DISK_WRITES,
+    DISK_WRITE_SECTORS,
+    DISK_WRITE_MS,
+    DISK_IO_MS,    // Time with at least one request in flight
+    DISK_QUEUE_MS, // Sum over requests of time in flight
+    DISK_DISCARDS,
+    DISK_DISCARD_MS,
+    DISK_FLUSHES,
+    DISK_FLUSH_MS,
+    DISK_COUNTERS
+};
+
+struct disk_dev {
+    unsigned int major;
+    unsigned int minor;
+    char name[32];
+    int whole; // A disk, not a partition (has /sys/block/<name>)
+
+    // From /sys/block/<name>/queue, read once when the device first shows up
+    int rotational;
+    int nr_requests;
+    char scheduler[16]; // The bracketed entry, "none" for devices without one
+
+    unsigned long long counters[DISK_COUNTERS];
+    unsigned long long prev[DISK_COUNTERS];
+    unsigned long long in_flight;
+
+    // Between the last two samples; on the first, averages since boot
+    double read_iops;
+    double write_iops;
+    double read_bps;
+    double write_bps;
+    double await_ms;    // Average time per completed request, queueing included
+    double queue_depth; // Average requests in flight
+    double util_pct;    // Share of time the device was busy
+};
+
+/**
+ * @brief Per-device I/O activity from /proc/diskstats.
+ *
+ * Devices are kept in /proc/diskstats line order, which only changes on hotplug, so a
+ * steady-state sample is one read of the file and a pass of scan_ull() over it; sysfs
+ * is only touched for devices that are new at their line.
+ */
+struct diskstats {
+    struct disk_dev *devs;
+    size_t count;
+    size_t capacity;
+    int samples;
+    long long sample_ms;
+
+    char *buf;
+    size_t buf_capacity;
+};
+
+int diskstats_sample(struct diskstats *ds);
+
+void diskstats_free(struct diskstats *ds);
+
+#endif // DISKSTATS_H
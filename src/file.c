@@ -1,27 +1,233 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "file.h"
+#include "bling.h"
+#include "trace.h"
 #include "util.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define INITIAL_CAPACITY 8
 #define MAX_LINE_LENGTH 1024
+#define INITIAL_FILE_CAPACITY 4096
+#define CAPTURE_PATH_SIZE 4096
 
-char **lines(const char *filename, int *num_lines_out) {
-    FILE *file = fopen(filename, "r");
-    if (file == NULL) {
-        perror("Error opening file");
+static int root_fd = -1; // -1: paths resolve against "/"
+static char *capture_dir; // NULL: not capturing
+
+int file_set_root(const char *dir) {
+    int fd = -1;
+    if (dir != NULL && strcmp(dir, "/") != 0) {
+        fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            return errno_status(errno);
+        }
+    }
+    if (root_fd >= 0) {
+        close(root_fd);
+    }
+    root_fd = fd;
+    return BLING_OK;
+}
+
+int file_rooted(void) {
+    return root_fd >= 0;
+}
+
+/**
+ * @brief Creates every missing directory of path, and path itself if is_dir.
+ */
+static void make_dirs(char *path, int is_dir) {
+    for (char *p = path + 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+    if (is_dir) {
+        mkdir(path, 0755);
+    }
+}
+
+int file_set_capture(const char *dir) {
+    free(capture_dir);
+    capture_dir = NULL;
+    if (dir == NULL) {
+        return BLING_OK;
+    }
+
+    capture_dir = strdup(dir);
+    if (capture_dir == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+    char path[CAPTURE_PATH_SIZE];
+    snprintf(path, sizeof(path), "%s", dir);
+    make_dirs(path, 1);
+
+    struct stat st;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        free(capture_dir);
+        capture_dir = NULL;
+        return BLING_ERR_INVAL;
+    }
+    return BLING_OK;
+}
+
+int file_capturing(void) {
+    return capture_dir != NULL;
+}
+
+/**
+ * @brief Copies what fd reads from offset 0 to path under the capture directory.
+ *
+ * pread leaves the caller's offset alone. procfs and sysfs regenerate on every read,
+ * so the copy may differ from what the caller then reads by one sampling interval.
+ */
+static void capture(const char *path, int fd) {
+    char dest[CAPTURE_PATH_SIZE];
+    if (path[0] != '/' || (size_t)snprintf(dest, sizeof(dest), "%s%s", capture_dir, path) >= sizeof(dest)) {
+        return; // Relative paths are not part of a machine's tree
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        make_dirs(dest, 1);
+        return;
+    }
+    if (!S_ISREG(st.st_mode)) {
+        return;
+    }
+
+    size_t capacity = INITIAL_FILE_CAPACITY;
+    size_t len = 0;
+    char *buf = malloc(capacity);
+    while (buf != NULL) {
+        ssize_t n = pread(fd, buf + len, capacity - len, (off_t)len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            free(buf);
+            return; // Write-only attribute, or a file that cannot seek
+        }
+        if (n == 0) {
+            break;
+        }
+        len += (size_t)n;
+        if (len == capacity) {
+            char *temp = realloc(buf, capacity * 2);
+            if (temp == NULL) {
+                free(buf);
+                return;
+            }
+            buf = temp;
+            capacity *= 2;
+        }
+    }
+    if (buf == NULL) {
+        return;
+    }
+
+    make_dirs(dest, 0);
+    int out = open(dest, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out >= 0) {
+        for (size_t done = 0; done < len;) {
+            ssize_t n = write(out, buf + done, len - done);
+            if (n <= 0 && errno != EINTR) {
+                break;
+            }
+            done += n > 0 ? (size_t)n : 0;
+        }
+        close(out);
+    }
+    free(buf);
+}
+
+int file_open(const char *path, int flags) {
+    int fd;
+    if (root_fd >= 0 && path[0] == '/') {
+        fd = openat(root_fd, path[1] != '\0' ? path + 1 : ".", flags);
+    } else {
+        fd = open(path, flags);
+    }
+    if (capture_dir != NULL && fd >= 0) {
+        int saved = errno;
+        capture(path, fd);
+        errno = saved;
+    }
+    return fd;
+}
+
+int file_openat(int dirfd, const char *dir, const char *name, int flags) {
+    int fd = openat(dirfd, name, flags);
+    if (capture_dir != NULL && fd >= 0) {
+        char path[CAPTURE_PATH_SIZE];
+        snprintf(path, sizeof(path), "%s/%s", dir, name);
+        capture(path, fd);
+    }
+    return fd;
+}
+
+DIR *file_opendir(const char *path) {
+    int fd = file_open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
         return NULL;
     }
+    DIR *dir = fdopendir(fd);
+    if (dir == NULL) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+    }
+    return dir;
+}
+
+int file_exists(const char *path) {
+    if (root_fd >= 0 && path[0] == '/') {
+        struct stat st;
+        return fstatat(root_fd, path[1] != '\0' ? path + 1 : ".", &st, 0) == 0;
+    }
+    return access(path, F_OK) == 0;
+}
+
+int file_statvfs(const char *path, struct statvfs *sv) {
+    if (root_fd >= 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    TRACE_BEGIN("statvfs", path);
+    int ret = statvfs(path, sv);
+    TRACE_END("statvfs");
+    return ret;
+}
+
+static char **read_lines(const char *filename, int *num_lines_out) {
+    int fd = file_open(filename, O_RDONLY | O_CLOEXEC);
+    FILE *file = fd >= 0 ? fdopen(fd, "r") : NULL;
+    if (file == NULL) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL; // errno is set by open or fdopen
+    }
 
     int capacity = INITIAL_CAPACITY;
     char **lines = malloc(capacity * sizeof(char *));
     if (lines == NULL) {
-        perror("Memory allocation error");
         fclose(file);
+        errno = ENOMEM;
         return NULL;
     }
 
@@ -34,11 +240,11 @@ char **lines(const char *filename, int *num_lines_out) {
             capacity *= 2;
             char **temp = realloc(lines, capacity * sizeof(char *));
             if (temp == NULL) {
-                perror("Memory allocation error");
                 // Cleanup on failure
                 lines[num_lines] = NULL; // Make it valid for free_string_array
                 free_string_array(lines);
                 fclose(file);
+                errno = ENOMEM;
                 return NULL;
             }
             lines = temp;
@@ -52,11 +258,11 @@ char **lines(const char *filename, int *num_lines_out) {
 
         lines[num_lines] = strdup(line);
         if (lines[num_lines] == NULL) {
-            perror("Memory allocation error");
             // Cleanup on strdup failure
             lines[num_lines] = NULL;
             free_string_array(lines);
             fclose(file);
+            errno = ENOMEM;
             return NULL;
         }
         num_lines++;
@@ -64,8 +270,10 @@ char **lines(const char *filename, int *num_lines_out) {
 
     if (ferror(file)) {
         // Handle read error
-        free_string_array(lines); // 'lines' is NULL-terminated on failure
+        lines[num_lines] = NULL;
+        free_string_array(lines);
         fclose(file);
+        errno = EIO;
         return NULL;
     }
 
@@ -79,61 +287,206 @@ char **lines(const char *filename, int *num_lines_out) {
     return lines;
 }
 
-char **split(const char *str, const char *delim) {
-    // Create a writable copy of the string, as strtok modifies it
-    char *str_copy = strdup(str);
-    if (str_copy == NULL) {
-        perror("Memory allocation error");
-        return NULL;
-    }
+char **lines(const char *filename, int *num_lines_out) {
+    TRACE_BEGIN("read lines", filename);
+    char **ret = read_lines(filename, num_lines_out);
+    TRACE_END("read lines");
+    return ret;
+}
 
+char **split(const char *str, const char *delim) {
     int capacity = INITIAL_CAPACITY;
     char **result = malloc(capacity * sizeof(char *));
     if (result == NULL) {
-        perror("Memory allocation error");
-        free(str_copy);
+        errno = ENOMEM;
         return NULL;
     }
 
     int count = 0;
-    char *token = strtok(str_copy, delim);
 
-    while (token) {
+    // strspn/strcspn instead of strtok, which keeps hidden static state between calls
+    const char *p = str + strspn(str, delim);
+    while (*p != '\0') {
+        size_t len = strcspn(p, delim);
+
         // Resize if needed
         if (count >= capacity - 1) { // -1 for the NULL terminator
             capacity *= 2;
             char **temp = realloc(result, capacity * sizeof(char *));
             if (temp == NULL) {
-                perror("Memory allocation error");
                 // Cleanup
                 result[count] = NULL;
                 free_string_array(result);
-                free(str_copy);
+                errno = ENOMEM;
                 return NULL;
             }
             result = temp;
         }
 
         // Copy the token
-        result[count] = strdup(token);
+        result[count] = malloc(len + 1);
         if (result[count] == NULL) {
-            perror("Memory allocation error");
             // Cleanup
-            result[count] = NULL;
             free_string_array(result);
-            free(str_copy);
+            errno = ENOMEM;
             return NULL;
         }
+        memcpy(result[count], p, len);
+        result[count][len] = '\0';
         count++;
 
-        token = strtok(NULL, delim);
+        p += len;
+        p += strspn(p, delim);
     }
 
-    free(str_copy);       // Free the temporary copy
     result[count] = NULL; // Add the NULL terminator
     return result;
 }
 
+static ssize_t read_whole(const char *path, char **buf, size_t *capacity) {
+    int fd = file_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (*buf == NULL || *capacity == 0) {
+        *buf = malloc(INITIAL_FILE_CAPACITY);
+        if (*buf == NULL) {
+            close(fd);
+            errno = ENOMEM;
+            return -1;
+        }
+        *capacity = INITIAL_FILE_CAPACITY;
+    }
+
+    size_t len = 0;
+    for (;;) {
+        // Resize if needed, keeping room for the terminator
+        if (len + 1 >= *capacity) {
+            char *temp = realloc(*buf, *capacity * 2);
+            if (temp == NULL) {
+                close(fd);
+                errno = ENOMEM;
+                return -1;
+            }
+            *buf = temp;
+            *capacity *= 2;
+        }
+
+        ssize_t n = read(fd, *buf + len, *capacity - len - 1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        len += (size_t)n;
+    }
+
+    close(fd);
+    (*buf)[len] = '\0';
+    return (ssize_t)len;
+}
+
+ssize_t read_file_buf(const char *path, char **buf, size_t *capacity) {
+    TRACE_BEGIN("read", path);
+    ssize_t ret = read_whole(path, buf, capacity);
+    TRACE_END("read");
+    return ret;
+}
+
+char *read_entire_file(const char *path, size_t *len_out) {
+    char *buf = NULL;
+    size_t capacity = 0;
+
+    ssize_t len = read_file_buf(path, &buf, &capacity);
+    if (len < 0) {
+        int saved = errno;
+        free(buf);
+        errno = saved;
+        return NULL;
+    }
+
+    if (len_out != NULL) {
+        *len_out = (size_t)len;
+    }
+    return buf;
+}
+
+ssize_t read_file(const char *path, char *buf, size_t size) {
+    TRACE_BEGIN("read", path);
+    int fd = file_open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        TRACE_END("read");
+        return -1;
+    }
+
+    ssize_t n;
+    do {
+        n = read(fd, buf, size - 1);
+    } while (n < 0 && errno == EINTR);
+
+    int saved = errno;
+    close(fd);
+    TRACE_END("read");
+
+    if (n < 0) {
+        errno = saved;
+        return -1;
+    }
+
+    buf[n] = '\0';
+    return n;
+}
+
+ssize_t pread_file(int fd, char *buf, size_t size) {
+    ssize_t n;
+    do {
+        n = pread(fd, buf, size - 1, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+size_t read_files(struct file_read *files, size_t count, char *arena, size_t arena_size) {
+    size_t used = 0;
+    size_t ok = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        struct file_read *f = &files[i];
+        f->data = NULL;
+        f->len = 0;
+
+        if (arena_size - used < 2) {
+            f->err = ENOBUFS;
+            continue;
+        }
+
+        ssize_t n = read_file(f->path, arena + used, arena_size - used);
+        if (n < 0) {
+            f->err = errno;
+            continue;
+        }
+
+        f->err = 0;
+        f->data = arena + used;
+        f->len = (size_t)n;
+        used += (size_t)n + 1;
+        ok++;
+    }
+    return ok;
+}
+
 void free_string_array(char **array) {
     if (array == NULL) {
         return;
@@ -3,13 +3,84 @@
 #ifndef FILE_H
 #define FILE_H
 
+#include <dirent.h>
+#include <stddef.h>
+#include <sys/statvfs.h>
+#include <sys/types.h>
+
+/*
+ * Every file the collectors read goes through file_open()/file_opendir() and the readers
+ * below, so a run can be pointed at another machine's /proc, /sys and /etc (file_set_root)
+ * and can record what it read as such a tree (file_set_capture).
+ *
+ * Both settings are process-wide and meant to be made once at startup, before any
+ * collector runs; they are not synchronized with collectors running on other threads.
+ */
+
+/**
+ * @brief Resolves absolute paths against dir instead of "/", with openat() on a dirfd kept open.
+ *
+ * Sources that are not files stay live or are skipped: netlink socket counts fall back to
+ * /proc/net, CPUID is not consulted, and file_statvfs() fails with ENOENT.
+ *
+ * @param dir A fixture tree (see file_set_capture), or NULL for the live system again.
+ * @return BLING_OK, or an error if dir cannot be opened as a directory.
+ */
+int file_set_root(const char *dir);
+
+/**
+ * @brief Non-zero when paths resolve against a root other than "/".
+ */
+int file_rooted(void);
+
+/**
+ * @brief Copies every file opened from here on into dir, at the same absolute path.
+ *
+ * Directories that are listed are created even if nothing in them is read, so a
+ * collector walking them finds the same entries on replay.
+ *
+ * @param dir Created if missing; NULL stops capturing.
+ * @return BLING_OK, or an error if dir cannot be created.
+ */
+int file_set_capture(const char *dir);
+
+/**
+ * @brief Non-zero while file_set_capture() is recording.
+ */
+int file_capturing(void);
+
+/**
+ * @brief open() for reading, relative to the root for absolute paths, and captured.
+ */
+int file_open(const char *path, int flags);
+
+/**
+ * @brief openat() on a directory fd from file_open(); dir is that directory's path, for capture.
+ */
+int file_openat(int dirfd, const char *dir, const char *name, int flags);
+
+/**
+ * @brief opendir() relative to the root, and captured.
+ */
+DIR *file_opendir(const char *path);
+
+/**
+ * @brief Non-zero if path exists under the root.
+ */
+int file_exists(const char *path);
+
+/**
+ * @brief statvfs() of the live filesystem; fails with ENOENT under a root, where it would describe the wrong machine.
+ */
+int file_statvfs(const char *path, struct statvfs *sv);
+
 /**
  * @brief Reads all lines from a file into a NULL-terminated array of strings.
  *
  * @param filename The name of the file to read.
  * @param num_lines_out (Optional) A pointer to an int to store the number of lines read.
  * @return A NULL-terminated array of strings. The caller must free this
- * using free_string_array(). Returns NULL on failure.
+ * using free_string_array(). Returns NULL on failure with errno set.
  */
 char **lines(const char *filename, int *num_lines_out);
 
@@ -19,10 +90,71 @@ char **lines(const char *filename, int *num_lines_out);
  * @param str The string to split.
  * @param delim The delimiter string.
  * @return A NULL-terminated array of strings. The caller must free this
- * using free_string_array(). Returns NULL on failure.
+ * using free_string_array(). Returns NULL on failure with errno set.
  */
 char **split(const char *str, const char *delim);
 
+/**
+ * @brief Reads a whole file with plain open/read, no stdio.
+ *
+ * procfs files report a size of 0, so this reads until EOF, growing the buffer.
+ *
+ * @param len_out (Optional) Number of bytes read, excluding the terminator.
+ * @return A NUL-terminated buffer the caller must free(). Returns NULL on failure with errno set.
+ */
+char *read_entire_file(const char *path, size_t *len_out);
+
+/**
+ * @brief Reads a whole file into a caller-owned buffer that grows as needed and is reused across calls.
+ *
+ * This is the single-read path for samplers that re-read the same procfs file every
+ * interval: after the first call it costs one open, a read or two and a close, with no allocation.
+ *
+ * @param buf In/out buffer (may start as NULL), NUL-terminated on success.
+ * @param capacity In/out size of *buf.
+ * @return Number of bytes read, or -1 on failure with errno set.
+ */
+ssize_t read_file_buf(const char *path, char **buf, size_t *capacity);
+
+/**
+ * @brief Reads a small file (sysfs attribute, procfs counter) into buf with one open/read.
+ *
+ * The contents are NUL-terminated and truncated to size - 1 bytes.
+ *
+ * @return Number of bytes read, or -1 on failure with errno set.
+ */
+ssize_t read_file(const char *path, char *buf, size_t size);
+
+/**
+ * @brief Re-reads a small file through an fd kept open across samples, with one pread at offset 0.
+ *
+ * sysfs regenerates an attribute on every read from offset 0, so a sampler can open it once
+ * and skip the path walk, open and close that read_file() pays each time.
+ *
+ * @return Number of bytes read (buf NUL-terminated), or -1 on failure with errno set.
+ */
+ssize_t pread_file(int fd, char *buf, size_t size);
+
+/**
+ * @brief One file of a read_files() batch.
+ */
+struct file_read {
+    const char *path;
+    char *data; // Slice of the arena, NUL-terminated; NULL if the read failed
+    size_t len;
+    int err; // errno of the failure, 0 on success
+};
+
+/**
+ * @brief Reads a batch of small files (sysfs and procfs knobs) into one caller-provided arena.
+ *
+ * Each file costs one open, one read and a close, with no allocation; contents are packed
+ * back to back, so a file longer than the space left is truncated.
+ *
+ * @return Number of files read successfully.
+ */
+size_t read_files(struct file_read *files, size_t count, char *arena, size_t arena_size);
+
 /**
  * @brief Frees a NULL-terminated array of strings (e.g., from lines() or split()).
  */
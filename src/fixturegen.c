@@ -0,0 +1,881 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+/*
+ * bling-fixturegen: writes a synthetic procfs/sysfs tree for a host of a given size, for
+ * `bling --root` and `bling-bench --root`.
+ *
+ * The files have the kernel's formats and only the ones the collectors read are written,
+ * so a tree for the largest host (4096 CPUs, 64 NUMA nodes, 200k PIDs, 20k mounts, 1000
+ * NICs) stays within a few GB. Values come from a seeded generator: the same parameters
+ * always give the same tree, so timings of one fixture are comparable across commits.
+ * A "bling-fixture" manifest in the tree root records the parameters; `./nob scale` and
+ * `bling-bench --scaling` read the scale from it.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FIXTURE_MANIFEST "bling-fixture"
+
+#define MAX_CPUS 4096 // topology.h's limit
+#define MAX_NODES 64
+#define MAX_PIDS 200000
+#define MAX_MOUNTS 20000
+#define MAX_NICS 1000
+#define MAX_DISKS 1024
+
+#define NODE_MEMORY_KB (256ull << 20) // 256 GiB per node
+#define BASE_MOUNTS 6                 // /, /proc, /sys, /sys/fs/cgroup, /dev, /run
+#define PHYSICAL_NICS 4               // ens<N> at 100G; the rest are veth at 10G
+
+struct fixture {
+    double scale;
+    int cpus;
+    int nodes;
+    int pids;
+    int mounts;
+    int nics;
+    int disks;
+    unsigned long long seed;
+
+    // Derived topology: two threads per core, two nodes per package (sub-NUMA clustering)
+    int threads;
+    int cores;
+    int packages;
+
+    int root_fd;
+    unsigned long long rng;
+    size_t files;
+};
+
+/**
+ * @brief Growable output buffer; every file is built here and written with one write().
+ */
+struct out {
+    char *buf;
+    size_t len;
+    size_t cap;
+};
+
+static void die(const char *what) {
+    fprintf(stderr, "bling-fixturegen: %s: %s\n", what, strerror(errno));
+    exit(1);
+}
+
+static void out_printf(struct out *o, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(o->buf + o->len, o->cap - o->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            die("format");
+        }
+        if ((size_t)n < o->cap - o->len) {
+            o->len += (size_t)n;
+            return;
+        }
+        size_t cap = o->cap ? o->cap * 2 : 4096;
+        while (cap - o->len <= (size_t)n) {
+            cap *= 2;
+        }
+        char *grown = realloc(o->buf, cap);
+        if (grown == NULL) {
+            die("out of memory");
+        }
+        o->buf = grown;
+        o->cap = cap;
+    }
+}
+
+/**
+ * @brief xorshift64*: fast, and the same sequence on every platform for a given seed.
+ */
+static unsigned long long rnd(struct fixture *f) {
+    f->rng ^= f->rng >> 12;
+    f->rng ^= f->rng << 25;
+    f->rng ^= f->rng >> 27;
+    return f->rng * 2685821657736338717ull;
+}
+
+static unsigned long long rnd_below(struct fixture *f, unsigned long long n) {
+    return n > 0 ? rnd(f) % n : 0;
+}
+
+/**
+ * @brief Creates the parent directories of a path relative to the tree root.
+ */
+static void make_parents(struct fixture *f, const char *path) {
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+    for (char *slash = strchr(dir, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        if (mkdirat(f->root_fd, dir, 0755) != 0 && errno != EEXIST) {
+            die(dir);
+        }
+        *slash = '/';
+    }
+}
+
+/**
+ * @brief Writes a file under the root, creating directories on the first ENOENT only.
+ */
+static void put_buf(struct fixture *f, const char *path, const char *data, size_t len) {
+    int fd = openat(f->root_fd, path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == ENOENT) {
+        make_parents(f, path);
+        fd = openat(f->root_fd, path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        die(path);
+    }
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0) {
+            die(path);
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    close(fd);
+    f->files++;
+}
+
+static void put_out(struct fixture *f, const char *path, struct out *o) {
+    put_buf(f, path, o->buf, o->len);
+    o->len = 0;
+}
+
+/**
+ * @brief Writes a small file whose contents are formatted printf-style.
+ */
+static void put(struct fixture *f, const char *path, const char *fmt, ...) {
+    char data[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(data, sizeof(data), fmt, ap);
+    va_end(ap);
+    put_buf(f, path, data, n < 0 ? 0 : (size_t)n < sizeof(data) ? (size_t)n : sizeof(data) - 1);
+}
+
+static void link_at(struct fixture *f, const char *target, const char *path) {
+    if (symlinkat(target, f->root_fd, path) == 0 || errno == EEXIST) {
+        return;
+    }
+    if (errno == ENOENT) {
+        make_parents(f, path);
+        if (symlinkat(target, f->root_fd, path) == 0) {
+            return;
+        }
+    }
+    die(path);
+}
+
+// Topology. CPU n is thread n / cores of core n % cores, as the kernel numbers SMT siblings on x86.
+
+static int cpu_core(const struct fixture *f, int cpu) {
+    return cpu % f->cores;
+}
+
+static int core_node(const struct fixture *f, int core) {
+    return (int)((long long)core * f->nodes / f->cores);
+}
+
+static int node_package(const struct fixture *f, int node) {
+    return (int)((long long)node * f->packages / f->nodes);
+}
+
+static int node_first_core(const struct fixture *f, int node) {
+    return (int)(((long long)node * f->cores + f->nodes - 1) / f->nodes);
+}
+
+static int package_first_core(const struct fixture *f, int package) {
+    int node = (int)(((long long)package * f->nodes + f->packages - 1) / f->packages);
+    return node_first_core(f, node);
+}
+
+/**
+ * @brief Appends "a-b" or "a" in the sysfs cpulist format.
+ */
+static void out_range(struct out *o, int first, int last) {
+    if (first == last) {
+        out_printf(o, "%d", first);
+    } else {
+        out_printf(o, "%d-%d", first, last);
+    }
+}
+
+/**
+ * @brief The CPUs of cores [first, last], every thread of each.
+ */
+static void out_cores(const struct fixture *f, struct out *o, int first, int last) {
+    for (int t = 0; t < f->threads; t++) {
+        if (t > 0) {
+            out_printf(o, ",");
+        }
+        out_range(o, first + t * f->cores, last + t * f->cores);
+    }
+    out_printf(o, "\n");
+}
+
+static void gen_cpus(struct fixture *f, struct out *o) {
+    static const char *const governors[] = { "performance", "powersave" };
+    static const char *const epps[] = { "performance", "balance_performance" };
+    char path[160];
+
+    put(f, "sys/devices/system/cpu/online", "0-%d\n", f->cpus - 1);
+    put(f, "sys/devices/system/cpu/possible", "0-%d\n", f->cpus - 1);
+
+    for (int cpu = 0; cpu < f->cpus; cpu++) {
+        int core = cpu_core(f, cpu);
+        int node = core_node(f, core);
+        int package = node_package(f, node);
+        int package_core = core - package_first_core(f, package);
+
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/topology/core_cpus_list", cpu);
+        out_cores(f, o, core, core);
+        put_out(f, path, o);
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+        out_cores(f, o, core, core);
+        put_out(f, path, o);
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+        put(f, path, "%d\n", package);
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/topology/die_id", cpu);
+        put(f, path, "0\n");
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+        put(f, path, "%d\n", package_core);
+
+        // L1d, L1i and L2 per core, L3 per node
+        static const struct {
+            int level;
+            const char *type;
+            const char *size;
+        } caches[] = {
+            { 1, "Data", "48K" }, { 1, "Instruction", "32K" }, { 2, "Unified", "2048K" }, { 3, "Unified", "107520K" }
+        };
+        for (int index = 0; index < 4; index++) {
+            snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+            put(f, path, "%d\n", caches[index].level);
+            snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, index);
+            put(f, path, "%s\n", caches[index].type);
+            snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/cache/index%d/size", cpu, index);
+            put(f, path, "%s\n", caches[index].size);
+            snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+            if (caches[index].level < 3) {
+                out_cores(f, o, core, core);
+            } else {
+                out_cores(f, o, node_first_core(f, node), node_first_core(f, node + 1) - 1);
+            }
+            put_out(f, path, o);
+        }
+
+        // One cpufreq policy per CPU, as intel_pstate has; cpuN/cpufreq links to it
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpufreq/policy%d/cpuinfo_max_freq", cpu);
+        put(f, path, "3800000\n");
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpufreq/policy%d/base_frequency", cpu);
+        put(f, path, "2100000\n");
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpufreq/policy%d/scaling_cur_freq", cpu);
+        put(f, path, "%llu\n", 800000 + rnd_below(f, 3000) * 1000);
+        // A few stragglers, so the audit has more than one value to group
+        int odd = cpu % 64 == 63;
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpufreq/policy%d/scaling_governor", cpu);
+        put(f, path, "%s\n", governors[odd]);
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpufreq/policy%d/energy_performance_preference", cpu);
+        put(f, path, "%s\n", epps[odd]);
+        char target[32];
+        snprintf(target, sizeof(target), "../cpufreq/policy%d", cpu);
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/cpufreq", cpu);
+        link_at(f, target, path);
+
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/thermal_throttle/core_throttle_count", cpu);
+        put(f, path, "%llu\n", rnd_below(f, 4) == 0 ? rnd_below(f, 100) : 0);
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/cpu%d/thermal_throttle/package_throttle_count", cpu);
+        put(f, path, "0\n");
+    }
+}
+
+static void gen_nodes(struct fixture *f, struct out *o) {
+    static const unsigned long long hugepage_kb[] = { 2048, 1048576 };
+    char path[160];
+
+    put(f, "sys/devices/system/node/online", "0-%d\n", f->nodes - 1);
+    put(f, "sys/devices/system/node/possible", "0-%d\n", f->nodes - 1);
+
+    for (int node = 0; node < f->nodes; node++) {
+        snprintf(path, sizeof(path), "sys/devices/system/node/node%d/cpulist", node);
+        out_cores(f, o, node_first_core(f, node), node_first_core(f, node + 1) - 1);
+        put_out(f, path, o);
+
+        unsigned long long free_kb = NODE_MEMORY_KB / 4 + rnd_below(f, NODE_MEMORY_KB / 2);
+        snprintf(path, sizeof(path), "sys/devices/system/node/node%d/meminfo", node);
+        out_printf(o, "Node %d MemTotal:       %llu kB\n", node, NODE_MEMORY_KB);
+        out_printf(o, "Node %d MemFree:        %llu kB\n", node, free_kb);
+        out_printf(o, "Node %d MemUsed:        %llu kB\n", node, NODE_MEMORY_KB - free_kb);
+        out_printf(o, "Node %d Active:         %llu kB\n", node, (NODE_MEMORY_KB - free_kb) / 2);
+        out_printf(o, "Node %d Inactive:       %llu kB\n", node, (NODE_MEMORY_KB - free_kb) / 3);
+        out_printf(o, "Node %d FilePages:      %llu kB\n", node, (NODE_MEMORY_KB - free_kb) / 3);
+        out_printf(o, "Node %d AnonPages:      %llu kB\n", node, (NODE_MEMORY_KB - free_kb) / 2);
+        out_printf(o, "Node %d HugePages_Total:  1024\n", node);
+        out_printf(o, "Node %d HugePages_Free:    512\n", node);
+        out_printf(o, "Node %d HugePages_Surp:      0\n", node);
+        put_out(f, path, o);
+
+        for (size_t s = 0; s < sizeof(hugepage_kb) / sizeof(hugepage_kb[0]); s++) {
+            static const char *const attrs[] = { "nr_hugepages", "free_hugepages", "surplus_hugepages" };
+            static const unsigned long long values[][3] = { { 1024, 512, 0 }, { 4, 4, 0 } };
+            for (size_t a = 0; a < 3; a++) {
+                snprintf(path, sizeof(path), "sys/devices/system/node/node%d/hugepages/hugepages-%llukB/%s", node,
+                         hugepage_kb[s], attrs[a]);
+                put(f, path, "%llu\n", values[s][a]);
+            }
+        }
+    }
+
+    for (size_t s = 0; s < sizeof(hugepage_kb) / sizeof(hugepage_kb[0]); s++) {
+        static const char *const attrs[] = { "nr_hugepages", "free_hugepages", "resv_hugepages", "surplus_hugepages" };
+        static const unsigned long long values[][4] = { { 1024, 512, 64, 0 }, { 4, 4, 0, 0 } };
+        for (size_t a = 0; a < 4; a++) {
+            snprintf(path, sizeof(path), "sys/kernel/mm/hugepages/hugepages-%llukB/%s", hugepage_kb[s], attrs[a]);
+            put(f, path, "%llu\n", values[s][a] * (unsigned long long)f->nodes);
+        }
+    }
+
+    // Node 0 has the low zones, like a real x86 host
+    static const char *const types[] = { "Unmovable", "Movable", "Reclaimable", "HighAtomic", "Isolate" };
+    struct out blocks = { 0 };
+    out_printf(o, "Page block order: 9\nPages per block:  512\n\n");
+    out_printf(o, "Free pages count per migrate type at order       0      1      2      3      4      5      6      7"
+                  "      8      9     10 \n");
+    out_printf(&blocks, "\nNumber of blocks type     Unmovable      Movable  Reclaimable   HighAtomic      Isolate \n");
+    struct out buddy = { 0 };
+    for (int node = 0; node < f->nodes; node++) {
+        static const char *const zones[] = { "DMA", "DMA32", "Normal" };
+        for (int z = node == 0 ? 0 : 2; z < 3; z++) {
+            out_printf(&buddy, "Node %d, zone %8s", node, zones[z]);
+            for (int order = 0; order <= 10; order++) {
+                out_printf(&buddy, " %6llu", rnd_below(f, z == 2 ? 40000 >> (order / 2) : 8));
+            }
+            out_printf(&buddy, " \n");
+
+            for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+                out_printf(o, "Node %4d, zone %8s, type %12s", node, zones[z], types[t]);
+                for (int order = 0; order <= 10; order++) {
+                    out_printf(o, " %6llu", t < 3 ? rnd_below(f, 10000 >> (order / 2)) : 0);
+                }
+                out_printf(o, " \n");
+            }
+            unsigned long long zone_blocks = z == 2 ? NODE_MEMORY_KB / 2048 : z == 1 ? 1024 : 8;
+            out_printf(&blocks, "Node %d, zone %8s %12llu %12llu %12llu %12d %12d \n", node, zones[z], zone_blocks / 20,
+                       zone_blocks - zone_blocks / 20 - zone_blocks / 40, zone_blocks / 40, 0, 0);
+        }
+    }
+    out_printf(o, "%.*s", (int)blocks.len, blocks.buf);
+    put_out(f, "proc/pagetypeinfo", o);
+    put_out(f, "proc/buddyinfo", &buddy);
+    free(blocks.buf);
+    free(buddy.buf);
+}
+
+static void gen_cpu_proc(struct fixture *f, struct out *o) {
+    for (int cpu = 0; cpu < f->cpus; cpu++) {
+        int core = cpu_core(f, cpu);
+        int package = node_package(f, core_node(f, core));
+        out_printf(o,
+                   "processor\t: %d\nvendor_id\t: GenuineIntel\ncpu family\t: 6\nmodel\t\t: 207\n"
+                   "model name\t: Intel(R) Xeon(R) Platinum 8592+\nstepping\t: 2\nmicrocode\t: 0x21000230\n"
+                   "cpu MHz\t\t: %llu.000\ncache size\t: 327680 KB\nphysical id\t: %d\nsiblings\t: %d\n"
+                   "core id\t\t: %d\ncpu cores\t: %d\napicid\t\t: %d\ninitial apicid\t: %d\nfpu\t\t: yes\n"
+                   "fpu_exception\t: yes\ncpuid level\t: 32\nwp\t\t: yes\n"
+                   "flags\t\t: fpu vme de pse tsc msr pae mce cx8 apic sep mtrr pge mca cmov pat pse36 clflush dts acpi "
+                   "mmx fxsr sse sse2 ss ht tm pbe syscall nx pdpe1gb rdtscp lm constant_tsc art arch_perfmon pebs bts "
+                   "rep_good nopl xtopology nonstop_tsc cpuid aperfmperf tsc_known_freq pni pclmulqdq dtes64 monitor "
+                   "ds_cpl vmx smx est tm2 ssse3 sdbg fma cx16 xtpr pdcm pcid dca sse4_1 sse4_2 x2apic movbe popcnt "
+                   "tsc_deadline_timer aes xsave avx f16c rdrand lahf_lm abm 3dnowprefetch cpuid_fault epb cat_l3 "
+                   "cat_l2 cdp_l3 intel_ppin cdp_l2 ssbd mba ibrs ibpb stibp ibrs_enhanced fsgsbase tsc_adjust bmi1 "
+                   "hle avx2 smep bmi2 erms invpcid rtm cqm rdt_a avx512f avx512dq rdseed adx smap avx512ifma "
+                   "clflushopt clwb intel_pt avx512cd sha_ni avx512bw avx512vl xsaveopt xsavec xgetbv1 xsaves "
+                   "avx_vnni avx512_bf16 wbnoinvd dtherm ida arat pln pts hfi avx512vbmi umip pku ospke waitpkg "
+                   "avx512_vbmi2 gfni vaes vpclmulqdq avx512_vnni avx512_bitalg tme avx512_vpopcntdq la57 rdpid "
+                   "bus_lock_detect cldemote movdiri movdir64b enqcmd fsrm md_clear serialize tsxldtrk pconfig "
+                   "arch_lbr ibt amx_bf16 avx512_fp16 amx_tile amx_int8 flush_l1d arch_capabilities\n"
+                   "bugs\t\t: spectre_v1 spectre_v2 spec_store_bypass swapgs eibrs_pbrsb bhi\n"
+                   "bogomips\t: 3800.00\nclflush size\t: 64\ncache_alignment\t: 64\n"
+                   "address sizes\t: 52 bits physical, 57 bits virtual\npower management:\n\n",
+                   cpu, 800 + rnd_below(f, 3000), package, f->cpus / f->packages, core - package_first_core(f, package),
+                   f->cores / f->packages, cpu * 2, cpu * 2);
+    }
+    put_out(f, "proc/cpuinfo", o);
+
+    unsigned long long total[8] = { 0 };
+    struct out per_cpu = { 0 };
+    for (int cpu = 0; cpu < f->cpus; cpu++) {
+        unsigned long long v[8] = { 1000000 + rnd_below(f, 500000), rnd_below(f, 2000), 200000 + rnd_below(f, 90000),
+                                    90000000 + rnd_below(f, 9000000), rnd_below(f, 40000), 0, rnd_below(f, 9000), 0 };
+        out_printf(&per_cpu, "cpu%d %llu %llu %llu %llu %llu %llu %llu %llu 0 0\n", cpu, v[0], v[1], v[2], v[3], v[4], v[5],
+                   v[6], v[7]);
+        for (int i = 0; i < 8; i++) {
+            total[i] += v[i];
+        }
+    }
+    out_printf(o, "cpu  %llu %llu %llu %llu %llu %llu %llu %llu 0 0\n", total[0], total[1], total[2], total[3], total[4],
+               total[5], total[6], total[7]);
+    out_printf(o, "%.*s", (int)per_cpu.len, per_cpu.buf);
+    free(per_cpu.buf);
+    out_printf(o, "intr %llu", 900000000ull * (unsigned long long)f->cpus / 64);
+    for (int irq = 0; irq < 64; irq++) {
+        out_printf(o, " %llu", rnd_below(f, 4) == 0 ? rnd_below(f, 10000000) : 0);
+    }
+    out_printf(o, "\nctxt %llu\nbtime 1790000000\nprocesses %llu\nprocs_running %d\nprocs_blocked %d\n",
+               4000000000ull + rnd_below(f, 1000000000), 60000000ull + (unsigned long long)f->pids,
+               1 + f->cpus / 8, f->cpus / 64);
+    out_printf(o, "softirq %llu 0 %llu 1 %llu 0 0 1 %llu 0 %llu\n", 800000000ull, rnd_below(f, 100000000),
+               rnd_below(f, 100000000), rnd_below(f, 100000000), rnd_below(f, 100000000));
+    put_out(f, "proc/stat", o);
+
+    unsigned long long total_kb = NODE_MEMORY_KB * (unsigned long long)f->nodes;
+    unsigned long long free_kb = total_kb / 2;
+    out_printf(o,
+               "MemTotal:       %llu kB\nMemFree:        %llu kB\nMemAvailable:   %llu kB\nBuffers:        %llu kB\n"
+               "Cached:         %llu kB\nSwapCached:            0 kB\nActive:         %llu kB\nInactive:       %llu kB\n"
+               "SwapTotal:      %llu kB\nSwapFree:       %llu kB\nDirty:              %llu kB\nWriteback:             0 kB\n"
+               "AnonPages:      %llu kB\nMapped:         %llu kB\nShmem:          %llu kB\nSlab:           %llu kB\n"
+               "SReclaimable:   %llu kB\nSUnreclaim:     %llu kB\nKernelStack:    %llu kB\nPageTables:     %llu kB\n"
+               "CommitLimit:    %llu kB\nCommitted_AS:   %llu kB\nVmallocTotal:   13743895347199 kB\n"
+               "AnonHugePages:  %llu kB\nHugePages_Total:   %d\nHugePages_Free:    %d\nHugePages_Rsvd:    %d\n"
+               "HugePages_Surp:        0\nHugepagesize:       2048 kB\nHugetlb:        %llu kB\n",
+               total_kb, free_kb, free_kb + total_kb / 8, total_kb / 100, total_kb / 8, total_kb / 4, total_kb / 6,
+               total_kb / 32, total_kb / 32, rnd_below(f, 100000), total_kb / 5, total_kb / 20, total_kb / 100,
+               total_kb / 50, total_kb / 100, total_kb / 100, 16ull * (unsigned long long)f->pids,
+               total_kb / 400, total_kb / 2 + total_kb / 32, total_kb / 3, total_kb / 20, 1024 * f->nodes,
+               512 * f->nodes, 64 * f->nodes, 2048ull * 1024 * (unsigned long long)f->nodes);
+    put_out(f, "proc/meminfo", o);
+
+    unsigned long long pages = total_kb / 4;
+    out_printf(o,
+               "nr_free_pages %llu\nnr_zone_inactive_anon %llu\nnr_zone_active_anon %llu\nnr_zone_inactive_file %llu\n"
+               "nr_zone_active_file %llu\nnr_mlock 0\nnr_dirty %llu\nnr_writeback 0\nnr_shmem %llu\n",
+               pages / 2, pages / 8, pages / 10, pages / 12, pages / 9, rnd_below(f, 20000), pages / 100);
+    out_printf(o,
+               "pgpgin %llu\npgpgout %llu\npswpin %llu\npswpout %llu\npgalloc_normal %llu\npgfree %llu\n"
+               "pgfault %llu\npgmajfault %llu\npgscan_kswapd %llu\npgscan_direct %llu\npgsteal_kswapd %llu\n"
+               "pgsteal_direct %llu\noom_kill %llu\ncompact_stall %llu\nthp_fault_alloc %llu\n"
+               "thp_fault_fallback %llu\nthp_collapse_alloc %llu\nthp_collapse_alloc_failed %llu\n",
+               rnd(f) >> 24, rnd(f) >> 24, rnd_below(f, 1000), rnd_below(f, 1000), rnd(f) >> 20, rnd(f) >> 20,
+               rnd(f) >> 20, rnd_below(f, 1000000), rnd_below(f, 10000000), rnd_below(f, 100000),
+               rnd_below(f, 10000000), rnd_below(f, 100000), rnd_below(f, 3), rnd_below(f, 1000),
+               rnd_below(f, 10000000), rnd_below(f, 10000), rnd_below(f, 100000), rnd_below(f, 100));
+    put_out(f, "proc/vmstat", o);
+}
+
+static void gen_misc(struct fixture *f) {
+    static const char *const vulns[][2] = {
+        { "spectre_v1", "Mitigation: usercopy/swapgs barriers and __user pointer sanitization" },
+        { "spectre_v2", "Mitigation: Enhanced / Automatic IBRS; IBPB: conditional; RSB filling; PBRSB-eIBRS: SW sequence; "
+                        "BHI: BHI_DIS_S" },
+        { "meltdown", "Not affected" },
+        { "mds", "Not affected" },
+        { "l1tf", "Not affected" },
+        { "spec_store_bypass", "Mitigation: Speculative Store Bypass disabled via prctl" },
+        { "retbleed", "Not affected" },
+        { "gather_data_sampling", "Not affected" },
+    };
+    char path[160];
+    for (size_t i = 0; i < sizeof(vulns) / sizeof(vulns[0]); i++) {
+        snprintf(path, sizeof(path), "sys/devices/system/cpu/vulnerabilities/%s", vulns[i][0]);
+        put(f, path, "%s\n", vulns[i][1]);
+    }
+    put(f, "sys/class/dmi/id/sys_vendor", "Synthetic\n");
+    put(f, "sys/class/dmi/id/product_name", "Fixture %d-socket\n", f->packages);
+
+    put(f, "etc/os-release", "PRETTY_NAME=\"Debian GNU/Linux 12 (bookworm)\"\nNAME=\"Debian GNU/Linux\"\nVERSION_ID=\"12\"\n"
+                             "VERSION=\"12 (bookworm)\"\nID=debian\n");
+    put(f, "etc/hostname", "fixture-%dc\n", f->cpus);
+    put(f, "proc/version", "Linux version 6.12.0-fixture (builder@fixture) (gcc (GCC) 14.2.0, GNU ld (GNU Binutils) 2.43) "
+                           "#1 SMP PREEMPT_DYNAMIC\n");
+    put(f, "proc/cmdline", "BOOT_IMAGE=/vmlinuz-6.12.0 root=UUID=00000000-0000-0000-0000-000000000000 ro quiet "
+                           "transparent_hugepage=madvise\n");
+    put(f, "proc/uptime", "%llu.%02llu %llu.00\n", 3000000 + rnd_below(f, 100000), rnd_below(f, 100),
+        3000000ull * (unsigned long long)f->cpus);
+    put(f, "proc/loadavg", "%d.%02d %d.%02d %d.%02d %d/%d %d\n", f->cpus / 3, 17, f->cpus / 3, 40, f->cpus / 4, 2,
+        1 + f->cpus / 8, f->pids, 4 * f->pids);
+    static const char *const pressure[] = { "proc/pressure/cpu", "proc/pressure/memory", "proc/pressure/io" };
+    for (size_t i = 0; i < 3; i++) {
+        put(f, pressure[i], "some avg10=%.2f avg60=%.2f avg300=%.2f total=%llu\nfull avg10=0.00 avg60=0.00 avg300=0.00 "
+                            "total=%llu\n",
+            (double)rnd_below(f, 500) / 100.0, (double)rnd_below(f, 300) / 100.0, (double)rnd_below(f, 200) / 100.0,
+            rnd(f) >> 30, i == 0 ? 0 : rnd(f) >> 34);
+    }
+
+    put(f, "proc/sys/vm/swappiness", "60\n");
+    put(f, "proc/sys/vm/dirty_ratio", "20\n");
+    put(f, "proc/sys/vm/dirty_background_ratio", "10\n");
+    put(f, "proc/sys/vm/dirty_bytes", "0\n");
+    put(f, "proc/sys/vm/dirty_background_bytes", "0\n");
+    put(f, "proc/sys/fs/file-nr", "%d\t0\t9223372036854775807\n", 16 * f->pids);
+    put(f, "sys/kernel/mm/transparent_hugepage/enabled", "always [madvise] never\n");
+    put(f, "sys/kernel/mm/transparent_hugepage/defrag", "always defer defer+madvise [madvise] never\n");
+    put(f, "sys/devices/system/clocksource/clocksource0/current_clocksource", "tsc\n");
+}
+
+/**
+ * @brief One zone, hwmon chip and RAPL domain per package; coretemp has an input per core, as on real hosts.
+ */
+static void gen_thermal(struct fixture *f) {
+    char path[160];
+    for (int package = 0; package < f->packages; package++) {
+        snprintf(path, sizeof(path), "sys/class/thermal/thermal_zone%d/type", package);
+        put(f, path, "x86_pkg_temp\n");
+        snprintf(path, sizeof(path), "sys/class/thermal/thermal_zone%d/temp", package);
+        put(f, path, "%llu\n", 40000 + rnd_below(f, 30000));
+        snprintf(path, sizeof(path), "sys/class/thermal/thermal_zone%d/trip_point_0_type", package);
+        put(f, path, "passive\n");
+        snprintf(path, sizeof(path), "sys/class/thermal/thermal_zone%d/trip_point_0_temp", package);
+        put(f, path, "100000\n");
+
+        snprintf(path, sizeof(path), "sys/class/hwmon/hwmon%d/name", package);
+        put(f, path, "coretemp\n");
+        // Index 1 is the package sensor, then one per core
+        int first = package_first_core(f, package);
+        int cores = package_first_core(f, package + 1) - first;
+        for (int index = 1; index <= cores + 1; index++) {
+            snprintf(path, sizeof(path), "sys/class/hwmon/hwmon%d/temp%d_input", package, index);
+            put(f, path, "%llu\n", 40000 + rnd_below(f, 30000));
+            snprintf(path, sizeof(path), "sys/class/hwmon/hwmon%d/temp%d_crit", package, index);
+            put(f, path, "100000\n");
+            snprintf(path, sizeof(path), "sys/class/hwmon/hwmon%d/temp%d_label", package, index);
+            if (index == 1) {
+                put(f, path, "Package id %d\n", package);
+            } else {
+                put(f, path, "Core %d\n", index - 2);
+            }
+        }
+
+        snprintf(path, sizeof(path), "sys/class/powercap/intel-rapl:%d/name", package);
+        put(f, path, "package-%d\n", package);
+        snprintf(path, sizeof(path), "sys/class/powercap/intel-rapl:%d/energy_uj", package);
+        put(f, path, "%llu\n", rnd_below(f, 262143328850ull));
+        snprintf(path, sizeof(path), "sys/class/powercap/intel-rapl:%d/max_energy_range_uj", package);
+        put(f, path, "262143328850\n");
+        snprintf(path, sizeof(path), "sys/class/powercap/intel-rapl:%d:0/name", package);
+        put(f, path, "dram\n");
+        snprintf(path, sizeof(path), "sys/class/powercap/intel-rapl:%d:0/energy_uj", package);
+        put(f, path, "%llu\n", rnd_below(f, 65712999613ull));
+        snprintf(path, sizeof(path), "sys/class/powercap/intel-rapl:%d:0/max_energy_range_uj", package);
+        put(f, path, "65712999613\n");
+    }
+}
+
+static void gen_disks(struct fixture *f, struct out *o) {
+    char path[160];
+    int minor = 0;
+    for (int disk = 0; disk < f->disks; disk++) {
+        char name[32];
+        snprintf(name, sizeof(name), "nvme%dn1", disk);
+        // The whole disk and two partitions; partitions are not under /sys/block
+        for (int part = 0; part <= 2; part++) {
+            unsigned long long reads = rnd(f) >> 40;
+            unsigned long long writes = rnd(f) >> 40;
+            out_printf(o, "%4d %7d %s%s%.0d %llu %llu %llu %llu %llu %llu %llu %llu 0 %llu %llu 0 0 0 0 %llu %llu\n", 259,
+                       minor++, name, part > 0 ? "p" : "", part, reads, reads / 50, reads * 16, reads / 4, writes,
+                       writes / 10, writes * 24, writes / 2, (reads + writes) / 8, (reads + writes) / 3,
+                       rnd_below(f, 100000), rnd_below(f, 1000000));
+        }
+        snprintf(path, sizeof(path), "sys/block/%s/queue/rotational", name);
+        put(f, path, "0\n");
+        snprintf(path, sizeof(path), "sys/block/%s/queue/nr_requests", name);
+        put(f, path, "1023\n");
+        snprintf(path, sizeof(path), "sys/block/%s/queue/scheduler", name);
+        put(f, path, "[none] mq-deadline kyber bfq\n");
+    }
+    put_out(f, "proc/diskstats", o);
+}
+
+static void gen_nics(struct fixture *f, struct out *o) {
+    char path[160];
+    out_printf(o, "Inter-|   Receive                                                |  Transmit\n"
+                  " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls "
+                  "carrier compressed\n");
+    for (int i = 0; i < f->nics; i++) {
+        char name[32];
+        long speed;
+        int mtu;
+        int ifindex = i + 1;
+        if (i == 0) {
+            snprintf(name, sizeof(name), "lo");
+            speed = -1;
+            mtu = 65536;
+        } else if (i <= PHYSICAL_NICS) {
+            snprintf(name, sizeof(name), "ens%df0np0", i);
+            speed = 100000;
+            mtu = 9000;
+        } else {
+            snprintf(name, sizeof(name), "veth%07llx", rnd(f) >> 36);
+            speed = 10000;
+            mtu = 1500;
+            // Container churn: every veth pair takes two ifindexes, so a long-lived host is well past 4096,
+            // and these land on the same ifindex % 4096 as the physical NICs
+            ifindex = 4096 + 2 * (i - PHYSICAL_NICS);
+        }
+        unsigned long long rx = rnd(f) >> 24;
+        unsigned long long tx = rnd(f) >> 24;
+        out_printf(o,
+                   "%6s: %llu %llu %llu %llu    0     0          0 %llu %llu %llu %llu %llu    0     0       0"
+                   "          0\n",
+                   name, rx, rx / 900, rnd_below(f, 4) == 0 ? rnd_below(f, 100) : 0, rnd_below(f, 1000),
+                   rnd_below(f, 10000), tx, tx / 900, 0ull, rnd_below(f, 10));
+
+        snprintf(path, sizeof(path), "sys/class/net/%s/mtu", name);
+        put(f, path, "%d\n", mtu);
+        snprintf(path, sizeof(path), "sys/class/net/%s/ifindex", name);
+        put(f, path, "%d\n", ifindex);
+        snprintf(path, sizeof(path), "sys/class/net/%s/operstate", name);
+        put(f, path, "%s\n", i == 0 ? "unknown" : rnd_below(f, 20) == 0 ? "down" : "up");
+        if (speed > 0) {
+            snprintf(path, sizeof(path), "sys/class/net/%s/speed", name);
+            put(f, path, "%ld\n", speed);
+        }
+    }
+    put_out(f, "proc/net/dev", o);
+}
+
+static void gen_mounts(struct fixture *f, struct out *o) {
+    out_printf(o, "22 1 259:2 / / rw,relatime shared:1 - ext4 /dev/nvme0n1p2 rw\n"
+                  "23 22 0:22 / /proc rw,nosuid,nodev,noexec,relatime shared:12 - proc proc rw\n"
+                  "24 22 0:23 / /sys rw,nosuid,nodev,noexec,relatime shared:7 - sysfs sysfs rw\n"
+                  "25 24 0:27 / /sys/fs/cgroup rw,nosuid,nodev,noexec,relatime shared:9 - cgroup2 cgroup2 "
+                  "rw,nsdelegate,memory_recursiveprot\n"
+                  "26 22 0:5 / /dev rw,nosuid,relatime shared:2 - devtmpfs udev rw,size=65536k,nr_inodes=1048576,mode=755\n"
+                  "27 22 0:25 / /run rw,nosuid,nodev,noexec,relatime shared:5 - tmpfs tmpfs rw,size=26214400k,mode=755\n");
+    // The rest is what fills mountinfo on container hosts: overlay roots with their own /proc, /dev/shm and secrets
+    for (int i = BASE_MOUNTS, id = 28; i < f->mounts; i++, id++) {
+        int container = (i - BASE_MOUNTS) / 4;
+        char overlay[96];
+        snprintf(overlay, sizeof(overlay), "/var/lib/containers/storage/overlay/%016llx",
+                 (unsigned long long)container * 0x9e3779b97f4a7c15ull);
+        switch ((i - BASE_MOUNTS) % 4) {
+        case 0:
+            out_printf(o,
+                       "%d 22 0:%d / %s/merged rw,relatime - overlay overlay rw,lowerdir=/var/lib/containers/storage/"
+                       "overlay/l/A%d,upperdir=%s/diff,workdir=%s/work\n",
+                       id, 100 + i, overlay, container, overlay, overlay);
+            break;
+        case 1:
+            out_printf(o, "%d %d 0:%d / %s/merged/proc rw,nosuid,nodev,noexec,relatime - proc proc rw\n", id, id - 1,
+                       100 + i, overlay);
+            break;
+        case 2:
+            out_printf(o, "%d %d 0:%d / %s/merged/dev/shm rw,nosuid,nodev,noexec,relatime - tmpfs shm rw,size=65536k\n", id,
+                       id - 2, 100 + i, overlay);
+            break;
+        default:
+            out_printf(o, "%d %d 259:2 /var/lib/kubelet/pods/%08x/volumes %s/merged/run/secrets ro,relatime - ext4 "
+                          "/dev/nvme0n1p2 rw\n",
+                       id, id - 3, (unsigned)container, overlay);
+            break;
+        }
+    }
+    put_out(f, "proc/self/mountinfo", o);
+
+    put(f, "proc/self/cgroup", "0::/system.slice/bling.service\n");
+    put(f, "sys/fs/cgroup/system.slice/memory.max", "max\n");
+    put(f, "sys/fs/cgroup/system.slice/cpu.max", "max 100000\n");
+    put(f, "sys/fs/cgroup/system.slice/bling.service/memory.max", "8589934592\n");
+    put(f, "sys/fs/cgroup/system.slice/bling.service/cpu.max", "400000 100000\n");
+    put(f, "sys/fs/cgroup/system.slice/bling.service/memory.current", "%llu\n", 1000000000 + rnd_below(f, 1000000000));
+    put(f, "sys/fs/cgroup/system.slice/bling.service/memory.stat",
+        "anon %llu\nfile %llu\nkernel %llu\nshmem 0\nfile_mapped %llu\nfile_dirty %llu\nactive_anon %llu\n"
+        "inactive_anon 0\nactive_file %llu\ninactive_file %llu\nslab %llu\npgfault %llu\npgmajfault %llu\n",
+        rnd_below(f, 500000000), rnd_below(f, 500000000), rnd_below(f, 50000000), rnd_below(f, 50000000),
+        rnd_below(f, 1000000), rnd_below(f, 500000000), rnd_below(f, 300000000), rnd_below(f, 200000000),
+        rnd_below(f, 40000000), rnd_below(f, 100000000), rnd_below(f, 10000));
+    put(f, "sys/fs/cgroup/system.slice/bling.service/cpu.stat",
+        "usage_usec %llu\nuser_usec %llu\nsystem_usec %llu\nnr_periods %llu\nnr_throttled %llu\nthrottled_usec %llu\n",
+        rnd(f) >> 28, rnd(f) >> 29, rnd(f) >> 30, rnd_below(f, 10000000), rnd_below(f, 10000), rnd_below(f, 100000000));
+}
+
+/**
+ * @brief /proc/<pid>/stat for every PID, and TCP/UDP tables with a socket per few processes.
+ */
+static void gen_procs(struct fixture *f, struct out *o) {
+    static const char *const comms[] = { "java", "postgres", "nginx", "python3", "containerd-shim", "node", "envoy",
+                                         "bash", "sshd", "redis-server", "(sd-pam)", "Web Content" };
+    char path[32];
+    char comm[32];
+    int pid = 1;
+    int kernel_threads = f->cpus * 4 < f->pids / 2 ? f->cpus * 4 : f->pids / 2;
+
+    for (int i = 0; i < f->pids; i++) {
+        int ppid;
+        if (i == 0) {
+            snprintf(comm, sizeof(comm), "systemd");
+            ppid = 0;
+        } else if (i <= kernel_threads) {
+            // Per-CPU kernel threads: two kworkers, ksoftirqd and migration for each
+            static const char *const kthreads[] = { "kworker/%d:0-events", "kworker/%d:1H", "ksoftirqd/%d", "migration/%d" };
+            snprintf(comm, sizeof(comm), kthreads[(i - 1) % 4], (i - 1) / 4);
+            ppid = 2;
+        } else {
+            snprintf(comm, sizeof(comm), "%s", comms[rnd_below(f, sizeof(comms) / sizeof(comms[0]))]);
+            ppid = 1;
+        }
+        char state = rnd_below(f, 50) == 0 ? 'R' : rnd_below(f, 200) == 0 ? 'D' : i <= kernel_threads ? 'I' : 'S';
+        int user = i > kernel_threads;
+        unsigned long long utime = user ? rnd_below(f, 1000000) : 0;
+        unsigned long long stime = rnd_below(f, 100000);
+
+        out_printf(o,
+                   "%d (%s) %c %d %d %d 0 -1 %u %llu 0 %llu 0 %llu %llu 0 0 20 0 %llu 0 %llu %llu %llu "
+                   "18446744073709551615 %s 0 0 0 0 0 %u 0 0 0 17 %llu 0 0 0 0 0 %s 0\n",
+                   pid, comm, state, ppid, pid, pid, user ? 4194560u : 2129984u, rnd(f) >> 44, rnd(f) >> 52, utime,
+                   stime, user ? 1 + rnd_below(f, 64) : 1, rnd_below(f, 300000000),
+                   user ? (rnd(f) >> 30) + 10000000 : 0, user ? rnd_below(f, 2000000) : 0,
+                   user ? "94000000000000 94000000100000 140720000000000" : "0 0 0", user ? 0u : 2147483647u,
+                   rnd_below(f, (unsigned long long)f->cpus),
+                   user ? "94000000200000 94000000300000 94000100000000 140720000001000 140720000001100 "
+                          "140720000001100 140720000002000"
+                        : "0 0 0 0 0 0 0");
+        snprintf(path, sizeof(path), "proc/%d/stat", pid);
+        put_out(f, path, o);
+        // PIDs are sparse on a long-running host
+        pid += 1 + (int)rnd_below(f, 4);
+    }
+
+    static const struct {
+        const char *path;
+        int ipv6;
+        int tcp;
+        int divisor; // One socket per this many processes
+    } tables[] = {
+        { "proc/net/tcp", 0, 1, 4 },
+        { "proc/net/tcp6", 1, 1, 8 },
+        { "proc/net/udp", 0, 0, 32 },
+        { "proc/net/udp6", 1, 0, 64 },
+    };
+    for (size_t t = 0; t < sizeof(tables) / sizeof(tables[0]); t++) {
+        int addr_width = tables[t].ipv6 ? 32 : 8;
+        out_printf(o, "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n");
+        int count = f->pids / tables[t].divisor;
+        for (int i = 0; i < count; i++) {
+            // TCP: mostly ESTABLISHED (01), some LISTEN (0A) and TIME_WAIT (06). UDP: unconnected (07).
+            unsigned long long r = rnd_below(f, 20);
+            int state = !tables[t].tcp ? 7 : r < 15 ? 1 : r < 17 ? 10 : 6;
+            out_printf(o, "%4d: %0*llX:%04X %0*llX:%04X %02X %08X:%08X 00:00000000 00000000 %5llu        0 %llu 1 "
+                          "0000000000000000 100 0 0 10 0\n",
+                       i, addr_width, 0x0100000Aull + (rnd_below(f, 256) << 24), (unsigned)(1024 + rnd_below(f, 60000)),
+                       addr_width, state == 10 || state == 7 ? 0ull : 0x0200000Aull + (rnd_below(f, 256) << 24),
+                       state == 10 || state == 7 ? 0u : (unsigned)(1024 + rnd_below(f, 60000)), state,
+                       (unsigned)rnd_below(f, 4096), 0u, rnd_below(f, 2000), 100000 + rnd_below(f, 100000000));
+        }
+        put_out(f, tables[t].path, o);
+    }
+}
+
+/**
+ * @brief Scales a maximum by f, keeping at least min.
+ */
+static int scaled(double scale, int max, int min) {
+    int n = (int)(max * scale + 0.5);
+    return n < min ? min : n > max ? max : n;
+}
+
+int main(int argc, char **argv) {
+    const char *usage =
+        "usage: bling-fixturegen [--scale F] [--cpus N] [--nodes N] [--pids N] [--mounts N] [--nics N] [--disks N]\n"
+        "                        [--seed N] DIR\n"
+        "  Writes a synthetic procfs/sysfs tree under DIR (created if missing; existing files are overwritten).\n"
+        "  --scale F: fraction of the largest host, 4096 CPUs, 64 nodes, 200000 PIDs, 20000 mounts,\n"
+        "    1000 NICs and 1024 disks (default 1). The other options override single dimensions.\n";
+    struct fixture f = {
+        .scale = 1.0, .cpus = -1, .nodes = -1, .pids = -1, .mounts = -1, .nics = -1, .disks = -1, .seed = 1
+    };
+    const char *dir = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        int *value = NULL;
+        if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+            f.scale = strtod(argv[++i], NULL);
+            if (f.scale <= 0.0 || f.scale > 1.0) {
+                fprintf(stderr, "bling-fixturegen: --scale must be in (0, 1]\n");
+                return 1;
+            }
+            continue;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            f.seed = strtoull(argv[++i], NULL, 10);
+            continue;
+        } else if (strcmp(argv[i], "--cpus") == 0) {
+            value = &f.cpus;
+        } else if (strcmp(argv[i], "--nodes") == 0) {
+            value = &f.nodes;
+        } else if (strcmp(argv[i], "--pids") == 0) {
+            value = &f.pids;
+        } else if (strcmp(argv[i], "--mounts") == 0) {
+            value = &f.mounts;
+        } else if (strcmp(argv[i], "--nics") == 0) {
+            value = &f.nics;
+        } else if (strcmp(argv[i], "--disks") == 0) {
+            value = &f.disks;
+        } else if (argv[i][0] != '-' && dir == NULL) {
+            dir = argv[i];
+            continue;
+        }
+        if (value == NULL || i + 1 >= argc || (*value = atoi(argv[++i])) <= 0) {
+            fprintf(stderr, "%s", usage);
+            return 1;
+        }
+    }
+    if (dir == NULL) {
+        fprintf(stderr, "%s", usage);
+        return 1;
+    }
+
+    f.cpus = f.cpus > 0 ? f.cpus : scaled(f.scale, MAX_CPUS, 2);
+    f.cpus = f.cpus > MAX_CPUS ? MAX_CPUS : f.cpus;
+    f.threads = f.cpus >= 2 ? 2 : 1;
+    f.cpus -= f.cpus % f.threads;
+    f.cores = f.cpus / f.threads;
+    f.nodes = f.nodes > 0 ? f.nodes : scaled(f.scale, MAX_NODES, 1);
+    f.nodes = f.nodes > f.cores ? f.cores : f.nodes;
+    f.packages = f.nodes > 1 ? f.nodes / 2 : 1;
+    f.pids = f.pids > 0 ? f.pids : scaled(f.scale, MAX_PIDS, 16);
+    f.mounts = f.mounts > 0 ? f.mounts : scaled(f.scale, MAX_MOUNTS, BASE_MOUNTS);
+    f.nics = f.nics > 0 ? f.nics : scaled(f.scale, MAX_NICS, 2);
+    f.disks = f.disks > 0 ? f.disks : scaled(f.scale, MAX_DISKS, 1);
+    f.rng = f.seed * 0x9e3779b97f4a7c15ull | 1;
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        die(dir);
+    }
+    f.root_fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (f.root_fd < 0) {
+        die(dir);
+    }
+
+    struct out o = { 0 };
+    gen_cpus(&f, &o);
+    gen_nodes(&f, &o);
+    gen_cpu_proc(&f, &o);
+    gen_misc(&f);
+    gen_thermal(&f);
+    gen_disks(&f, &o);
+    gen_nics(&f, &o);
+    gen_mounts(&f, &o);
+    gen_procs(&f, &o);
+    free(o.buf);
+
+    // Last, so a tree with a manifest is known to be complete
+    put(&f, FIXTURE_MANIFEST, "scale %g\ncpus %d\nnodes %d\npids %d\nmounts %d\nnics %d\ndisks %d\nseed %llu\n", f.scale,
+        f.cpus, f.nodes, f.pids, f.mounts, f.nics, f.disks, f.seed);
+    close(f.root_fd);
+
+    printf("%s: %d CPUs, %d nodes, %d PIDs, %d mounts, %d NICs, %d disks (%zu files)\n", dir, f.cpus, f.nodes, f.pids,
+           f.mounts, f.nics, f.disks, f.files);
+    return 0;
+}
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _GNU_SOURCE // strndup(), O_TMPFILE
+
+#include "instrument.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+static struct instrument_counts counts;
+static __thread struct instrument_counts thread_counts;
+
+// Relaxed: the counters are only read between benchmark iterations, after the threads joined
+#define COUNT(field, n) (__atomic_add_fetch(&counts.field, (n), __ATOMIC_RELAXED), thread_counts.field += (n))
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+char *__real_strdup(const char *s);
+char *__real_strndup(const char *s, size_t n);
+int __real_posix_memalign(void **out, size_t alignment, size_t size);
+int __real_open(const char *path, int flags, ...);
+int __real_openat(int dirfd, const char *path, int flags, ...);
+FILE *__real_fopen(const char *path, const char *mode);
+DIR *__real_opendir(const char *path);
+ssize_t __real_read(int fd, void *buf, size_t count);
+ssize_t __real_pread(int fd, void *buf, size_t count, off_t offset);
+char *__real_fgets(char *s, int size, FILE *stream);
+
+void *__wrap_malloc(size_t size) {
+    COUNT(allocs, 1);
+    COUNT(alloc_bytes, size);
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    COUNT(allocs, 1);
+    COUNT(alloc_bytes, count * size);
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    COUNT(allocs, 1);
+    COUNT(alloc_bytes, size);
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr != NULL) {
+        COUNT(frees, 1);
+    }
+    __real_free(ptr);
+}
+
+// __real_strdup must be libc's: its internal malloc is not wrapped, so each copy counts once. A strdup of
+// bling's own would call the wrapped malloc and count twice.
+char *__wrap_strdup(const char *s) {
+    COUNT(allocs, 1);
+    COUNT(alloc_bytes, strlen(s) + 1);
+    return __real_strdup(s);
+}
+
+char *__wrap_strndup(const char *s, size_t n) {
+    COUNT(allocs, 1);
+    COUNT(alloc_bytes, strnlen(s, n) + 1);
+    return __real_strndup(s, n);
+}
+
+int __wrap_posix_memalign(void **out, size_t alignment, size_t size) {
+    COUNT(allocs, 1);
+    COUNT(alloc_bytes, size);
+    return __real_posix_memalign(out, alignment, size);
+}
+
+/**
+ * @brief The mode argument of open/openat, present only when the flags create a file.
+ */
+static mode_t open_mode(int flags, va_list ap) {
+    return flags & (O_CREAT | O_TMPFILE) ? (mode_t)va_arg(ap, unsigned int) : 0;
+}
+
+int __wrap_open(const char *path, int flags, ...) {
+    va_list ap;
+    va_start(ap, flags);
+    mode_t mode = open_mode(flags, ap);
+    va_end(ap);
+    COUNT(opens, 1);
+    return __real_open(path, flags, mode);
+}
+
+int __wrap_openat(int dirfd, const char *path, int flags, ...) {
+    va_list ap;
+    va_start(ap, flags);
+    mode_t mode = open_mode(flags, ap);
+    va_end(ap);
+    COUNT(opens, 1);
+    return __real_openat(dirfd, path, flags, mode);
+}
+
+FILE *__wrap_fopen(const char *path, const char *mode) {
+    COUNT(opens, 1);
+    return __real_fopen(path, mode);
+}
+
+DIR *__wrap_opendir(const char *path) {
+    COUNT(opens, 1);
+    return __real_opendir(path);
+}
+
+ssize_t __wrap_read(int fd, void *buf, size_t count) {
+    ssize_t n = __real_read(fd, buf, count);
+    COUNT(reads, 1);
+    COUNT(read_bytes, n > 0 ? (unsigned long long)n : 0);
+    return n;
+}
+
+ssize_t __wrap_pread(int fd, void *buf, size_t count, off_t offset) {
+    ssize_t n = __real_pread(fd, buf, count, offset);
+    COUNT(reads, 1);
+    COUNT(read_bytes, n > 0 ? (unsigned long long)n : 0);
+    return n;
+}
+
+/**
+ * @brief stdio's own read() calls are internal to libc, so lines() is counted by what fgets hands back.
+ */
+char *__wrap_fgets(char *s, int size, FILE *stream) {
+    char *line = __real_fgets(s, size, stream);
+    COUNT(reads, 1);
+    COUNT(read_bytes, line != NULL ? strlen(line) : 0);
+    return line;
+}
+
+void instrument_read(struct instrument_counts *out) {
+    out->allocs = __atomic_load_n(&counts.allocs, __ATOMIC_RELAXED);
+    out->alloc_bytes = __atomic_load_n(&counts.alloc_bytes, __ATOMIC_RELAXED);
+    out->frees = __atomic_load_n(&counts.frees, __ATOMIC_RELAXED);
+    out->opens = __atomic_load_n(&counts.opens, __ATOMIC_RELAXED);
+    out->reads = __atomic_load_n(&counts.reads, __ATOMIC_RELAXED);
+    out->read_bytes = __atomic_load_n(&counts.read_bytes, __ATOMIC_RELAXED);
+}
+
+void instrument_read_thread(struct instrument_counts *out) {
+    *out = thread_counts;
+}
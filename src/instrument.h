@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+/*
+ * Counting shim for instrumented builds (bling-bench and bling-instrumented).
+ *
+ * instrument.c defines __wrap_ versions of the allocation and open calls, and the binary is
+ * linked with -Wl,--wrap=<symbol> for each one, so every call made from bling code (libbling
+ * included) goes through a counter before reaching libc. Calls libc makes internally
+ * (stdio buffers, opendir's own allocation) are not counted. The regular bling binary and
+ * libbling are never linked with the shim.
+ */
+
+struct instrument_counts {
+    unsigned long long allocs; // malloc, calloc, realloc, strdup, strndup, posix_memalign
+    unsigned long long alloc_bytes;
+    unsigned long long frees;
+    unsigned long long opens; // open, openat, fopen, opendir
+    unsigned long long reads; // read, pread, fgets
+    unsigned long long read_bytes;
+};
+
+/**
+ * @brief Process-wide totals since startup, from all threads.
+ */
+void instrument_read(struct instrument_counts *out);
+
+/**
+ * @brief Totals for the calling thread only, so work on one collector thread can be told apart from the others.
+ *
+ * libbling holds a weak reference to this: it is NULL unless the binary links instrument.c.
+ */
+void instrument_read_thread(struct instrument_counts *out);
+
+#endif // INSTRUMENT_H
@@ -0,0 +1,521 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _GNU_SOURCE // O_DIRECT, O_TMPFILE, syscall()
+
+#include "ioprobe.h"
+#include "bling.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+#if defined(IORING_OFF_SQ_RING) && defined(__NR_io_uring_setup)
+#define HAVE_IO_URING 1
+#endif
+
+#define MIN_FREE_PCT 10
+#define ALIGN 4096
+
+/*
+ * Latency histogram with HDR-style log-linear buckets: each power of two is split into
+ * HIST_SUB linear sub-buckets, so any recorded value is within 1/HIST_SUB (3%) of its bucket
+ * at a fixed 15 KiB, from nanoseconds to hours.
+ */
+#define HIST_SUB_BITS 5
+#define HIST_SUB (1u << HIST_SUB_BITS)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 1) * HIST_SUB)
+
+struct histogram {
+    unsigned long long counts[HIST_BUCKETS];
+    unsigned long long total;
+    uint64_t max;
+};
+
+static unsigned int hist_index(uint64_t v) {
+    if (v < HIST_SUB) {
+        return (unsigned int)v;
+    }
+    unsigned int shift = (unsigned int)(63 - __builtin_clzll(v)) - HIST_SUB_BITS;
+    return ((shift + 1) << HIST_SUB_BITS) + (unsigned int)(v >> shift) - HIST_SUB;
+}
+
+/**
+ * @brief Middle of the range of values that land in bucket i.
+ */
+static double hist_value(unsigned int i) {
+    unsigned int bucket = i >> HIST_SUB_BITS;
+    if (bucket == 0) {
+        return i;
+    }
+    unsigned int shift = bucket - 1;
+    uint64_t low = (uint64_t)((i & (HIST_SUB - 1)) + HIST_SUB) << shift;
+    return (double)low + (double)(1ull << shift) / 2.0;
+}
+
+static void hist_record(struct histogram *h, uint64_t v) {
+    h->counts[hist_index(v)]++;
+    h->total++;
+    h->max = v > h->max ? v : h->max;
+}
+
+static void hist_merge(struct histogram *dst, const struct histogram *src) {
+    for (unsigned int i = 0; i < HIST_BUCKETS; i++) {
+        dst->counts[i] += src->counts[i];
+    }
+    dst->total += src->total;
+    dst->max = src->max > dst->max ? src->max : dst->max;
+}
+
+static double hist_percentile(const struct histogram *h, double pct) {
+    unsigned long long rank = (unsigned long long)(pct / 100.0 * (double)h->total + 0.5);
+    rank = rank < 1 ? 1 : rank;
+    unsigned long long seen = 0;
+    for (unsigned int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            double v = hist_value(i);
+            return v > (double)h->max ? (double)h->max : v;
+        }
+    }
+    return (double)h->max;
+}
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static uint64_t xorshift(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+/**
+ * @brief One test: what to issue, where, and until when.
+ */
+struct job {
+    int fd;
+    int write;
+    int random;
+    size_t block;
+    size_t size; // Offsets stay below this
+    int wrap;    // Sequential tests start over at the end; the first write stops there instead
+    long long deadline_ns;
+
+    size_t cursor; // Next sequential offset, shared by the pthreads workers
+    int error;
+    struct histogram hist;
+};
+
+/**
+ * @brief Next offset for the job, or (size_t)-1 when a non-wrapping pass is complete.
+ */
+static size_t job_offset(struct job *job, uint64_t *rng) {
+    if (job->random) {
+        return (size_t)(xorshift(rng) % (job->size / job->block)) * job->block;
+    }
+    size_t off = __atomic_fetch_add(&job->cursor, job->block, __ATOMIC_RELAXED);
+    if (off + job->block > job->size) {
+        if (!job->wrap) {
+            return (size_t)-1;
+        }
+        off %= job->size - job->size % job->block;
+    }
+    return off;
+}
+
+struct pthread_worker {
+    pthread_t thread;
+    struct job *job;
+    char *buf;
+    uint64_t rng;
+    struct histogram hist;
+};
+
+static void *pthread_worker_main(void *arg) {
+    struct pthread_worker *w = arg;
+    struct job *job = w->job;
+
+    while (!__atomic_load_n(&job->error, __ATOMIC_RELAXED)) {
+        long long start = now_ns();
+        if (start >= job->deadline_ns) {
+            break;
+        }
+        size_t off = job_offset(job, &w->rng);
+        if (off == (size_t)-1) {
+            break;
+        }
+        ssize_t n = job->write ? pwrite(job->fd, w->buf, job->block, (off_t)off)
+                               : pread(job->fd, w->buf, job->block, (off_t)off);
+        if (n != (ssize_t)job->block) {
+            __atomic_store_n(&job->error, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        hist_record(&w->hist, (uint64_t)(now_ns() - start));
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs the job on IOPROBE_QUEUE_DEPTH threads, each with one synchronous request in flight.
+ */
+static int run_pthreads(struct job *job, char *bufs) {
+    struct pthread_worker *workers = calloc(IOPROBE_QUEUE_DEPTH, sizeof(*workers));
+    if (workers == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+
+    int started = 0;
+    for (; started < IOPROBE_QUEUE_DEPTH; started++) {
+        struct pthread_worker *w = &workers[started];
+        w->job = job;
+        w->buf = bufs + (size_t)started * job->block;
+        w->rng = 0x9e3779b97f4a7c15ull * (uint64_t)(started + 1);
+        if (pthread_create(&w->thread, NULL, pthread_worker_main, w) != 0) {
+            break;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        hist_merge(&job->hist, &workers[i].hist);
+    }
+    free(workers);
+    return started > 0 ? BLING_OK : BLING_ERR_NOMEM;
+}
+
+#ifdef HAVE_IO_URING
+
+/**
+ * @brief A raw io_uring, mapped by hand so there is no liburing dependency.
+ */
+struct uring {
+    int fd;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ring;
+    size_t sq_ring_size;
+    void *cq_ring;
+    size_t cq_ring_size;
+    size_t sqes_size;
+};
+
+static void uring_close(struct uring *u) {
+    if (u->sqes != NULL && u->sqes != MAP_FAILED) {
+        munmap(u->sqes, u->sqes_size);
+    }
+    if (u->cq_ring != NULL && u->cq_ring != MAP_FAILED && u->cq_ring != u->sq_ring) {
+        munmap(u->cq_ring, u->cq_ring_size);
+    }
+    if (u->sq_ring != NULL && u->sq_ring != MAP_FAILED) {
+        munmap(u->sq_ring, u->sq_ring_size);
+    }
+    close(u->fd);
+}
+
+/**
+ * @brief Sets up a ring, or fails when the kernel predates 5.1 or io_uring is disabled
+ * (kernel.io_uring_disabled, seccomp in most container runtimes).
+ */
+static int uring_open(struct uring *u, unsigned int entries) {
+    memset(u, 0, sizeof(*u));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    u->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (u->fd < 0) {
+        return BLING_ERR_NOTFOUND;
+    }
+
+    u->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    u->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        u->sq_ring_size = u->cq_ring_size > u->sq_ring_size ? u->cq_ring_size : u->sq_ring_size;
+    }
+    u->sq_ring = mmap(NULL, u->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                      IORING_OFF_SQ_RING);
+    if (u->sq_ring == MAP_FAILED) {
+        uring_close(u);
+        return BLING_ERR_IO;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        u->cq_ring = u->sq_ring;
+    } else {
+        u->cq_ring = mmap(NULL, u->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                          IORING_OFF_CQ_RING);
+    }
+    u->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+    if (u->cq_ring == MAP_FAILED || u->sqes == MAP_FAILED) {
+        uring_close(u);
+        return BLING_ERR_IO;
+    }
+
+    char *sq = u->sq_ring;
+    char *cq = u->cq_ring;
+    u->sq_tail = (unsigned int *)(sq + params.sq_off.tail);
+    u->sq_mask = (unsigned int *)(sq + params.sq_off.ring_mask);
+    u->sq_array = (unsigned int *)(sq + params.sq_off.array);
+    u->cq_head = (unsigned int *)(cq + params.cq_off.head);
+    u->cq_tail = (unsigned int *)(cq + params.cq_off.tail);
+    u->cq_mask = (unsigned int *)(cq + params.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return BLING_OK;
+}
+
+static void uring_queue(struct uring *u, const struct job *job, struct iovec *iov, unsigned int slot, size_t off) {
+    unsigned int tail = *u->sq_tail;
+    unsigned int index = tail & *u->sq_mask;
+    struct io_uring_sqe *sqe = &u->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    // READV/WRITEV rather than READ/WRITE: the only ops every io_uring kernel (5.1+) has
+    sqe->opcode = job->write ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = job->fd;
+    sqe->off = off;
+    sqe->addr = (uint64_t)(uintptr_t)iov;
+    sqe->len = 1;
+    sqe->user_data = slot;
+    u->sq_array[index] = index;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Runs the job with IOPROBE_QUEUE_DEPTH requests in flight on one thread.
+ */
+static int run_uring(struct uring *u, struct job *job, char *bufs) {
+    struct iovec iov[IOPROBE_QUEUE_DEPTH];
+    long long started_ns[IOPROBE_QUEUE_DEPTH];
+    uint64_t rng = 0x9e3779b97f4a7c15ull;
+    unsigned int to_submit = 0;
+    unsigned int in_flight = 0;
+
+    for (unsigned int slot = 0; slot < IOPROBE_QUEUE_DEPTH; slot++) {
+        size_t off = job_offset(job, &rng);
+        if (off == (size_t)-1) {
+            break;
+        }
+        iov[slot].iov_base = bufs + (size_t)slot * job->block;
+        iov[slot].iov_len = job->block;
+        started_ns[slot] = now_ns();
+        uring_queue(u, job, &iov[slot], slot, off);
+        to_submit++;
+        in_flight++;
+    }
+
+    int status = BLING_OK;
+    while (in_flight > 0) {
+        int ret = (int)syscall(__NR_io_uring_enter, u->fd, to_submit, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        if (ret < 0 && errno != EINTR) {
+            // Submitted requests still DMA into bufs, which the caller frees once we return, and closing the
+            // ring does not wait for them: queue nothing more and drain. A failed enter submitted nothing.
+            status = BLING_ERR_IO;
+            job->error = 1;
+            in_flight -= to_submit;
+            to_submit = 0;
+            if (in_flight > 0) {
+                // Completions are posted to the shared CQ ring even if enter keeps failing; poll it
+                struct timespec pause = { .tv_sec = 0, .tv_nsec = 1000000 };
+                nanosleep(&pause, NULL);
+            }
+        }
+        if (ret >= 0) {
+            to_submit = (unsigned int)ret < to_submit ? to_submit - (unsigned int)ret : 0;
+        }
+
+        unsigned int head = *u->cq_head;
+        unsigned int tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+        long long now = now_ns();
+        for (; head != tail; head++) {
+            const struct io_uring_cqe *cqe = &u->cqes[head & *u->cq_mask];
+            unsigned int slot = (unsigned int)cqe->user_data;
+            in_flight--;
+            if (cqe->res != (int)job->block) {
+                job->error = 1;
+                continue;
+            }
+            hist_record(&job->hist, (uint64_t)(now - started_ns[slot]));
+
+            size_t off = job->error || now >= job->deadline_ns ? (size_t)-1 : job_offset(job, &rng);
+            if (off != (size_t)-1) {
+                started_ns[slot] = now;
+                uring_queue(u, job, &iov[slot], slot, off);
+                to_submit++;
+                in_flight++;
+            }
+        }
+        __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    }
+    return status;
+}
+
+#endif // HAVE_IO_URING
+
+/**
+ * @brief An unlinked file in dir: O_TMPFILE where the filesystem supports it, else mkstemp + unlink.
+ */
+static int open_temp(const char *dir, int *direct) {
+    int fd = open(dir, O_TMPFILE | O_RDWR | O_DIRECT, 0600);
+    if (fd < 0 && errno == EINVAL) {
+        fd = open(dir, O_TMPFILE | O_RDWR, 0600); // No O_DIRECT (tmpfs) or no O_TMPFILE
+    }
+    if (fd < 0) {
+        char path[320];
+        snprintf(path, sizeof(path), "%s/.bling-ioprobe-XXXXXX", dir);
+        fd = mkstemp(path);
+        if (fd < 0) {
+            return -1;
+        }
+        unlink(path);
+    }
+
+    int flags = fcntl(fd, F_GETFL);
+    if (!(flags & O_DIRECT) && fcntl(fd, F_SETFL, flags | O_DIRECT) == 0) {
+        flags |= O_DIRECT;
+    }
+    *direct = (flags & O_DIRECT) != 0;
+    return fd;
+}
+
+const char *ioprobe_test_name(enum ioprobe_test test) {
+    static const char *const names[IOPROBE_TESTS] = {
+        [IOPROBE_SEQ_WRITE] = "seq write",
+        [IOPROBE_SEQ_READ] = "seq read",
+        [IOPROBE_RAND_READ] = "rand read",
+        [IOPROBE_RAND_WRITE] = "rand write",
+    };
+    return test < IOPROBE_TESTS ? names[test] : "unknown";
+}
+
+int ioprobe_run(struct ioprobe *p, const char *dir, size_t size_mb, long budget_ms) {
+    memset(p, 0, sizeof(*p));
+    snprintf(p->dir, sizeof(p->dir), "%s", dir);
+    p->budget_ms = budget_ms > 0 ? budget_ms : IOPROBE_DEFAULT_BUDGET_MS;
+    long long start = now_ns();
+
+    struct stat st;
+    struct statvfs sv;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || statvfs(dir, &sv) != 0) {
+        return BLING_ERR_INVAL;
+    }
+
+    // Never push the filesystem below MIN_FREE_PCT, whatever was asked for
+    unsigned long long size = (unsigned long long)(size_mb > 0 ? size_mb : IOPROBE_DEFAULT_SIZE_MB) << 20;
+    unsigned long long avail = (unsigned long long)sv.f_bavail * sv.f_frsize;
+    unsigned long long reserve = (unsigned long long)sv.f_blocks * sv.f_frsize / 100 * MIN_FREE_PCT;
+    unsigned long long room = avail > reserve ? avail - reserve : 0;
+    size = size < room ? size : room;
+    size -= size % IOPROBE_SEQ_BLOCK;
+    if (size < IOPROBE_SEQ_BLOCK) {
+        return BLING_ERR_INVAL;
+    }
+
+    int fd = open_temp(dir, &p->direct);
+    if (fd < 0) {
+        return BLING_ERR_INVAL;
+    }
+
+    char *bufs = NULL;
+    if (posix_memalign((void **)&bufs, ALIGN, (size_t)IOPROBE_QUEUE_DEPTH * IOPROBE_SEQ_BLOCK) != 0) {
+        close(fd);
+        return BLING_ERR_NOMEM;
+    }
+    // Incompressible, so thin-provisioned and compressing storage cannot shortcut the writes
+    uint64_t rng = (uint64_t)start | 1;
+    for (size_t i = 0; i < (size_t)IOPROBE_QUEUE_DEPTH * IOPROBE_SEQ_BLOCK / sizeof(uint64_t); i++) {
+        ((uint64_t *)bufs)[i] = xorshift(&rng);
+    }
+
+    struct job *job = malloc(sizeof(*job));
+    if (job == NULL) {
+        free(bufs);
+        close(fd);
+        return BLING_ERR_NOMEM;
+    }
+
+#ifdef HAVE_IO_URING
+    struct uring ring;
+    int have_uring = uring_open(&ring, IOPROBE_QUEUE_DEPTH) == BLING_OK;
+#else
+    int have_uring = 0;
+#endif
+    p->engine = have_uring ? "io_uring" : "pthreads";
+
+    long long share_ns = p->budget_ms * 1000000LL / IOPROBE_TESTS;
+    int status = BLING_OK;
+    for (int t = 0; t < IOPROBE_TESTS && status == BLING_OK; t++) {
+        memset(job, 0, sizeof(*job));
+        job->fd = fd;
+        job->write = t == IOPROBE_SEQ_WRITE || t == IOPROBE_RAND_WRITE;
+        job->random = t == IOPROBE_RAND_READ || t == IOPROBE_RAND_WRITE;
+        job->block = job->random ? IOPROBE_RAND_BLOCK : IOPROBE_SEQ_BLOCK;
+        // The first pass stops at the end of the file; the rest stay inside what it wrote, since
+        // reading holes or unwritten extents never reaches the device
+        job->size = t == IOPROBE_SEQ_WRITE ? (size_t)size : p->file_bytes;
+        job->wrap = t != IOPROBE_SEQ_WRITE;
+
+        long long t_start = now_ns();
+        job->deadline_ns = t_start + share_ns;
+#ifdef HAVE_IO_URING
+        status = have_uring ? run_uring(&ring, job, bufs) : run_pthreads(job, bufs);
+#else
+        status = run_pthreads(job, bufs);
+#endif
+        double secs = (double)(now_ns() - t_start) / 1e9;
+
+        struct ioprobe_result *r = &p->results[t];
+        r->ops = job->hist.total;
+        r->failed = job->error;
+        if (secs > 0.0) {
+            r->iops = (double)r->ops / secs;
+            r->mbps = r->iops * (double)job->block / 1e6;
+        }
+        if (r->ops > 0) {
+            r->p50_us = hist_percentile(&job->hist, 50.0) / 1000.0;
+            r->p99_us = hist_percentile(&job->hist, 99.0) / 1000.0;
+            r->max_us = (double)job->hist.max / 1000.0;
+        }
+
+        if (t == IOPROBE_SEQ_WRITE) {
+            p->file_bytes = (size_t)r->ops * IOPROBE_SEQ_BLOCK;
+            if (p->file_bytes == 0) {
+                status = BLING_ERR_IO; // Not a single block written: nothing to read back
+            }
+        }
+    }
+
+#ifdef HAVE_IO_URING
+    if (have_uring) {
+        uring_close(&ring);
+    }
+#endif
+    free(job);
+    free(bufs);
+    close(fd);
+    p->elapsed_ms = (now_ns() - start) / 1000000;
+    return status;
+}
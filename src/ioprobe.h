@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef IOPROBE_H
+#define IOPROBE_H
+
+#include <stddef.h>
+
+#define IOPROBE_DEFAULT_SIZE_MB 64
+#define IOPROBE_DEFAULT_BUDGET_MS 2000
+#define IOPROBE_QUEUE_DEPTH 16
+#define IOPROBE_SEQ_BLOCK (1u << 20)
+#define IOPROBE_RAND_BLOCK 4096u
+
+enum ioprobe_test {
+    IOPROBE_SEQ_WRITE, // First: it also fills the file the other tests read back
+    IOPROBE_SEQ_READ,
+    IOPROBE_RAND_READ,
+    IOPROBE_RAND_WRITE,
+    IOPROBE_TESTS
+};
+
+struct ioprobe_result {
+    unsigned long long ops;
+    double mbps; // 10^6 bytes per second, as disk vendors count
+    double iops;
+    double p50_us; // Per request, queueing included
+    double p99_us;
+    double max_us;
+    int failed; // An I/O error ended the test early; the numbers cover what completed
+};
+
+/**
+ * @brief A bounded storage benchmark on an unlinked temp file.
+ */
+struct ioprobe {
+    char dir[256];
+    const char *engine; // "io_uring" or "pthreads"
+    int direct;         // O_DIRECT; 0 when the filesystem refuses it (tmpfs) and the page cache was measured
+    size_t file_bytes;  // How much the sequential write got down within its share of the budget
+    long budget_ms;
+    struct ioprobe_result results[IOPROBE_TESTS];
+    long long elapsed_ms;
+};
+
+/**
+ * @brief Runs sequential and 4K random read/write tests on a temp file under dir.
+ *
+ * The file is created with O_TMPFILE (or unlinked right after creation), so nothing is left
+ * behind even if the process dies. It is at most size_mb, and only if that leaves 10% of the
+ * filesystem free. Each of the four tests gets a quarter of budget_ms.
+ *
+ * @return BLING_OK, BLING_ERR_INVAL when dir is not a writable directory or is too full for
+ *         even one sequential block, BLING_ERR_IO when nothing could be written.
+ */
+int ioprobe_run(struct ioprobe *p, const char *dir, size_t size_mb, long budget_ms);
+
+const char *ioprobe_test_name(enum ioprobe_test test);
+
+#endif // IOPROBE_H
@@ -0,0 +1,630 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "report.h"
+#include "mounts.h"
+
+#include <stdio.h>
+
+/**
+ * @brief Prints s as a JSON string literal, or null.
+ */
+static void json_string(const char *s) {
+    if (s == NULL) {
+        printf("null");
+        return;
+    }
+
+    putchar('"');
+    for (const unsigned char *c = (const unsigned char *)s; *c != '\0'; c++) {
+        switch (*c) {
+        case '"':
+            printf("\\\"");
+            break;
+        case '\\':
+            printf("\\\\");
+            break;
+        case '\n':
+            printf("\\n");
+            break;
+        case '\t':
+            printf("\\t");
+            break;
+        default:
+            if (*c < 0x20) {
+                printf("\\u%04x", *c);
+            } else {
+                putchar(*c);
+            }
+        }
+    }
+    putchar('"');
+}
+
+static void json_key(const char *key) {
+    json_string(key);
+    putchar(':');
+}
+
+static void json_stale(const bling_snapshot *snap) {
+    static const struct {
+        const char *name;
+        unsigned int field;
+    } fields[] = {
+        { "hostname", BLING_FIELD_HOSTNAME }, { "os", BLING_FIELD_OS },     { "kernel", BLING_FIELD_KERNEL },
+        { "mem", BLING_FIELD_MEM },           { "disk", BLING_FIELD_DISK }, { "cpu", BLING_FIELD_CPU },
+        { "uptime", BLING_FIELD_UPTIME },
+    };
+
+    json_key("stale");
+    putchar('[');
+    int first = 1;
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+        if (bling_field_stale(snap, fields[i].field) || bling_field_status(snap, fields[i].field) == BLING_ERR_TIMEOUT) {
+            printf(first ? "" : ",");
+            json_string(fields[i].name);
+            first = 0;
+        }
+    }
+    putchar(']');
+}
+
+static void json_cpu(const struct report *r) {
+    bling_snapshot *snap = r->snap;
+
+    printf(",");
+    json_key("cpu");
+    printf("{");
+    json_key("name");
+    json_string(bling_cpu_name(snap));
+    printf(",\"logical\":%d,\"max_khz\":%d", bling_cpu_count(snap), bling_cpu_max_khz(snap));
+    if (r->topo != NULL) {
+        printf(",\"sockets\":%d,\"dies\":%d,\"cores\":%d,\"threads\":%d,\"numa_nodes\":%d", r->topo->sockets,
+               r->topo->dies, r->topo->cores, r->topo->cpus, r->topo->node_count);
+    }
+    if (r->cpustat != NULL) {
+        const struct cpustat *cs = r->cpustat;
+        printf(",\"usage\":{\"busy\":%.2f,\"user\":%.2f,\"system\":%.2f,\"iowait\":%.2f,\"irq\":%.2f,\"softirq\":%.2f,"
+               "\"steal\":%.2f,\"since_boot\":%s}",
+               cs->all_busy, cs->all_pct[CPU_USER], cs->all_pct[CPU_SYSTEM], cs->all_pct[CPU_IOWAIT], cs->all_pct[CPU_IRQ],
+               cs->all_pct[CPU_SOFTIRQ], cs->all_pct[CPU_STEAL], cs->samples < 2 ? "true" : "false");
+    }
+    printf("}");
+}
+
+static void json_psi_line(const char *name, const struct psi_line *line, int live) {
+    json_key(name);
+    printf("{\"avg10\":%.2f,\"avg60\":%.2f,\"avg300\":%.2f,\"total_us\":%llu,\"rate\":", line->avg10, line->avg60,
+           line->avg300, line->total_us);
+    if (live) {
+        printf("%.2f}", line->rate);
+    } else {
+        printf("null}");
+    }
+}
+
+static void json_load(const struct pressure *pr) {
+    printf(",\"load\":{\"1m\":%.2f,\"5m\":%.2f,\"15m\":%.2f,\"running\":%llu,\"tasks\":%llu}", pr->load1, pr->load5,
+           pr->load15, pr->running, pr->tasks);
+
+    printf(",\"pressure\":{");
+    int first = 1;
+    for (int i = 0; i < PSI_RESOURCES; i++) {
+        const struct psi *psi = &pr->psi[i];
+        if (!psi->present) {
+            continue;
+        }
+        printf(first ? "" : ",");
+        json_key(psi_resource_names[i]);
+        printf("{");
+        json_psi_line("some", &psi->some, pr->samples >= 2);
+        printf(",");
+        json_psi_line("full", &psi->full, pr->samples >= 2);
+        printf("}");
+        first = 0;
+    }
+    printf("}");
+}
+
+static void json_vmstat(const struct vmstat *vm) {
+    printf(",\"vm\":{\"since_boot\":%s,\"rates\":{", vm->samples < 2 ? "true" : "false");
+    for (int c = 0; c < VM_COUNTERS; c++) {
+        if ((c == VM_CTXT || c == VM_FORKS) && !vm->has_sched) {
+            continue;
+        }
+        printf(c ? ",\"%s\":%.2f" : "\"%s\":%.2f", vmstat_name(c), vm->rates[c]);
+    }
+    printf("},\"totals\":{");
+    for (int c = 0; c < VM_COUNTERS; c++) {
+        if ((c == VM_CTXT || c == VM_FORKS) && !vm->has_sched) {
+            continue;
+        }
+        printf(c ? ",\"%s\":%llu" : "\"%s\":%llu", vmstat_name(c), vm->counters[c]);
+    }
+    printf("}}");
+}
+
+static void json_hugepage_pool(const struct hugepage_pool *pool) {
+    printf("{");
+    if (pool->node >= 0) {
+        printf("\"node\":%d,", pool->node);
+    }
+    printf("\"size_kb\":%llu,\"total\":%llu,\"free\":%llu,", pool->size_kb, pool->total, pool->free);
+    if (pool->node < 0) {
+        printf("\"reserved\":%llu,", pool->reserved);
+    }
+    printf("\"surplus\":%llu}", pool->surplus);
+}
+
+static void json_frag(const struct memfrag *mf) {
+    unsigned long long huge_free_kb;
+    double unusable;
+    memfrag_totals(mf, &huge_free_kb, &unusable);
+
+    printf(",\"frag\":{\"page_kb\":%d,\"huge_order\":%d,\"huge_free_kb\":%llu,\"unusable\":%.4f,\"hugepages\":[",
+           mf->page_kb, mf->huge_order, huge_free_kb, unusable);
+    for (int i = 0; i < mf->pool_count; i++) {
+        printf(i ? "," : "");
+        json_hugepage_pool(&mf->pools[i]);
+    }
+
+    printf("],\"zones\":[");
+    for (size_t z = 0; z < mf->zone_count; z++) {
+        const struct frag_zone *zone = &mf->zones[z];
+        printf("%s{\"node\":%d,", z ? "," : "", zone->node);
+        json_key("zone");
+        json_string(zone->name);
+        printf(",\"free\":[");
+        for (int o = 0; o < zone->orders; o++) {
+            printf(o ? ",%llu" : "%llu", zone->free[o]);
+        }
+        printf("],\"unusable\":%.4f,\"frag_index\":", zone->unusable);
+        if (zone->frag_index >= 0.0) {
+            printf("%.4f", zone->frag_index);
+        } else {
+            printf("null");
+        }
+        if (mf->has_pagetypes) {
+            printf(",\"pageblocks\":{");
+            for (int t = 0; t < FRAG_TYPES; t++) {
+                printf(t ? ",\"%s\":%llu" : "\"%s\":%llu", frag_type_names[t], zone->pageblocks[t]);
+            }
+            putchar('}');
+        }
+        putchar('}');
+    }
+    putchar(']');
+
+    if (mf->node_pool_count > 0) {
+        printf(",\"node_hugepages\":[");
+        for (size_t i = 0; i < mf->node_pool_count; i++) {
+            printf(i ? "," : "");
+            json_hugepage_pool(&mf->node_pools[i]);
+        }
+        putchar(']');
+    }
+    putchar('}');
+}
+
+static void json_thermal(const struct thermal *t) {
+    printf(",\"thermal\":{\"sensors\":[");
+    for (int i = 0, first = 1; i < t->sensor_count; i++) {
+        const struct thermal_sensor *s = &t->sensors[i];
+        if (!s->valid) {
+            continue;
+        }
+        printf(first ? "{" : ",{");
+        json_key("name");
+        json_string(s->name);
+        printf(",\"celsius\":%.1f,\"crit_celsius\":", s->celsius);
+        if (s->crit_celsius > 0.0) {
+            printf("%.1f}", s->crit_celsius);
+        } else {
+            printf("null}");
+        }
+        first = 0;
+    }
+    printf("],\"throttle\":{\"core\":%llu,\"package\":%llu,\"core_per_s\":%.3f,\"package_per_s\":%.3f,"
+           "\"since_boot\":%s}",
+           t->core_throttles, t->package_throttles, t->core_throttle_rate, t->package_throttle_rate,
+           t->samples < 2 ? "true" : "false");
+    printf(",\"rapl_denied\":%s,\"rapl\":[", t->rapl_denied ? "true" : "false");
+    for (int i = 0; i < t->rapl_count; i++) {
+        printf(i ? ",{" : "{");
+        json_key("name");
+        json_string(t->rapl[i].name);
+        printf(",\"energy_uj\":%llu,\"watts\":", t->rapl[i].energy_uj);
+        if (t->samples >= 2) {
+            printf("%.2f}", t->rapl[i].watts);
+        } else {
+            printf("null}");
+        }
+    }
+    printf("]}");
+}
+
+static void json_bench(const struct bench *b) {
+    printf(",\"bench\":{\"elapsed_ms\":%lld,\"stream\":[", b->elapsed_ms);
+    for (int i = 0; i < b->stream_count; i++) {
+        printf("%s{\"node\":%d,\"threads\":%d,\"gbps\":%.2f}", i ? "," : "", b->stream[i].node, b->stream[i].threads,
+               b->stream[i].gbps);
+    }
+    printf("],\"latency\":[");
+    for (int i = 0; i < b->latency_count; i++) {
+        printf("%s{", i ? "," : "");
+        json_key("level");
+        json_string(b->latency[i].label);
+        printf(",\"bytes\":%zu,\"ns\":%.2f}", b->latency[i].bytes, b->latency[i].ns);
+    }
+    printf("],\"threads\":%d,\"int_gops\":{\"single\":%.3f,\"all\":%.3f},\"fp_gflops\":{\"single\":%.3f,\"all\":%.3f}",
+           b->threads, b->int_single, b->int_all, b->fp_single, b->fp_all);
+    printf(",\"syscall_ns\":%.1f,\"vdso_ns\":%.1f}", b->syscall_ns, b->vdso_ns);
+}
+
+static void json_audit(const struct audit *a) {
+    static const char *const verdicts[] = { [AUDIT_OK] = "ok", [AUDIT_WARN] = "warn", [AUDIT_INFO] = "info" };
+
+    printf(",\"audit\":{");
+    json_key("profile");
+    json_string(audit_profile_name(a->profile));
+    printf(",\"elapsed_us\":%lld,\"findings\":[", a->elapsed_us);
+    for (size_t i = 0; i < a->count; i++) {
+        const struct audit_finding *f = &a->findings[i];
+        printf(i ? ",{" : "{");
+        json_key("knob");
+        json_string(f->knob);
+        printf(",");
+        json_key("value");
+        json_string(f->value);
+        if (f->policies > 0) {
+            printf(",\"policies\":%d", f->policies);
+        }
+        printf(",");
+        json_key("expected");
+        json_string(f->expected);
+        printf(",");
+        json_key("verdict");
+        json_string(verdicts[f->verdict]);
+        putchar('}');
+    }
+    printf("]}");
+}
+
+static void json_virt(const struct virt *v, const struct cpustat *cs) {
+    static const char *const states[] = {
+        [VULN_NOT_AFFECTED] = "not_affected", [VULN_MITIGATED] = "mitigated", [VULN_PARTIAL] = "partial",
+        [VULN_VULNERABLE] = "vulnerable",     [VULN_UNKNOWN] = "unknown",
+    };
+
+    printf(",\"virt\":{");
+    json_key("hypervisor");
+    json_string(v->source != NULL ? v->hypervisor : NULL);
+    printf(",");
+    json_key("source");
+    json_string(v->source);
+    printf(",\"dmi\":{");
+    json_key("vendor");
+    json_string(v->dmi_vendor[0] ? v->dmi_vendor : NULL);
+    printf(",");
+    json_key("product");
+    json_string(v->dmi_product[0] ? v->dmi_product : NULL);
+    putchar('}');
+    if (cs != NULL) {
+        int cpu;
+        float max = cpustat_max_pct(cs, CPU_STEAL, &cpu);
+        printf(",\"steal\":{\"pct\":%.2f,\"max_pct\":%.2f,\"max_cpu\":%d}", cs->all_pct[CPU_STEAL], max, cpu);
+    }
+    printf(",\"vulnerabilities\":[");
+    for (int i = 0; i < v->vuln_count; i++) {
+        printf(i ? ",{" : "{");
+        json_key("name");
+        json_string(v->vulns[i].name);
+        printf(",");
+        json_key("state");
+        json_string(states[v->vulns[i].state]);
+        printf(",");
+        json_key("status");
+        json_string(v->vulns[i].status);
+        putchar('}');
+    }
+    printf("]}");
+}
+
+static void json_cgroup(const struct cgroup *cg) {
+    printf(",\"cgroup\":{");
+    json_key("path");
+    json_string(cg->path);
+
+    if (cg->has_memory) {
+        printf(",\"mem\":{\"max\":");
+        if (cg->mem_max != CGROUP_UNLIMITED) {
+            printf("%llu", cg->mem_max);
+        } else {
+            printf("null");
+        }
+        printf(",\"current\":%llu,\"anon\":%llu,\"file\":%llu}", cg->mem_current, cg->mem_anon, cg->mem_file);
+    }
+
+    printf(",\"cpu\":{\"limit\":");
+    if (cg->cpu_limit > 0.0) {
+        printf("%.2f", cg->cpu_limit);
+    } else {
+        printf("null");
+    }
+    printf(",\"cpuset\":%d,\"effective\":%.2f,\"usage_usec\":%llu,\"nr_periods\":%llu,\"nr_throttled\":%llu,"
+           "\"throttled_usec\":%llu",
+           cg->cpuset_cpus, cgroup_effective_cpus(cg), cg->usage_usec, cg->nr_periods, cg->nr_throttled,
+           cg->throttled_usec);
+    if (cg->samples >= 2) {
+        printf(",\"delta\":{\"used_cpus\":%.2f,\"periods\":%llu,\"throttled\":%llu,\"throttled_usec\":%llu}",
+               cg->cpu_used, cg->delta_periods, cg->delta_throttled, cg->delta_throttled_usec);
+    } else {
+        printf(",\"delta\":null");
+    }
+    printf("}}");
+}
+
+static void json_procs(const char *key, const struct proc_info *procs, int count, int live) {
+    json_key(key);
+    putchar('[');
+    for (int i = 0; i < count; i++) {
+        const struct proc_info *p = &procs[i];
+        printf(i ? ",{\"pid\":%d," : "{\"pid\":%d,", p->pid);
+        json_key("comm");
+        json_string(p->comm);
+        printf(",\"rss_kb\":%llu,\"cpu_ticks\":%llu,\"cpu_pct\":", p->rss_kb, p->cpu_ticks);
+        if (live) {
+            printf("%.2f}", p->cpu_pct);
+        } else {
+            printf("null}");
+        }
+    }
+    putchar(']');
+}
+
+static void json_top(const struct proc_top *pt) {
+    int live = pt->samples >= 2;
+
+    printf(",\"top\":{\"scanned\":%zu,\"timed_out\":%zu,", pt->scanned, pt->timed_out);
+    json_procs("rss", pt->top_rss, pt->rss_count, live);
+    putchar(',');
+    json_procs("cpu", pt->top_cpu, pt->cpu_count, live);
+    putchar('}');
+}
+
+static void json_io(const struct diskstats *ds) {
+    printf(",\"io\":[");
+    int first = 1;
+    for (size_t i = 0; i < ds->count; i++) {
+        const struct disk_dev *d = &ds->devs[i];
+        if (!d->whole || d->counters[DISK_READS] + d->counters[DISK_WRITES] == 0) {
+            continue;
+        }
+
+        printf(first ? "{" : ",{");
+        json_key("name");
+        json_string(d->name);
+        printf(",\"rotational\":%s,", d->rotational ? "true" : "false");
+        json_key("scheduler");
+        json_string(d->scheduler);
+        printf(",\"nr_requests\":%d,\"read_iops\":%.2f,\"write_iops\":%.2f,\"read_bps\":%.0f,\"write_bps\":%.0f,"
+               "\"await_ms\":%.3f,\"queue_depth\":%.3f,\"util_pct\":%.2f,\"in_flight\":%llu,\"since_boot\":%s}",
+               d->nr_requests, d->read_iops, d->write_iops, d->read_bps, d->write_bps, d->await_ms, d->queue_depth,
+               d->util_pct, d->in_flight, ds->samples < 2 ? "true" : "false");
+        first = 0;
+    }
+    putchar(']');
+}
+
+static void json_ioprobe(const struct ioprobe *p) {
+    printf(",\"ioprobe\":{");
+    json_key("dir");
+    json_string(p->dir);
+    printf(",");
+    json_key("engine");
+    json_string(p->engine);
+    printf(",\"direct\":%s,\"file_bytes\":%zu,\"queue_depth\":%d,\"budget_ms\":%ld,\"elapsed_ms\":%lld,\"tests\":[",
+           p->direct ? "true" : "false", p->file_bytes, IOPROBE_QUEUE_DEPTH, p->budget_ms, p->elapsed_ms);
+    for (int t = 0; t < IOPROBE_TESTS; t++) {
+        const struct ioprobe_result *r = &p->results[t];
+        printf(t ? ",{" : "{");
+        json_key("test");
+        json_string(ioprobe_test_name(t));
+        printf(",\"ops\":%llu,\"mbps\":%.2f,\"iops\":%.1f,\"p50_us\":%.2f,\"p99_us\":%.2f,\"max_us\":%.2f,\"failed\":%s}",
+               r->ops, r->mbps, r->iops, r->p50_us, r->p99_us, r->max_us, r->failed ? "true" : "false");
+    }
+    printf("]}");
+}
+
+static void json_iface(const struct net_iface *iface, int interfaces) {
+    putchar('{');
+    json_key("name");
+    json_string(iface->name);
+    if (interfaces > 0) {
+        printf(",\"interfaces\":%d", interfaces);
+    } else {
+        printf(",\"ifindex\":%d,", iface->ifindex);
+        json_key("operstate");
+        json_string(iface->operstate);
+        printf(",\"mtu\":%d,\"speed_mbps\":", iface->mtu);
+        if (iface->speed_mbps > 0) {
+            printf("%ld", iface->speed_mbps);
+        } else {
+            printf("null");
+        }
+    }
+
+    const unsigned long long *c = iface->counters;
+    printf(",\"rx\":{\"bytes\":%llu,\"packets\":%llu,\"errors\":%llu,\"drops\":%llu}", c[NET_RX_BYTES],
+           c[NET_RX_PACKETS], c[NET_RX_ERRORS], c[NET_RX_DROPS]);
+    printf(",\"tx\":{\"bytes\":%llu,\"packets\":%llu,\"errors\":%llu,\"drops\":%llu}", c[NET_TX_BYTES],
+           c[NET_TX_PACKETS], c[NET_TX_ERRORS], c[NET_TX_DROPS]);
+
+    if (iface->samples >= 2) {
+        const double *r = iface->rates;
+        printf(",\"rates\":{\"rx_bytes\":%.1f,\"rx_packets\":%.1f,\"rx_errors\":%.1f,\"rx_drops\":%.1f,"
+               "\"tx_bytes\":%.1f,\"tx_packets\":%.1f,\"tx_errors\":%.1f,\"tx_drops\":%.1f}}",
+               r[NET_RX_BYTES], r[NET_RX_PACKETS], r[NET_RX_ERRORS], r[NET_RX_DROPS], r[NET_TX_BYTES],
+               r[NET_TX_PACKETS], r[NET_TX_ERRORS], r[NET_TX_DROPS]);
+    } else {
+        printf(",\"rates\":null}");
+    }
+}
+
+static void json_net(const struct netdev *nd, int show_all) {
+    printf(",\"net\":[");
+    int first = 1;
+    for (size_t i = 0; i < NETDEV_SLOTS; i++) {
+        const struct net_iface *iface = &nd->ifaces[i];
+        if (iface->ifindex == 0 || iface->seen != nd->samples || (iface->group >= 0 && !show_all)) {
+            continue;
+        }
+        printf(first ? "" : ",");
+        json_iface(iface, 0);
+        first = 0;
+    }
+
+    if (!show_all) {
+        struct net_iface groups[NET_GROUPS];
+        netdev_group_totals(nd, groups);
+        for (int g = 0; g < NET_GROUPS; g++) {
+            if (groups[g].ifindex > 0) {
+                printf(first ? "" : ",");
+                json_iface(&groups[g], groups[g].ifindex);
+                first = 0;
+            }
+        }
+    }
+    putchar(']');
+}
+
+static void json_socket_states(const char *key, unsigned long long total, const unsigned long long *counts) {
+    json_key(key);
+    printf("{\"total\":%llu", total);
+    for (int s = 1; s < SOCK_STATES; s++) {
+        printf(",\"%s\":%llu", socket_state_name(s), counts[s]);
+    }
+    putchar('}');
+}
+
+static void json_sockets(const struct socket_summary *ss) {
+    printf(",\"sockets\":{\"source\":\"%s\",", ss->source == SOCKET_SOURCE_PROC ? "proc" : "netlink");
+    json_socket_states("tcp", ss->tcp_total, ss->tcp);
+    putchar(',');
+    json_socket_states("udp", ss->udp_total, ss->udp);
+    putchar('}');
+}
+
+static void json_mounts(const struct mount_table *table) {
+    if (table->entries == NULL) {
+        printf(",\"mounts\":null");
+        return;
+    }
+
+    printf(",\"mounts\":[");
+    for (size_t i = 0; i < table->count; i++) {
+        const struct mount_entry *e = &table->entries[i];
+
+        printf(i ? ",{" : "{");
+        json_key("path");
+        json_string(e->mount_point);
+        printf(",");
+        json_key("fstype");
+        json_string(e->fstype);
+        printf(",");
+        json_key("source");
+        json_string(e->source);
+        if (e->status == BLING_OK) {
+            printf(",\"bytes\":{\"total\":%llu,\"used\":%llu,\"free\":%llu,\"reserved\":%llu}"
+                   ",\"inodes\":{\"total\":%llu,\"used\":%llu,\"free\":%llu,\"reserved\":%llu}",
+                   e->bytes_total, e->bytes_used, e->bytes_free, e->bytes_reserved, e->inodes_total, e->inodes_used,
+                   e->inodes_free, e->inodes_reserved);
+        } else {
+            printf(",");
+            json_key("error");
+            json_string(bling_strerror(e->status));
+        }
+        printf("}");
+    }
+    printf("]");
+}
+
+void print_report_json(const struct report *r) {
+    bling_snapshot *snap = r->snap;
+
+    printf("{");
+    json_key("user");
+    json_string(r->username);
+    printf(",");
+    json_key("hostname");
+    json_string(bling_hostname(snap));
+    printf(",");
+    json_key("os");
+    printf("{");
+    json_key("name");
+    json_string(bling_os_name(snap));
+    printf(",");
+    json_key("version");
+    json_string(bling_os_version(snap));
+    printf(",");
+    json_key("build_id");
+    json_string(bling_os_build_id(snap));
+    printf("},");
+    json_key("kernel");
+    json_string(bling_kernel(snap));
+    printf(",");
+    json_key("shell");
+    json_string(r->shell);
+
+    json_cpu(r);
+    if (r->virt != NULL) {
+        json_virt(r->virt, r->cpustat);
+    }
+    if (r->pressure != NULL) {
+        json_load(r->pressure);
+    }
+    if (r->vmstat != NULL) {
+        json_vmstat(r->vmstat);
+    }
+
+    printf(",\"mem\":{\"used_gib\":%.3f,\"total_gib\":%.3f}", bling_mem_used_gib(snap), bling_mem_total_gib(snap));
+    if (r->cgroup != NULL) {
+        json_cgroup(r->cgroup);
+    }
+    if (r->frag != NULL) {
+        json_frag(r->frag);
+    }
+    printf(",\"uptime_s\":%llu", bling_uptime_seconds(snap));
+    printf(",\"disk\":{\"used_gib\":%.3f,\"total_gib\":%.3f}", bling_disk_used_gib(snap), bling_disk_total_gib(snap));
+
+    if (r->thermal != NULL) {
+        json_thermal(r->thermal);
+    }
+    if (r->io != NULL) {
+        json_io(r->io);
+    }
+    if (r->ioprobe != NULL) {
+        json_ioprobe(r->ioprobe);
+    }
+    if (r->net != NULL) {
+        json_net(r->net, r->opts.show_net == 2);
+    }
+    if (r->sockets != NULL) {
+        json_sockets(r->sockets);
+    }
+    if (r->top != NULL) {
+        json_top(r->top);
+    }
+    if (r->audit != NULL) {
+        json_audit(r->audit);
+    }
+    if (r->bench != NULL) {
+        json_bench(r->bench);
+    }
+    if (r->opts.show_mounts) {
+        json_mounts(r->mounts);
+    }
+
+    printf(",");
+    json_stale(snap);
+    printf("}\n");
+}
@@ -1,112 +1,528 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <signal.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "LICENSE.h"
-#include "colors.h"
-#include "system.h"
-
-#define BUFFER_SIZE 256
-
-// Main struct to hold system info
-struct bling {
-    char *username;
-    char *hostname;
-    struct os os;
-    char *kernel;
-    char *shell;
-
-    struct cpu cpu;
-    struct mem mem;
-    struct uptime uptime;
-    struct disk disk;
+#include "audit.h"
+#include "bench.h"
+#include "bling.h"
+#include "cgroup.h"
+#include "diskstats.h"
+#include "file.h"
+#include "ioprobe.h"
+#include "memfrag.h"
+#include "netdev.h"
+#include "cpustat.h"
+#include "pressure.h"
+#include "procs.h"
+#include "sockets.h"
+#include "report.h"
+#include "thermal.h"
+#include "topology.h"
+#include "trace.h"
+#include "virt.h"
+#include "vmstat.h"
+#include "worker.h"
+
+// Scanning every pid takes longer than one snapshot field on hosts with 100k+ processes
+#define TOP_DEADLINE_MS 2000
+
+static const struct {
+    const char *name;
+    unsigned int field;
+} field_names[] = {
+    { "hostname", BLING_FIELD_HOSTNAME }, { "os", BLING_FIELD_OS }, { "kernel", BLING_FIELD_KERNEL },
+    { "mem", BLING_FIELD_MEM },           { "disk", BLING_FIELD_DISK }, { "cpu", BLING_FIELD_CPU },
+    { "uptime", BLING_FIELD_UPTIME },
 };
 
 /**
- * @brief Frees all heap-allocated memory within the bling struct.
+ * @brief Applies a "--deadline [field=]MS" argument. Returns 0 on success.
+ *
+ * "mounts", "top" and "ioprobe" are not snapshot fields; their deadlines are stored in opts.
+ */
+static int parse_deadline(bling_snapshot *snap, const char *arg, struct report_options *opts) {
+    unsigned int fields = BLING_FIELD_ALL;
+    const char *value = arg;
+    int mounts_only = 0;
+    int top_only = 0;
+    int ioprobe_only = 0;
+
+    const char *eq = strchr(arg, '=');
+    if (eq != NULL) {
+        fields = 0;
+        mounts_only = strncmp(arg, "mounts=", 7) == 0;
+        top_only = strncmp(arg, "top=", 4) == 0;
+        ioprobe_only = strncmp(arg, "ioprobe=", 8) == 0;
+        for (size_t i = 0; i < sizeof(field_names) / sizeof(field_names[0]); i++) {
+            if (strncmp(arg, field_names[i].name, eq - arg) == 0 && field_names[i].name[eq - arg] == '\0') {
+                fields = field_names[i].field;
+            }
+        }
+        value = eq + 1;
+    }
+
+    char *end = NULL;
+    long ms = strtol(value, &end, 10);
+    if ((fields == 0 && !mounts_only && !top_only && !ioprobe_only) || end == value || *end != '\0' || ms < 0) {
+        return 1;
+    }
+
+    if (eq == NULL || mounts_only) {
+        opts->mounts_deadline = ms;
+    }
+    if (eq == NULL || top_only) {
+        opts->top_deadline = ms;
+    }
+    if (eq == NULL || ioprobe_only) {
+        opts->ioprobe_deadline = ms;
+    }
+    return fields != 0 && bling_set_deadline(snap, fields, ms) != BLING_OK;
+}
+
+// Set from signal handlers under --trace: SIGUSR1 asks for a trace flush, SIGINT/SIGTERM end --watch cleanly
+static volatile sig_atomic_t flush_requested;
+static volatile sig_atomic_t stop_requested;
+
+static void on_flush_signal(int sig) {
+    (void)sig;
+    flush_requested = 1;
+}
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void write_trace(const char *path) {
+    int status = trace_write(path);
+    if (status != BLING_OK) {
+        fprintf(stderr, "bling: cannot write trace %s: %s\n", path, bling_strerror(status));
+    }
+}
+
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief Sleeps until the monotonic time deadline_ms (see worker_now_ms).
  */
-void free_bling(struct bling *b) {
-    free(b->hostname);
-    free(b->kernel);
-    free(b->os.name);
-    free(b->os.version);
-    free(b->os.build_id);
-    free(b->cpu.name);
-    // b.username and b.shell point to getenv memory, no free needed
+static void sleep_until(long long deadline_ms) {
+    long long left = deadline_ms - worker_now_ms();
+    if (left <= 0) {
+        return;
+    }
+
+    struct timespec ts = { .tv_sec = left / 1000, .tv_nsec = (left % 1000) * 1000000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR && !stop_requested && !flush_requested) {
+    }
 }
 
 int main(int argc, char **argv) {
+    long long start_ns = monotonic_ns();
     const char *helpString = "bling, a very simple system info tool"
-                             "\n\n--help: this screen\n--license: view the license\n";
+                             "\n\n--help: this screen\n--license: view the license\n"
+                             "--deadline [field=]MS: give up on a collector after MS milliseconds (default 500)\n"
+                             "--mounts: list every mounted filesystem\n"
+                             "--topology: show caches and NUMA nodes\n"
+                             "--heatmap: show per-CPU utilization\n"
+                             "--thermal: temperatures, thermal throttling and RAPL package power\n"
+                             "--io: per-disk IOPS, throughput, await, queue depth and utilization\n"
+                             "--ioprobe DIR [MB]: O_DIRECT sequential and 4K random read/write test on a temp file\n"
+                             "    under DIR, at most MB (default 64) and --deadline ioprobe=MS (default 2000)\n"
+                             "--net [all]: interface throughput and errors, veth/docker collapsed unless 'all'\n"
+                             "--frag [all]: hugepage pools and memory fragmentation, per zone and node with 'all'\n"
+                             "--sockets: count TCP and UDP sockets by state\n"
+                             "--top [N]: list the N (default 5) processes using the most memory and CPU\n"
+                             "--audit [latency|throughput]: check kernel tuning knobs against a profile (default latency)\n"
+                             "--bench: measure memory bandwidth and latency, compute and syscall cost (under 2 s)\n"
+                             "--watch [SECS]: redraw every SECS seconds (default 1) with live rates\n"
+                             "--root DIR: read /proc, /sys and /etc under DIR instead (also BLING_ROOT), to replay a capture\n"
+                             "--capture DIR: copy every file this run reads into DIR, as a tree --root can replay\n"
+                             "--json: print JSON instead; with --watch, one object per line\n"
+                             "--timings: after the report, print wall and CPU time of each collector to stderr\n"
+                             "    (files opened, bytes read and allocations with build/bling-instrumented)\n"
+                             "--trace FILE: record collector, file read and render spans, written to FILE as Chrome\n"
+                             "    trace JSON at exit, and with --watch on SIGUSR1\n";
+
+    bling_snapshot *snap = NULL;
+    if (bling_init(&snap) != BLING_OK) {
+        fprintf(stderr, "bling: %s\n", bling_strerror(BLING_ERR_NOMEM));
+        return 1;
+    }
+
+    struct report_options opts = { .mounts_deadline = BLING_DEADLINE_DEFAULT, .top_deadline = TOP_DEADLINE_MS,
+                                   .ioprobe_deadline = IOPROBE_DEFAULT_BUDGET_MS };
+    double watch_interval = 0.0;
+    int show_timings = 0;
+    const char *trace_path = NULL;
+    const char *root = getenv("BLING_ROOT");
+    const char *capture_dir = NULL;
 
-    if (argc != 1) {
-        if (strcmp(argv[1], "--help") == 0) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--help") == 0) {
             printf("%s", helpString);
+            bling_destroy(snap);
             return 0;
-        } else if (strcmp(argv[1], "--license") == 0) {
+        } else if (strcmp(argv[i], "--license") == 0) {
             printf("%s", LICENSE);
+            bling_destroy(snap);
             return 0;
-        } else if (strstr(argv[1], "--") != NULL) {
+        } else if (strcmp(argv[i], "--deadline") == 0 && i + 1 < argc) {
+            if (parse_deadline(snap, argv[++i], &opts) != 0) {
+                fprintf(stderr, "bling: bad deadline '%s'\n", argv[i]);
+                bling_destroy(snap);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--mounts") == 0) {
+            opts.show_mounts = 1;
+        } else if (strcmp(argv[i], "--topology") == 0) {
+            opts.show_topology = 1;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            opts.json = 1;
+        } else if (strcmp(argv[i], "--heatmap") == 0) {
+            opts.show_heatmap = 1;
+        } else if (strcmp(argv[i], "--thermal") == 0) {
+            opts.show_thermal = 1;
+        } else if (strcmp(argv[i], "--io") == 0) {
+            opts.show_io = 1;
+        } else if (strcmp(argv[i], "--ioprobe") == 0 && i + 1 < argc) {
+            opts.ioprobe_dir = argv[++i];
+            opts.ioprobe_size_mb = IOPROBE_DEFAULT_SIZE_MB;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                opts.ioprobe_size_mb = (size_t)strtoul(argv[++i], NULL, 10);
+                if (opts.ioprobe_size_mb == 0) {
+                    opts.ioprobe_size_mb = IOPROBE_DEFAULT_SIZE_MB;
+                }
+            }
+        } else if (strcmp(argv[i], "--net") == 0) {
+            opts.show_net = 1;
+            if (i + 1 < argc && strcmp(argv[i + 1], "all") == 0) {
+                opts.show_net = 2;
+                i++;
+            }
+        } else if (strcmp(argv[i], "--frag") == 0) {
+            opts.show_frag = 1;
+            if (i + 1 < argc && strcmp(argv[i + 1], "all") == 0) {
+                opts.show_frag = 2;
+                i++;
+            }
+        } else if (strcmp(argv[i], "--sockets") == 0) {
+            opts.show_sockets = 1;
+        } else if (strcmp(argv[i], "--top") == 0) {
+            opts.top_count = 5;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                opts.top_count = atoi(argv[++i]);
+                if (opts.top_count <= 0) {
+                    opts.top_count = 5;
+                }
+            }
+        } else if (strcmp(argv[i], "--audit") == 0) {
+            opts.show_audit = 1;
+            opts.audit_profile = AUDIT_LATENCY;
+            if (i + 1 < argc && audit_parse_profile(argv[i + 1]) >= 0) {
+                opts.audit_profile = (enum audit_profile)audit_parse_profile(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--bench") == 0) {
+            opts.show_bench = 1;
+        } else if (strcmp(argv[i], "--watch") == 0) {
+            watch_interval = 1.0;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                watch_interval = strtod(argv[++i], NULL);
+                if (watch_interval < 0.1) {
+                    watch_interval = 0.1;
+                }
+            }
+        } else if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+            root = argv[++i];
+        } else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capture_dir = argv[++i];
+        } else if (strcmp(argv[i], "--timings") == 0) {
+            show_timings = 1;
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strstr(argv[i], "--") != NULL) {
             printf("%s", helpString);
+            bling_destroy(snap);
             return 0;
         }
     }
 
-    struct bling bling = { 0 };
+    // Before the first collector: every file read from here on resolves against the root
+    if (root != NULL && root[0] != '\0' && file_set_root(root) != BLING_OK) {
+        fprintf(stderr, "bling: cannot open root %s\n", root);
+        bling_destroy(snap);
+        return 1;
+    }
+    if (capture_dir != NULL && file_set_capture(capture_dir) != BLING_OK) {
+        fprintf(stderr, "bling: cannot capture into %s\n", capture_dir);
+        bling_destroy(snap);
+        return 1;
+    }
 
-    bling.username = getenv("USER");
-    if (bling.username == NULL) {
-        bling.username = "unknown";
+    // Before any collector thread starts, so each one claims its own ring
+    if (trace_path != NULL) {
+        trace_enable(TRACE_DEFAULT_EVENTS);
+        struct sigaction sa = { .sa_handler = on_flush_signal, .sa_flags = SA_RESTART };
+        sigemptyset(&sa.sa_mask);
+        sigaction(SIGUSR1, &sa, NULL);
+        if (watch_interval > 0.0) {
+            sa.sa_handler = on_stop_signal;
+            sigaction(SIGINT, &sa, NULL);
+            sigaction(SIGTERM, &sa, NULL);
+        }
     }
 
-    bling.hostname = get_hostname();
-    bling.os = get_os();
-    bling.kernel = get_kernel();
-    bling.mem = get_meminfo();
-    bling.disk = get_diskinfo();
-    bling.cpu = get_cpu();
-    bling.uptime = get_uptime();
+    // Individual failures are shown as "unknown" in the report, so the overall status is not fatal
+    TRACE_BEGIN("snapshot", NULL);
+    bling_collect(snap, BLING_FIELD_ALL);
+    TRACE_END("snapshot");
+    struct run_timings timings = { .snapshot_ns = monotonic_ns() - start_ns };
+
+    const char *username = getenv("USER");
+    if (username == NULL) {
+        username = "unknown";
+    }
 
-    bling.shell = getenv("SHELL");
-    if (bling.shell != NULL) {
-        char *shell_name = strrchr(bling.shell, '/');
+    const char *shell = getenv("SHELL");
+    if (shell != NULL) {
+        const char *shell_name = strrchr(shell, '/');
         if (shell_name != NULL) {
-            bling.shell = shell_name + 1; // Point to just the name
+            shell = shell_name + 1; // Point to just the name
         }
     } else {
-        bling.shell = "unknown";
+        shell = "unknown";
+    }
+
+    // One span for the first sample of every report collector; --watch traces them one by one
+    TRACE_BEGIN("sample all", NULL);
+
+    // Large struct (per-node table), keep it off the stack
+    struct topology *topo = malloc(sizeof(*topo));
+    if (topo != NULL && get_topology(topo) != BLING_OK) {
+        free(topo);
+        topo = NULL;
+    }
+
+    // Ahead of the other collectors, whose sampling would otherwise compete with the kernels
+    struct bench bench;
+    int have_bench = opts.show_bench && bench_run(&bench, topo) == BLING_OK;
+
+    // Sized for every possible CPU number; pages past the highest online CPU are never touched
+    struct cpustat cpustat;
+    int have_cpustat = cpustat_init(&cpustat, MAX_CPUS) == BLING_OK && cpustat_sample(&cpustat) == BLING_OK;
+
+    struct virt virt;
+    int have_virt = virt_detect(&virt) == BLING_OK;
+
+    struct vmstat vmstat = { 0 };
+    int have_vmstat = vmstat_sample(&vmstat, have_cpustat ? &cpustat : NULL) == BLING_OK;
+
+    struct pressure pressure = { 0 };
+    int have_pressure = pressure_sample(&pressure) == BLING_OK;
+
+    struct cgroup cgroup;
+    int have_cgroup = cgroup_open(&cgroup) == BLING_OK && cgroup_sample(&cgroup) == BLING_OK;
+
+    struct proc_top top;
+    int have_top = opts.top_count > 0 && proc_top_init(&top, opts.top_count) == BLING_OK &&
+                   proc_top_sample(&top, opts.top_deadline) == BLING_OK;
+
+    struct memfrag frag = { 0 };
+    int have_frag = opts.show_frag && memfrag_sample(&frag, opts.show_frag == 2) == BLING_OK;
+
+    struct thermal thermal;
+    int have_thermal = opts.show_thermal && thermal_init(&thermal) == BLING_OK && thermal_sample(&thermal) == BLING_OK;
+
+    struct ioprobe ioprobe;
+    int have_ioprobe = opts.ioprobe_dir != NULL &&
+                       ioprobe_run(&ioprobe, opts.ioprobe_dir, opts.ioprobe_size_mb, opts.ioprobe_deadline) == BLING_OK;
+    if (opts.ioprobe_dir != NULL && !have_ioprobe) {
+        fprintf(stderr, "bling: could not probe %s\n", opts.ioprobe_dir);
     }
 
-    char user_host_buffer[BUFFER_SIZE];
-    snprintf(user_host_buffer, BUFFER_SIZE, "%suser/host%s %s@%s", BHGRN, CRESET, bling.username, bling.hostname);
+    struct diskstats io = { 0 };
+    int have_io = opts.show_io && diskstats_sample(&io) == BLING_OK;
 
-    char os_buffer[BUFFER_SIZE];
-    if (bling.os.name != NULL && bling.os.version != NULL && bling.os.build_id != NULL) {
-        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        %s %s (%s)", BHCYN, CRESET, bling.os.name, bling.os.version,
-                 bling.os.build_id);
-    } else if (bling.os.name != NULL && bling.os.version != NULL) {
-        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        %s %s", BHCYN, CRESET, bling.os.name, bling.os.version);
-    } else if (bling.os.name != NULL) {
-        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        %s", BHCYN, CRESET, bling.os.name);
+    struct netdev net;
+    int have_net = opts.show_net && netdev_init(&net) == BLING_OK && netdev_sample(&net) == BLING_OK;
+
+    struct socket_summary sockets;
+    int have_sockets = opts.show_sockets && get_socket_summary(&sockets) == BLING_OK;
+
+    struct mount_table mounts = { 0 };
+    int mounts_status = opts.show_mounts ? refresh_mounts(&mounts, opts.mounts_deadline) : BLING_OK;
+
+    struct audit audit = { 0 };
+    int have_audit = opts.show_audit && audit_run(&audit, opts.audit_profile) == BLING_OK;
+    TRACE_END("sample all");
+
+    struct report report = {
+        .opts = opts,
+        .username = username,
+        .shell = shell,
+        .snap = snap,
+        .topo = topo,
+        .mounts = &mounts,
+        .mounts_status = mounts_status,
+        .cpustat = have_cpustat ? &cpustat : NULL,
+        .virt = have_virt ? &virt : NULL,
+        .pressure = have_pressure ? &pressure : NULL,
+        .vmstat = have_vmstat ? &vmstat : NULL,
+        .frag = have_frag ? &frag : NULL,
+        .cgroup = have_cgroup ? &cgroup : NULL,
+        .top = have_top ? &top : NULL,
+        .sockets = have_sockets ? &sockets : NULL,
+        .net = have_net ? &net : NULL,
+        .io = have_io ? &io : NULL,
+        .audit = have_audit ? &audit : NULL,
+        .thermal = have_thermal ? &thermal : NULL,
+        .bench = have_bench ? &bench : NULL,
+        .ioprobe = have_ioprobe ? &ioprobe : NULL,
+    };
+
+    void (*render)(const struct report *) = opts.json ? print_report_json : print_report;
+
+    timings.first_byte_ns = monotonic_ns() - start_ns;
+    if (watch_interval <= 0.0) {
+        TRACE_BEGIN("render", NULL);
+        render(&report);
+        TRACE_END("render");
+        if (show_timings) {
+            fflush(stdout);
+            timings.total_ns = monotonic_ns() - start_ns;
+            print_timings(snap, &timings);
+        }
     } else {
-        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        unknown", BHCYN, CRESET);
+        long long interval_ms = (long long)(watch_interval * 1000);
+        long long next = worker_now_ms();
+
+        while (!stop_requested) {
+            TRACE_BEGIN("render", NULL);
+            if (!opts.json) {
+                printf("\x1b[H\x1b[2J"); // Home + clear
+            }
+            render(&report);
+            fflush(stdout);
+            TRACE_END("render");
+            if (show_timings) {
+                // First frame only: later ones just refresh the fields that are due
+                timings.total_ns = monotonic_ns() - start_ns;
+                print_timings(snap, &timings);
+                show_timings = 0;
+            }
+
+            next += interval_ms;
+            // A flush request cuts the sleep short, then the rest of it is slept
+            while (worker_now_ms() < next && !stop_requested) {
+                sleep_until(next);
+                if (flush_requested) {
+                    flush_requested = 0;
+                    write_trace(trace_path);
+                }
+            }
+            if (stop_requested) {
+                break;
+            }
+
+            TRACE_BEGIN("refresh", NULL);
+            bling_refresh_due(snap);
+            TRACE_END("refresh");
+            if (have_cpustat) {
+                TRACE_BEGIN("sample cpustat", NULL);
+                cpustat_sample(&cpustat);
+                TRACE_END("sample cpustat");
+            }
+            if (have_vmstat) {
+                TRACE_BEGIN("sample vmstat", NULL);
+                vmstat_sample(&vmstat, have_cpustat ? &cpustat : NULL);
+                TRACE_END("sample vmstat");
+            }
+            if (have_pressure) {
+                TRACE_BEGIN("sample pressure", NULL);
+                pressure_sample(&pressure);
+                TRACE_END("sample pressure");
+            }
+            if (have_cgroup) {
+                TRACE_BEGIN("sample cgroup", NULL);
+                cgroup_sample(&cgroup);
+                TRACE_END("sample cgroup");
+            }
+            if (have_top) {
+                TRACE_BEGIN("sample top", NULL);
+                proc_top_sample(&top, opts.top_deadline);
+                TRACE_END("sample top");
+            }
+            if (have_frag) {
+                TRACE_BEGIN("sample frag", NULL);
+                memfrag_sample(&frag, opts.show_frag == 2);
+                TRACE_END("sample frag");
+            }
+            if (have_thermal) {
+                TRACE_BEGIN("sample thermal", NULL);
+                thermal_sample(&thermal);
+                TRACE_END("sample thermal");
+            }
+            if (have_io) {
+                TRACE_BEGIN("sample io", NULL);
+                diskstats_sample(&io);
+                TRACE_END("sample io");
+            }
+            if (have_net) {
+                TRACE_BEGIN("sample net", NULL);
+                netdev_sample(&net);
+                TRACE_END("sample net");
+            }
+            if (opts.show_mounts) {
+                // Skipped while a statvfs thread from an earlier frame is stuck on a hung mount
+                TRACE_BEGIN("sample mounts", NULL);
+                report.mounts_status = refresh_mounts(&mounts, opts.mounts_deadline);
+                TRACE_END("sample mounts");
+            }
+            if (have_sockets) {
+                TRACE_BEGIN("sample sockets", NULL);
+                get_socket_summary(&sockets);
+                TRACE_END("sample sockets");
+            }
+        }
     }
 
-    printf("%s\n", user_host_buffer);
-    printf("%s\n", os_buffer);
-    printf("%skernel%s    %s\n", BHYEL, CRESET, bling.kernel);
-    printf("%sshell%s     %s\n", BHMAG, CRESET, bling.shell);
-    printf("%scpu%s       %s (%d) @ %.2f GHz\n", BHWHT, CRESET, bling.cpu.name, bling.cpu.cores,
-           (float)bling.cpu.base_frequency / 1000 / 1000);
-    printf("%sram%s       %.1f / %.1f GiB\n", BHBLU, CRESET, bling.mem.used_memory, bling.mem.max_memory);
-    printf("%suptime%s    %zud %zuh %zum %zus\n", BHBLK, CRESET, bling.uptime.days, bling.uptime.hours, bling.uptime.minutes,
-           bling.uptime.seconds); // %zu for size_t
-    printf("%sdisk%s      %.1f / %.1f GiB\n", BHRED, CRESET, bling.disk.used_memory_gb, bling.disk.total_memory_gb);
+    if (trace_path != NULL) {
+        write_trace(trace_path);
+    }
 
-    free_bling(&bling);
+    vmstat_free(&vmstat);
+    pressure_free(&pressure);
+    cgroup_free(&cgroup);
+    if (opts.top_count > 0) {
+        proc_top_free(&top);
+    }
+    if (opts.show_net) {
+        netdev_free(&net);
+    }
+    audit_free(&audit);
+    free_mounts(&mounts);
+    memfrag_free(&frag);
+    if (have_thermal) {
+        thermal_free(&thermal);
+    }
+    diskstats_free(&io);
+    if (have_cpustat) {
+        cpustat_free(&cpustat);
+    }
+    free(topo);
+    bling_destroy(snap);
 
     return 0;
 }
@@ -0,0 +1,340 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "memfrag.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+
+#define SYSFS_HUGEPAGES "/sys/kernel/mm/hugepages"
+#define SYSFS_NODE "/sys/devices/system/node"
+#define DEFAULT_HUGE_ORDER 9 // 2 MiB on 4 KiB pages, used when no hugepage sizes are listed
+
+const char *const frag_type_names[FRAG_TYPES] = { "unmovable", "movable", "reclaimable" };
+
+/**
+ * @brief Parses the "Node 0, zone   Normal" prefix shared by buddyinfo and pagetypeinfo lines.
+ *
+ * @return Pointer just past the zone name, or NULL if the line has another shape.
+ */
+static const char *parse_zone_prefix(const char *p, int *node, char name[16]) {
+    if (strncmp(p, "Node", 4) != 0) {
+        return NULL;
+    }
+    p += 4;
+    *node = (int)scan_ull(&p);
+    if (*p != ',') {
+        return NULL;
+    }
+    p++;
+    while (*p == ' ') {
+        p++;
+    }
+    if (strncmp(p, "zone", 4) != 0) {
+        return NULL;
+    }
+    p += 4;
+    while (*p == ' ') {
+        p++;
+    }
+
+    size_t len = strcspn(p, " ,\n");
+    if (len == 0 || len >= 16) {
+        return NULL;
+    }
+    memcpy(name, p, len);
+    name[len] = '\0';
+    return p + len;
+}
+
+static struct frag_zone *find_zone(struct memfrag *mf, int node, const char *name) {
+    for (size_t i = 0; i < mf->zone_count; i++) {
+        if (mf->zones[i].node == node && strcmp(mf->zones[i].name, name) == 0) {
+            return &mf->zones[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Fragmentation of a zone for allocations of the given order.
+ *
+ * The unusable free space index is the share of free pages sitting in blocks smaller than
+ * the order. The fragmentation index is the kernel's (mm/vmstat.c __fragmentation_index):
+ * when no block is big enough it tells a failure from fragmentation (towards 1) apart from
+ * one from lack of memory (towards 0).
+ */
+static void zone_fragmentation(struct frag_zone *z, int order) {
+    unsigned long long blocks = 0;
+    unsigned long long suitable_blocks = 0;
+    unsigned long long suitable_pages = 0;
+
+    z->free_pages = 0;
+    for (int o = 0; o < z->orders; o++) {
+        unsigned long long pages = z->free[o] << o;
+        blocks += z->free[o];
+        z->free_pages += pages;
+        if (o >= order) {
+            suitable_blocks += z->free[o] << (o - order);
+            suitable_pages += pages;
+        }
+    }
+
+    z->unusable = z->free_pages > 0 ? (double)(z->free_pages - suitable_pages) / (double)z->free_pages : 0.0;
+
+    if (blocks == 0) {
+        z->frag_index = 0.0;
+    } else if (suitable_blocks > 0) {
+        z->frag_index = -1.0;
+    } else {
+        double requested = (double)(1ull << order);
+        z->frag_index = 1.0 - (1.0 + (double)z->free_pages / requested) / (double)blocks;
+    }
+}
+
+static int parse_buddyinfo(struct memfrag *mf) {
+    if (read_file_buf("/proc/buddyinfo", &mf->buf, &mf->buf_capacity) < 0) {
+        return errno_status(errno);
+    }
+
+    mf->zone_count = 0;
+    for (const char *p = mf->buf; *p != '\0'; p = next_line(p)) {
+        // "Node 0, zone   Normal    884    882    642    170    303    246    200    158    113     61     43"
+        struct frag_zone zone = { 0 };
+        const char *f = parse_zone_prefix(p, &zone.node, zone.name);
+        if (f == NULL) {
+            continue;
+        }
+        while (zone.orders < FRAG_MAX_ORDER) {
+            while (*f == ' ') {
+                f++;
+            }
+            if (*f < '0' || *f > '9') {
+                break;
+            }
+            zone.free[zone.orders++] = scan_ull(&f);
+        }
+
+        if (mf->zone_count == mf->zone_capacity) {
+            size_t capacity = mf->zone_capacity ? mf->zone_capacity * 2 : 8;
+            struct frag_zone *zones = realloc(mf->zones, capacity * sizeof(*zones));
+            if (zones == NULL) {
+                return BLING_ERR_NOMEM;
+            }
+            mf->zones = zones;
+            mf->zone_capacity = capacity;
+        }
+        mf->zones[mf->zone_count++] = zone;
+    }
+    return BLING_OK;
+}
+
+/**
+ * @brief Reads the "Number of blocks type" table of /proc/pagetypeinfo into the zones.
+ */
+static int parse_pagetypeinfo(struct memfrag *mf) {
+    if (read_file_buf("/proc/pagetypeinfo", &mf->buf, &mf->buf_capacity) < 0) {
+        return errno_status(errno); // EACCES unless root
+    }
+
+    const char *p = strstr(mf->buf, "Number of blocks type");
+    if (p == NULL) {
+        return BLING_ERR_PARSE;
+    }
+
+    // Column order varies with config (CMA, HighAtomic), so map it from the header
+    int column_type[16];
+    int columns = 0;
+    const char *h = p + strlen("Number of blocks type");
+    while (columns < 16) {
+        while (*h == ' ') {
+            h++;
+        }
+        size_t len = strcspn(h, " \n");
+        if (len == 0) {
+            break;
+        }
+        column_type[columns] = -1;
+        for (int t = 0; t < FRAG_TYPES; t++) {
+            if (strlen(frag_type_names[t]) == len && strncasecmp(h, frag_type_names[t], len) == 0) {
+                column_type[columns] = t;
+            }
+        }
+        columns++;
+        h += len;
+    }
+
+    for (p = next_line(p); *p != '\0'; p = next_line(p)) {
+        int node;
+        char name[16];
+        const char *f = parse_zone_prefix(p, &node, name);
+        if (f == NULL) {
+            break; // End of the table
+        }
+        struct frag_zone *zone = find_zone(mf, node, name);
+        if (zone == NULL) {
+            continue;
+        }
+        for (int c = 0; c < columns; c++) {
+            unsigned long long count = scan_ull(&f);
+            if (column_type[c] >= 0) {
+                zone->pageblocks[column_type[c]] = count;
+            }
+        }
+    }
+    return BLING_OK;
+}
+
+static unsigned long long read_pool_attr(const char *dir, const char *attr) {
+    char path[160];
+    char buf[32];
+    snprintf(path, sizeof(path), "%s/%s", dir, attr);
+    if (read_file(path, buf, sizeof(buf)) <= 0) {
+        return 0;
+    }
+    const char *p = buf;
+    return scan_ull(&p);
+}
+
+/**
+ * @brief Lists the hugepage sizes with their system-wide pools, smallest first.
+ */
+static void read_hugepage_pools(struct memfrag *mf) {
+    mf->pool_count = 0;
+    DIR *dir = file_opendir(SYSFS_HUGEPAGES);
+    if (dir == NULL) {
+        return; // No hugetlbfs support
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && mf->pool_count < FRAG_MAX_POOLS) {
+        // "hugepages-2048kB"
+        if (strncmp(entry->d_name, "hugepages-", 10) != 0) {
+            continue;
+        }
+        const char *p = entry->d_name + 10;
+        unsigned long long size_kb = scan_ull(&p);
+        if (size_kb == 0) {
+            continue;
+        }
+
+        char path[96];
+        snprintf(path, sizeof(path), SYSFS_HUGEPAGES "/%.48s", entry->d_name);
+        struct hugepage_pool pool = {
+            .node = -1,
+            .size_kb = size_kb,
+            .total = read_pool_attr(path, "nr_hugepages"),
+            .free = read_pool_attr(path, "free_hugepages"),
+            .reserved = read_pool_attr(path, "resv_hugepages"),
+            .surplus = read_pool_attr(path, "surplus_hugepages"),
+        };
+
+        int i = mf->pool_count++;
+        for (; i > 0 && mf->pools[i - 1].size_kb > size_kb; i--) {
+            mf->pools[i] = mf->pools[i - 1];
+        }
+        mf->pools[i] = pool;
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Per-node pools for each hugepage size, for the nodes that have memory (the ones in buddyinfo).
+ */
+static int read_node_pools(struct memfrag *mf) {
+    mf->node_pool_count = 0;
+    for (size_t z = 0; z < mf->zone_count; z++) {
+        int node = mf->zones[z].node;
+        if (z > 0 && mf->zones[z - 1].node == node) {
+            continue; // Zones of a node are listed together
+        }
+
+        for (int s = 0; s < mf->pool_count; s++) {
+            if (mf->node_pool_count == mf->node_pool_capacity) {
+                size_t capacity = mf->node_pool_capacity ? mf->node_pool_capacity * 2 : 8;
+                struct hugepage_pool *pools = realloc(mf->node_pools, capacity * sizeof(*pools));
+                if (pools == NULL) {
+                    return BLING_ERR_NOMEM;
+                }
+                mf->node_pools = pools;
+                mf->node_pool_capacity = capacity;
+            }
+
+            char path[128];
+            snprintf(path, sizeof(path), SYSFS_NODE "/node%d/hugepages/hugepages-%llukB", node, mf->pools[s].size_kb);
+            mf->node_pools[mf->node_pool_count++] = (struct hugepage_pool){
+                .node = node,
+                .size_kb = mf->pools[s].size_kb,
+                .total = read_pool_attr(path, "nr_hugepages"),
+                .free = read_pool_attr(path, "free_hugepages"),
+                .surplus = read_pool_attr(path, "surplus_hugepages"),
+            };
+        }
+    }
+    return BLING_OK;
+}
+
+int memfrag_sample(struct memfrag *mf, int details) {
+    if (mf->page_kb == 0) {
+        long page = sysconf(_SC_PAGESIZE);
+        mf->page_kb = page >= 1024 ? (int)(page / 1024) : 4;
+    }
+
+    int status = parse_buddyinfo(mf);
+    if (status != BLING_OK) {
+        return status;
+    }
+
+    read_hugepage_pools(mf);
+    mf->huge_order = DEFAULT_HUGE_ORDER;
+    if (mf->pool_count > 0) {
+        unsigned long long pages = mf->pools[0].size_kb / (unsigned long long)mf->page_kb;
+        mf->huge_order = 0;
+        while ((2ull << mf->huge_order) <= pages) {
+            mf->huge_order++;
+        }
+    }
+
+    for (size_t z = 0; z < mf->zone_count; z++) {
+        zone_fragmentation(&mf->zones[z], mf->huge_order);
+    }
+
+    mf->has_pagetypes = 0;
+    if (details) {
+        mf->has_pagetypes = parse_pagetypeinfo(mf) == BLING_OK;
+        status = read_node_pools(mf);
+    } else {
+        mf->node_pool_count = 0;
+    }
+    return status;
+}
+
+void memfrag_totals(const struct memfrag *mf, unsigned long long *huge_free_kb, double *unusable) {
+    unsigned long long free_pages = 0;
+    unsigned long long huge_pages = 0;
+    for (size_t z = 0; z < mf->zone_count; z++) {
+        const struct frag_zone *zone = &mf->zones[z];
+        free_pages += zone->free_pages;
+        for (int o = mf->huge_order; o < zone->orders; o++) {
+            huge_pages += zone->free[o] << o;
+        }
+    }
+    *huge_free_kb = huge_pages * (unsigned long long)mf->page_kb;
+    *unusable = free_pages > 0 ? (double)(free_pages - huge_pages) / (double)free_pages : 0.0;
+}
+
+void memfrag_free(struct memfrag *mf) {
+    free(mf->zones);
+    free(mf->node_pools);
+    free(mf->buf);
+    memset(mf, 0, sizeof(*mf));
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef MEMFRAG_H
+#define MEMFRAG_H
+
+#include <stddef.h>
+
+#define FRAG_MAX_ORDER 16 // MAX_PAGE_ORDER is 10 on most configs, up to 15 on some arm64/ppc64
+#define FRAG_MAX_POOLS 8  // Hugepage sizes, two or three in practice
+
+enum frag_type {
+    FRAG_UNMOVABLE,
+    FRAG_MOVABLE,
+    FRAG_RECLAIMABLE,
+    FRAG_TYPES
+};
+
+/**
+ * @brief One line of /proc/buddyinfo: free blocks per order in a zone.
+ */
+struct frag_zone {
+    int node;
+    char name[16]; // "DMA32", "Normal", "Movable"
+    unsigned long long free[FRAG_MAX_ORDER];
+    int orders;
+    unsigned long long free_pages;
+
+    // At the hugepage order
+    double unusable;   // Share of free memory in blocks too small, 0..1
+    double frag_index; // Kernel extfrag index, 0..1: ~0 means short of memory, ~1 fragmented; -1 if a block is free
+
+    // Pageblocks per migrate type, from /proc/pagetypeinfo when it was read
+    unsigned long long pageblocks[FRAG_TYPES];
+};
+
+struct hugepage_pool {
+    int node; // -1 for the system-wide pool
+    unsigned long long size_kb;
+    unsigned long long total;
+    unsigned long long free;
+    unsigned long long reserved; // System-wide only
+    unsigned long long surplus;
+};
+
+/**
+ * @brief Memory fragmentation and hugepage availability.
+ *
+ * The summary costs one read of /proc/buddyinfo and a few sysfs attributes per hugepage
+ * size. Details add /proc/pagetypeinfo (root only, and it walks the free lists under the
+ * zone lock, so it is not read otherwise) and per-node hugepage pools.
+ */
+struct memfrag {
+    int page_kb;
+    int huge_order; // Order of the smallest hugepage size, the one fragmentation is measured at
+
+    struct frag_zone *zones;
+    size_t zone_count;
+    size_t zone_capacity;
+
+    struct hugepage_pool pools[FRAG_MAX_POOLS];
+    int pool_count;
+
+    struct hugepage_pool *node_pools;
+    size_t node_pool_count;
+    size_t node_pool_capacity;
+
+    int has_pagetypes;
+
+    char *buf;
+    size_t buf_capacity;
+};
+
+/**
+ * @brief Re-reads fragmentation and hugepage state. Zero-initialize the struct before the first call.
+ *
+ * @param details Also read /proc/pagetypeinfo and per-node hugepage pools.
+ */
+int memfrag_sample(struct memfrag *mf, int details);
+
+/**
+ * @brief Totals over all zones: free memory in blocks at or above the hugepage order, and the unusable share.
+ */
+void memfrag_totals(const struct memfrag *mf, unsigned long long *huge_free_kb, double *unusable);
+
+extern const char *const frag_type_names[FRAG_TYPES];
+
+void memfrag_free(struct memfrag *mf);
+
+#endif // MEMFRAG_H
@@ -0,0 +1,379 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "mounts.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+#include "worker.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/statvfs.h>
+
+#define MAX_STATVFS_THREADS 16
+
+// Sorted for bsearch. Filesystems with no storage of their own behind them.
+static const char *const pseudo_fstypes[] = {
+    "autofs", "binfmt_misc", "bpf",      "cgroup",      "cgroup2", "configfs",   "debugfs", "devpts",
+    "devtmpfs", "efivarfs",  "fusectl",  "hugetlbfs",   "mqueue",  "nsfs",       "proc",    "pstore",
+    "ramfs",  "rpc_pipefs",  "securityfs", "selinuxfs", "sysfs",   "tmpfs",      "tracefs",
+};
+
+static int compare_str(const void *a, const void *b) {
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+static int is_pseudo_fstype(const char *fstype) {
+    return bsearch(&fstype, pseudo_fstypes, sizeof(pseudo_fstypes) / sizeof(pseudo_fstypes[0]),
+                   sizeof(pseudo_fstypes[0]), compare_str) != NULL;
+}
+
+/**
+ * @brief NUL-terminates the space-separated token at *p and advances *p to the next one.
+ */
+static char *next_token(char **p) {
+    char *start = *p;
+    char *s = start;
+    while (*s != '\0' && *s != ' ') {
+        s++;
+    }
+    if (*s == ' ') {
+        *s++ = '\0';
+    }
+    *p = s;
+    return start;
+}
+
+/**
+ * @brief Decodes the \ooo octal escapes mountinfo uses for spaces, tabs and newlines, in-place.
+ */
+static void unescape_octal(char *s) {
+    char *out = s;
+    while (*s != '\0') {
+        if (s[0] == '\\' && s[1] >= '0' && s[1] <= '3' && s[2] >= '0' && s[2] <= '7' && s[3] >= '0' && s[3] <= '7') {
+            *out++ = (char)((s[1] - '0') * 64 + (s[2] - '0') * 8 + (s[3] - '0'));
+            s += 4;
+        } else {
+            *out++ = *s++;
+        }
+    }
+    *out = '\0';
+}
+
+static size_t dev_hash(unsigned int major, unsigned int minor, size_t mask) {
+    uint64_t key = ((uint64_t)major << 32) | minor;
+    return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+/**
+ * @brief Parses mountinfo in-place into table->entries, one per device.
+ *
+ * Bind mounts share the device of the mount they were made from; a small
+ * open-addressing table keyed by major:minor keeps the first one seen, or the
+ * one mounting the filesystem root when a bind mount happened to come first.
+ */
+static int parse_mountinfo(struct mount_table *table, size_t max_lines) {
+    size_t slots = 16;
+    while (slots < max_lines * 2) {
+        slots *= 2;
+    }
+
+    size_t *index = calloc(slots, sizeof(*index)); // entry index + 1, 0 = empty
+    unsigned char *whole = malloc(max_lines);      // entry mounts the filesystem root, not a subtree
+    table->entries = calloc(max_lines, sizeof(*table->entries));
+    if (index == NULL || whole == NULL || table->entries == NULL) {
+        free(index);
+        free(whole);
+        free(table->entries);
+        table->entries = NULL;
+        return BLING_ERR_NOMEM;
+    }
+
+    char *line = table->buf;
+    while (*line != '\0') {
+        char *end = strchr(line, '\n');
+        char *next = end != NULL ? end + 1 : line + strlen(line);
+        if (end != NULL) {
+            *end = '\0';
+        }
+
+        char *p = line;
+        line = next;
+
+        next_token(&p); // mount id
+        next_token(&p); // parent id
+        const char *majmin = next_token(&p);
+        const char *root = next_token(&p);
+        char *mount_point = next_token(&p);
+        next_token(&p); // mount options
+
+        // Optional fields up to the "-" separator
+        const char *tok;
+        do {
+            tok = next_token(&p);
+        } while (*tok != '\0' && strcmp(tok, "-") != 0);
+
+        const char *fstype = next_token(&p);
+        char *source = next_token(&p);
+
+        if (*fstype == '\0' || is_pseudo_fstype(fstype)) {
+            continue;
+        }
+
+        const char *mm = majmin;
+        unsigned int major = (unsigned int)scan_ull(&mm);
+        if (*mm != ':') {
+            continue;
+        }
+        mm++;
+        unsigned int minor = (unsigned int)scan_ull(&mm);
+
+        unescape_octal(mount_point);
+        unescape_octal(source);
+
+        int is_whole = strcmp(root, "/") == 0;
+
+        size_t mask = slots - 1;
+        size_t h = dev_hash(major, minor, mask);
+        while (index[h] != 0) {
+            struct mount_entry *e = &table->entries[index[h] - 1];
+            if (e->dev_major == major && e->dev_minor == minor) {
+                break;
+            }
+            h = (h + 1) & mask;
+        }
+
+        size_t slot;
+        if (index[h] != 0) {
+            slot = index[h] - 1;
+            if (whole[slot] || !is_whole) {
+                continue; // Bind mount of a device we already have
+            }
+        } else {
+            slot = table->count++;
+            index[h] = slot + 1;
+        }
+
+        whole[slot] = (unsigned char)is_whole;
+        table->entries[slot] = (struct mount_entry){
+            .mount_point = mount_point,
+            .source = source,
+            .fstype = fstype,
+            .dev_major = major,
+            .dev_minor = minor,
+            .status = BLING_ERR_TIMEOUT,
+        };
+    }
+
+    free(index);
+    free(whole);
+    return BLING_OK;
+}
+
+struct statvfs_result {
+    int done; // Set last, with release semantics, once status/sv are written
+    int status;
+    struct statvfs sv;
+};
+
+/**
+ * @brief Work shared by the statvfs threads. Refcounted because threads stuck on a
+ * hung mount outlive the get_mounts() call that started them.
+ */
+struct statvfs_pool {
+    int refs;
+    int cancelled;
+    int running; // Started threads that have not returned, some may be stuck in statvfs
+    size_t next;
+    size_t count;
+    char **paths;
+    char *path_buf;
+    struct statvfs_result *results;
+};
+
+static void pool_unref(void *arg) {
+    struct statvfs_pool *pool = arg;
+    if (__atomic_sub_fetch(&pool->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(pool->paths);
+        free(pool->path_buf);
+        free(pool->results);
+        free(pool);
+    }
+}
+
+static int pool_run(void *arg) {
+    struct statvfs_pool *pool = arg;
+
+    while (!__atomic_load_n(&pool->cancelled, __ATOMIC_ACQUIRE)) {
+        size_t i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+        if (i >= pool->count) {
+            break;
+        }
+
+        struct statvfs_result *r = &pool->results[i];
+        r->status = file_statvfs(pool->paths[i], &r->sv) == 0 ? BLING_OK : errno_status(errno);
+        __atomic_store_n(&r->done, 1, __ATOMIC_RELEASE);
+    }
+
+    return BLING_OK;
+}
+
+static int pool_worker(void *arg) {
+    struct statvfs_pool *pool = arg;
+    int status = pool_run(pool);
+    __atomic_sub_fetch(&pool->running, 1, __ATOMIC_RELEASE);
+    return status;
+}
+
+/**
+ * @brief Builds a pool with its own copy of the (already parsed) mount point strings.
+ */
+static struct statvfs_pool *pool_create(const struct mount_table *table, size_t buf_len) {
+    struct statvfs_pool *pool = calloc(1, sizeof(*pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    pool->refs = 1;
+    pool->count = table->count;
+    pool->paths = malloc(table->count * sizeof(*pool->paths));
+    pool->path_buf = malloc(buf_len + 1);
+    pool->results = calloc(table->count, sizeof(*pool->results));
+    if (pool->paths == NULL || pool->path_buf == NULL || pool->results == NULL) {
+        pool_unref(pool);
+        return NULL;
+    }
+
+    memcpy(pool->path_buf, table->buf, buf_len + 1);
+    for (size_t i = 0; i < table->count; i++) {
+        pool->paths[i] = pool->path_buf + (table->entries[i].mount_point - table->buf);
+    }
+
+    return pool;
+}
+
+static void fill_usage(struct mount_entry *e, const struct statvfs *sv) {
+    unsigned long long frsize = sv->f_frsize ? sv->f_frsize : sv->f_bsize;
+
+    e->bytes_total = (unsigned long long)sv->f_blocks * frsize;
+    e->bytes_used = (unsigned long long)(sv->f_blocks - sv->f_bfree) * frsize;
+    e->bytes_free = (unsigned long long)sv->f_bavail * frsize;
+    e->bytes_reserved = sv->f_bfree > sv->f_bavail ? (unsigned long long)(sv->f_bfree - sv->f_bavail) * frsize : 0;
+
+    e->inodes_total = sv->f_files;
+    e->inodes_used = sv->f_files - sv->f_ffree;
+    e->inodes_free = sv->f_favail;
+    e->inodes_reserved = sv->f_ffree > sv->f_favail ? sv->f_ffree - sv->f_favail : 0;
+}
+
+int get_mounts(struct mount_table *table, long deadline_ms) {
+    long long deadline = worker_now_ms() + deadline_ms;
+
+    table->entries = NULL;
+    table->count = 0;
+    table->stuck = NULL;
+
+    size_t len = 0;
+    table->buf = read_entire_file("/proc/self/mountinfo", &len);
+    if (table->buf == NULL) {
+        return errno_status(errno);
+    }
+
+    size_t max_lines = 1;
+    for (const char *p = table->buf; (p = memchr(p, '\n', len - (p - table->buf))) != NULL; p++) {
+        max_lines++;
+    }
+
+    int status = parse_mountinfo(table, max_lines);
+    if (status != BLING_OK || table->count == 0) {
+        free_mounts(table);
+        return status != BLING_OK ? status : BLING_ERR_PARSE;
+    }
+
+    struct statvfs_pool *pool = pool_create(table, len);
+    if (pool == NULL) {
+        free_mounts(table);
+        return BLING_ERR_NOMEM;
+    }
+
+    size_t nthreads = table->count < MAX_STATVFS_THREADS ? table->count : MAX_STATVFS_THREADS;
+    struct worker *workers[MAX_STATVFS_THREADS] = { 0 };
+    size_t started = 0;
+
+    for (size_t i = 0; i < nthreads; i++) {
+        __atomic_add_fetch(&pool->refs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&pool->running, 1, __ATOMIC_RELAXED);
+        if (worker_start(&workers[i], pool_worker, pool, pool_unref) != BLING_OK) {
+            __atomic_sub_fetch(&pool->running, 1, __ATOMIC_RELAXED);
+            __atomic_sub_fetch(&pool->refs, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        started++;
+    }
+
+    if (started == 0) {
+        pool_run(pool); // No threads to be had, do it inline
+    }
+
+    for (size_t i = 0; i < started; i++) {
+        worker_wait(workers[i], deadline);
+    }
+    __atomic_store_n(&pool->cancelled, 1, __ATOMIC_RELEASE);
+
+    int timed_out = 0;
+    for (size_t i = 0; i < table->count; i++) {
+        struct statvfs_result *r = &pool->results[i];
+        if (!__atomic_load_n(&r->done, __ATOMIC_ACQUIRE)) {
+            timed_out = 1;
+            continue; // Stays BLING_ERR_TIMEOUT
+        }
+
+        table->entries[i].status = r->status;
+        if (r->status == BLING_OK) {
+            fill_usage(&table->entries[i], &r->sv);
+        }
+    }
+
+    for (size_t i = 0; i < started; i++) {
+        worker_release(workers[i]);
+    }
+    if (timed_out && __atomic_load_n(&pool->running, __ATOMIC_ACQUIRE) > 0) {
+        table->stuck = pool; // Our reference, so refresh_mounts() can tell when the threads are back
+    } else {
+        pool_unref(pool);
+    }
+
+    return BLING_OK;
+}
+
+int refresh_mounts(struct mount_table *table, long deadline_ms) {
+    if (table->stuck != NULL && __atomic_load_n(&table->stuck->running, __ATOMIC_ACQUIRE) > 0) {
+        return BLING_ERR_TIMEOUT;
+    }
+
+    struct mount_table fresh;
+    int status = get_mounts(&fresh, deadline_ms);
+    if (status != BLING_OK) {
+        return status;
+    }
+
+    free_mounts(table);
+    *table = fresh;
+    return BLING_OK;
+}
+
+void free_mounts(struct mount_table *table) {
+    free(table->entries);
+    free(table->buf);
+    if (table->stuck != NULL) {
+        pool_unref(table->stuck);
+    }
+    table->entries = NULL;
+    table->buf = NULL;
+    table->stuck = NULL;
+    table->count = 0;
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef MOUNTS_H
+#define MOUNTS_H
+
+#include <stddef.h>
+
+struct mount_entry {
+    const char *mount_point; // Strings point into mount_table.buf
+    const char *source;
+    const char *fstype;
+    unsigned int dev_major;
+    unsigned int dev_minor;
+
+    int status; // BLING_OK once statvfs answered, BLING_ERR_TIMEOUT if it didn't in time
+
+    // Reserved is free space/inodes only root may use (f_bfree - f_bavail)
+    unsigned long long bytes_total;
+    unsigned long long bytes_used;
+    unsigned long long bytes_free;
+    unsigned long long bytes_reserved;
+    unsigned long long inodes_total;
+    unsigned long long inodes_used;
+    unsigned long long inodes_free;
+    unsigned long long inodes_reserved;
+};
+
+struct statvfs_pool;
+
+struct mount_table {
+    struct mount_entry *entries;
+    size_t count;
+    char *buf;
+    struct statvfs_pool *stuck; // Set while statvfs threads of this collection are blocked on a hung mount
+};
+
+/**
+ * @brief Lists every real filesystem from /proc/self/mountinfo with its usage.
+ *
+ * Pseudo filesystems (proc, sysfs, cgroup, tmpfs, ...) are skipped and bind mounts
+ * are folded into one entry per device. The remaining mounts are statvfs'd in
+ * parallel; any that have not answered by the deadline are left with
+ * status BLING_ERR_TIMEOUT and zeroed usage.
+ *
+ * @return BLING_OK or an error code. On success free the table with free_mounts().
+ */
+int get_mounts(struct mount_table *table, long deadline_ms);
+
+/**
+ * @brief Re-collects the table in place, for --watch.
+ *
+ * Like a snapshot field in bling_refresh(), the mounts are quarantined while a statvfs
+ * thread of the previous collection is still stuck: no new threads are started and the
+ * table keeps its last contents. The table may be zero-initialized before the first call.
+ *
+ * @return BLING_OK, BLING_ERR_TIMEOUT while quarantined, or get_mounts()'s error; on
+ *         any error the previous contents are kept.
+ */
+int refresh_mounts(struct mount_table *table, long deadline_ms);
+
+void free_mounts(struct mount_table *table);
+
+#endif // MOUNTS_H
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "netdev.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+#include "worker.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SYSFS_NET "/sys/class/net"
+
+const char *const net_group_prefixes[NET_GROUPS] = { "veth", "docker", "br-", "cali" };
+
+int netdev_init(struct netdev *nd) {
+    memset(nd, 0, sizeof(*nd));
+
+    nd->ifaces = calloc(NETDEV_SLOTS, sizeof(*nd->ifaces));
+    nd->line_slot = calloc(NETDEV_SLOTS, sizeof(*nd->line_slot));
+    if (nd->ifaces == NULL || nd->line_slot == NULL) {
+        netdev_free(nd);
+        return BLING_ERR_NOMEM;
+    }
+    return BLING_OK;
+}
+
+static int group_of(const char *name) {
+    for (int g = 0; g < NET_GROUPS; g++) {
+        if (strncmp(name, net_group_prefixes[g], strlen(net_group_prefixes[g])) == 0) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+static long read_attr_long(const char *name, const char *attr, long fallback) {
+    char path[96];
+    char buf[32];
+    snprintf(path, sizeof(path), SYSFS_NET "/%s/%s", name, attr);
+
+    // speed reads fail with EINVAL on links that are down or have no speed
+    if (read_file(path, buf, sizeof(buf)) <= 0 || buf[0] < '0' || buf[0] > '9') {
+        return fallback;
+    }
+    const char *p = buf;
+    return (long)scan_ull(&p);
+}
+
+static void read_link_attrs(struct net_iface *iface) {
+    char path[96];
+    snprintf(path, sizeof(path), SYSFS_NET "/%s/operstate", iface->name);
+    if (read_file(path, iface->operstate, sizeof(iface->operstate)) > 0) {
+        iface->operstate[strcspn(iface->operstate, "\n")] = '\0';
+    } else {
+        strcpy(iface->operstate, "unknown");
+    }
+
+    iface->mtu = (int)read_attr_long(iface->name, "mtu", 0);
+    iface->speed_mbps = read_attr_long(iface->name, "speed", -1);
+}
+
+/**
+ * @brief Finds the slot of ifindex, or the one to hold it: the first free slot, or the first
+ * whose interface was missing from the previous sample, on its probe sequence.
+ *
+ * Slots are never emptied, so a probe sequence only ends at a slot that was never used.
+ *
+ * @return NULL if every slot holds a live interface.
+ */
+static struct net_iface *find_slot(struct netdev *nd, int ifindex) {
+    struct net_iface *reusable = NULL;
+
+    for (size_t i = 0; i < NETDEV_SLOTS; i++) {
+        struct net_iface *iface = &nd->ifaces[((size_t)ifindex + i) % NETDEV_SLOTS];
+        if (iface->ifindex == ifindex) {
+            return iface;
+        }
+        if (iface->ifindex == 0) {
+            return reusable != NULL ? reusable : iface;
+        }
+        if (reusable == NULL && iface->seen < nd->samples - 1) {
+            reusable = iface;
+        }
+    }
+    return reusable;
+}
+
+/**
+ * @brief Finds the slot for the interface at /proc/net/dev line `line`, reusing the previous
+ * sample's answer when the same name is still on that line, so ifindex is not read from sysfs.
+ *
+ * @param fresh Set when the slot held another interface (or none) and has to be started over.
+ */
+static struct net_iface *lookup_iface(struct netdev *nd, size_t line, const char *name, int *fresh) {
+    *fresh = 0;
+    if (line < NETDEV_SLOTS && nd->line_slot[line] > 0) {
+        struct net_iface *iface = &nd->ifaces[nd->line_slot[line] - 1];
+        if (strcmp(iface->name, name) == 0) {
+            return iface;
+        }
+    }
+
+    int ifindex = (int)read_attr_long(name, "ifindex", 0);
+    if (ifindex <= 0) {
+        return NULL; // Vanished between the read and the lookup
+    }
+    struct net_iface *iface = find_slot(nd, ifindex);
+    if (iface == NULL) {
+        return NULL;
+    }
+
+    // New interface, or one renamed or with a recycled ifindex, or a slot whose interface is gone: start over
+    if (iface->ifindex != ifindex || strcmp(iface->name, name) != 0) {
+        memset(iface, 0, sizeof(*iface));
+        iface->ifindex = ifindex;
+        snprintf(iface->name, sizeof(iface->name), "%s", name);
+        iface->group = group_of(name);
+        *fresh = 1;
+    }
+    if (line < NETDEV_SLOTS) {
+        nd->line_slot[line] = (int)(iface - nd->ifaces) + 1;
+    }
+    return iface;
+}
+
+static void update_rates(struct net_iface *iface, double elapsed) {
+    for (int c = 0; c < NET_COUNTERS; c++) {
+        // A counter going backwards means the driver reset it; report 0 for this interval
+        unsigned long long delta = iface->counters[c] >= iface->prev[c] ? iface->counters[c] - iface->prev[c] : 0;
+        iface->rates[c] = elapsed > 0.0 ? (double)delta / elapsed : 0.0;
+    }
+}
+
+int netdev_sample(struct netdev *nd) {
+    if (nd->ifaces == NULL) {
+        return BLING_ERR_INVAL;
+    }
+
+    long long now = worker_now_ms();
+    if (read_file_buf("/proc/net/dev", &nd->buf, &nd->buf_capacity) < 0) {
+        return errno_status(errno);
+    }
+
+    nd->samples++;
+    nd->elapsed = nd->samples > 1 ? (double)(now - nd->sample_ms) / 1000.0 : 0.0;
+    nd->sample_ms = now;
+
+    // Two header lines, then "  eth0: rx_bytes rx_packets errs drop fifo frame compressed multicast tx_bytes ..."
+    const char *p = next_line(next_line(nd->buf));
+    for (size_t line = 0; *p != '\0'; line++, p = next_line(p)) {
+        while (*p == ' ') {
+            p++;
+        }
+        const char *colon = strchr(p, ':');
+        const char *eol = strchr(p, '\n');
+        if (colon == NULL || (eol != NULL && colon > eol) || colon - p >= NET_NAME_SIZE) {
+            continue;
+        }
+
+        char name[NET_NAME_SIZE];
+        memcpy(name, p, (size_t)(colon - p));
+        name[colon - p] = '\0';
+
+        int fresh;
+        struct net_iface *iface = lookup_iface(nd, line, name, &fresh);
+        if (iface == NULL) {
+            continue;
+        }
+
+        memcpy(iface->prev, iface->counters, sizeof(iface->prev));
+        const char *f = colon + 1;
+        unsigned long long values[16];
+        for (int i = 0; i < 16; i++) {
+            values[i] = scan_ull(&f);
+        }
+        iface->counters[NET_RX_BYTES] = values[0];
+        iface->counters[NET_RX_PACKETS] = values[1];
+        iface->counters[NET_RX_ERRORS] = values[2];
+        iface->counters[NET_RX_DROPS] = values[3];
+        iface->counters[NET_TX_BYTES] = values[8];
+        iface->counters[NET_TX_PACKETS] = values[9];
+        iface->counters[NET_TX_ERRORS] = values[10];
+        iface->counters[NET_TX_DROPS] = values[11];
+
+        if (fresh || iface->group < 0) {
+            read_link_attrs(iface);
+        }
+
+        iface->samples++;
+        if (iface->samples > 1) {
+            update_rates(iface, nd->elapsed);
+        }
+        iface->seen = nd->samples;
+    }
+
+    return BLING_OK;
+}
+
+void netdev_group_totals(const struct netdev *nd, struct net_iface groups[NET_GROUPS]) {
+    memset(groups, 0, NET_GROUPS * sizeof(*groups));
+    for (int g = 0; g < NET_GROUPS; g++) {
+        snprintf(groups[g].name, sizeof(groups[g].name), "%s*", net_group_prefixes[g]);
+        groups[g].group = g;
+        groups[g].speed_mbps = -1;
+        strcpy(groups[g].operstate, "-");
+    }
+
+    for (size_t i = 0; i < NETDEV_SLOTS; i++) {
+        const struct net_iface *iface = &nd->ifaces[i];
+        if (iface->ifindex == 0 || iface->seen != nd->samples || iface->group < 0) {
+            continue;
+        }
+
+        struct net_iface *g = &groups[iface->group];
+        g->ifindex++;
+        for (int c = 0; c < NET_COUNTERS; c++) {
+            g->counters[c] += iface->counters[c];
+            g->rates[c] += iface->rates[c];
+        }
+        // Rates are only meaningful if some member has two samples
+        if (iface->samples > g->samples) {
+            g->samples = iface->samples;
+        }
+    }
+}
+
+void netdev_free(struct netdev *nd) {
+    free(nd->ifaces);
+    free(nd->line_slot);
+    free(nd->buf);
+    memset(nd, 0, sizeof(*nd));
+}
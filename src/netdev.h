@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDEV_H
+#define NETDEV_H
+
+#include <stddef.h>
+
+// Slots in the interface table, an open-addressed hash on ifindex
+#define NETDEV_SLOTS 4096
+#define NET_NAME_SIZE 16 // IFNAMSIZ
+
+enum net_counter {
+    NET_RX_BYTES,
+    NET_RX_PACKETS,
+    NET_RX_ERRORS,
+    NET_RX_DROPS,
+    NET_TX_BYTES,
+    NET_TX_PACKETS,
+    NET_TX_ERRORS,
+    NET_TX_DROPS,
+    NET_COUNTERS
+};
+
+struct net_iface {
+    char name[NET_NAME_SIZE];
+    int ifindex;  // 0 = free slot
+    int seen;     // netdev.samples when last present in /proc/net/dev
+    int group;    // Index into net_group_prefixes for collapsible virtual interfaces, -1 otherwise
+    int mtu;
+    long speed_mbps;    // -1 when the driver has no link speed (virtual, link down)
+    char operstate[16]; // "up", "down", "unknown", ...
+
+    unsigned long long counters[NET_COUNTERS];
+    unsigned long long prev[NET_COUNTERS];
+    double rates[NET_COUNTERS]; // Per second since the previous sample, valid once the interface was seen twice
+    int samples;                // Samples this slot has held this interface for
+};
+
+/**
+ * @brief Per-interface counters from /proc/net/dev with link attributes from sysfs.
+ *
+ * All state lives in one table allocated by netdev_init(), hashed on ifindex with linear
+ * probing, so sampling allocates nothing once the read buffer has grown to fit the file.
+ * A slot is only reused for another interface once its own was missing from a sample.
+ */
+struct netdev {
+    struct net_iface *ifaces; // NETDEV_SLOTS entries
+    int *line_slot;           // Slot + 1 of each /proc/net/dev line in the previous sample, 0 = none
+    int samples;
+    long long sample_ms;
+    double elapsed; // Seconds between the last two samples
+
+    char *buf;
+    size_t buf_capacity;
+};
+
+// Name prefixes of virtual interfaces that are folded into one line per prefix
+#define NET_GROUPS 4
+extern const char *const net_group_prefixes[NET_GROUPS];
+
+int netdev_init(struct netdev *nd);
+
+/**
+ * @brief Re-reads /proc/net/dev and computes rates against the previous sample.
+ *
+ * ifindex, MTU, speed and operstate come from /sys/class/net/<name>. ifindex is only
+ * looked up for interfaces not at the same /proc/net/dev line as last time, and the
+ * link attributes are skipped for collapsible virtual interfaces after the first sample.
+ */
+int netdev_sample(struct netdev *nd);
+
+/**
+ * @brief Sums the present interfaces of each collapsible group into groups[g], named "<prefix>*".
+ *
+ * groups[g].ifindex holds the number of member interfaces, 0 if the group is empty.
+ */
+void netdev_group_totals(const struct netdev *nd, struct net_iface groups[NET_GROUPS]);
+
+void netdev_free(struct netdev *nd);
+
+#endif // NETDEV_H
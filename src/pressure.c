@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "pressure.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+#include "worker.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *const psi_resource_names[PSI_RESOURCES] = { "cpu", "memory", "io" };
+
+static const char *const psi_paths[PSI_RESOURCES] = {
+    "/proc/pressure/cpu",
+    "/proc/pressure/memory",
+    "/proc/pressure/io",
+};
+
+/**
+ * @brief Parses "avg10=1.85 avg60=1.65 avg300=1.13 total=11096004" into line,
+ * turning the change in total into a stall rate over elapsed_ms.
+ */
+static void parse_psi_line(const char *p, struct psi_line *line, long long elapsed_ms, int have_prev) {
+    unsigned long long prev_total = line->total_us;
+
+    while (*p != '\0' && *p != '\n') {
+        if (strncmp(p, "avg10=", 6) == 0) {
+            p += 6;
+            line->avg10 = scan_decimal(&p);
+        } else if (strncmp(p, "avg60=", 6) == 0) {
+            p += 6;
+            line->avg60 = scan_decimal(&p);
+        } else if (strncmp(p, "avg300=", 7) == 0) {
+            p += 7;
+            line->avg300 = scan_decimal(&p);
+        } else if (strncmp(p, "total=", 6) == 0) {
+            p += 6;
+            line->total_us = scan_ull(&p);
+        } else {
+            skip_field(&p);
+            continue;
+        }
+        while (*p == ' ') {
+            p++;
+        }
+    }
+
+    if (have_prev && elapsed_ms > 0 && line->total_us >= prev_total) {
+        line->rate = 100.0 * (double)(line->total_us - prev_total) / ((double)elapsed_ms * 1000.0);
+    } else {
+        line->rate = 0.0;
+    }
+}
+
+int pressure_sample(struct pressure *pr) {
+    long long now = worker_now_ms();
+    long long elapsed_ms = now - pr->sample_ms;
+    int have_prev = pr->samples > 0;
+
+    // "0.03 0.03 0.00 2/71 3158"
+    if (read_file_buf("/proc/loadavg", &pr->buf, &pr->buf_capacity) < 0) {
+        return errno_status(errno);
+    }
+
+    const char *p = pr->buf;
+    pr->load1 = scan_decimal(&p);
+    pr->load5 = scan_decimal(&p);
+    pr->load15 = scan_decimal(&p);
+    pr->running = scan_ull(&p);
+    if (*p == '/') {
+        p++;
+    }
+    pr->tasks = scan_ull(&p);
+
+    for (int r = 0; r < PSI_RESOURCES; r++) {
+        struct psi *psi = &pr->psi[r];
+
+        if (read_file_buf(psi_paths[r], &pr->buf, &pr->buf_capacity) < 0) {
+            psi->present = 0;
+            continue;
+        }
+        int had_prev = have_prev && psi->present;
+        psi->present = 1;
+
+        for (p = pr->buf; *p != '\0'; p = next_line(p)) {
+            if (strncmp(p, "some ", 5) == 0) {
+                parse_psi_line(p + 5, &psi->some, elapsed_ms, had_prev);
+            } else if (strncmp(p, "full ", 5) == 0) {
+                parse_psi_line(p + 5, &psi->full, elapsed_ms, had_prev);
+            }
+        }
+    }
+
+    pr->sample_ms = now;
+    pr->samples++;
+
+    return BLING_OK;
+}
+
+void pressure_free(struct pressure *pr) {
+    free(pr->buf);
+    memset(pr, 0, sizeof(*pr));
+}
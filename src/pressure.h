@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef PRESSURE_H
+#define PRESSURE_H
+
+#include <stddef.h>
+
+enum psi_resource { PSI_CPU, PSI_MEMORY, PSI_IO, PSI_RESOURCES };
+
+struct psi_line {
+    double avg10; // Kernel's running averages, percent
+    double avg60;
+    double avg300;
+    unsigned long long total_us; // Cumulative stall time
+    double rate;                 // Percent of wall time stalled since the previous sample
+};
+
+struct psi {
+    int present; // Kernel has PSI for this resource
+    struct psi_line some;
+    struct psi_line full;
+};
+
+/**
+ * @brief /proc/loadavg and /proc/pressure/{cpu,memory,io}, sampled over time.
+ */
+struct pressure {
+    double load1;
+    double load5;
+    double load15;
+    unsigned long long running; // Runnable tasks right now
+    unsigned long long tasks;   // All tasks
+
+    struct psi psi[PSI_RESOURCES];
+    int samples; // rate is only meaningful once this reaches 2
+
+    long long sample_ms;
+    char *buf;
+    size_t buf_capacity;
+};
+
+/**
+ * @brief Re-reads load and pressure, computing stall rates from the change in the
+ * total counters since the previous call. Zero-initialize the struct before the first call.
+ *
+ * @return BLING_OK, or an error if /proc/loadavg could not be read. Missing
+ * /proc/pressure (CONFIG_PSI off) only leaves psi[].present at 0.
+ */
+int pressure_sample(struct pressure *pr);
+
+extern const char *const psi_resource_names[PSI_RESOURCES];
+
+void pressure_free(struct pressure *pr);
+
+#endif // PRESSURE_H
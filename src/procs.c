@@ -0,0 +1,485 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _GNU_SOURCE // syscall()
+
+#include "procs.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+#include "worker.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define DENTS_BUFFER_SIZE (64 * 1024)
+#define STAT_BUFFER_SIZE 1024
+#define SCAN_CHUNK 64
+#define MAX_SCAN_THREADS 8
+
+// Layout the kernel writes for getdents64(2); glibc only exposes it with newer headers
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+enum scan_state { SCAN_PENDING, SCAN_DONE, SCAN_GONE };
+
+struct scan_result {
+    int state; // enum scan_state, published with release ordering
+    struct proc_info info;
+};
+
+/**
+ * @brief One scan's work, shared by its threads. Refcounted so a thread still reading
+ * when the deadline passes keeps its own /proc fd and result slots alive.
+ */
+struct scan_job {
+    int refs;
+    int cancelled;
+    size_t next; // Next chunk of pids to claim
+    size_t count;
+    int proc_fd;
+    long page_kb;
+    int *pids;
+    struct scan_result *results;
+};
+
+static void job_unref(void *arg) {
+    struct scan_job *job = arg;
+    if (__atomic_sub_fetch(&job->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        close(job->proc_fd);
+        free(job->pids);
+        free(job->results);
+        free(job);
+    }
+}
+
+/**
+ * @brief Writes "<pid>/stat" into path without going through printf.
+ */
+static void stat_path(char *path, int pid) {
+    char digits[12];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + pid % 10);
+        pid /= 10;
+    } while (pid > 0);
+
+    while (n > 0) {
+        *path++ = digits[--n];
+    }
+    memcpy(path, "/stat", 6);
+}
+
+/**
+ * @brief Skips n fields starting at *p, which may point at the blank left by scan_ull().
+ */
+static void skip_fields(const char **p, int n) {
+    while (**p == ' ') {
+        (*p)++;
+    }
+    while (n-- > 0) {
+        skip_field(p);
+    }
+}
+
+/**
+ * @brief Parses /proc/<pid>/stat. comm may contain spaces and parentheses, so the
+ * fields are counted from the last ')'.
+ *
+ * "1234 (bash) S 1 1234 1234 34816 ... utime stime ... starttime vsize rss ..."
+ */
+static int parse_stat(const char *buf, size_t len, struct proc_info *info, long page_kb) {
+    const char *open = memchr(buf, '(', len);
+    const char *close = buf + len;
+    while (close > buf && *close != ')') {
+        close--;
+    }
+    if (open == NULL || close <= open) {
+        return BLING_ERR_PARSE;
+    }
+
+    size_t comm_len = (size_t)(close - open - 1);
+    if (comm_len >= PROC_COMM_SIZE) {
+        comm_len = PROC_COMM_SIZE - 1;
+    }
+    memcpy(info->comm, open + 1, comm_len);
+    info->comm[comm_len] = '\0';
+
+    const char *p = close + 1;
+    skip_fields(&p, 11); // state .. cmajflt
+    unsigned long long utime = scan_ull(&p);
+    unsigned long long stime = scan_ull(&p);
+    skip_fields(&p, 6); // cutime .. itrealvalue
+    info->start_time = scan_ull(&p);
+    skip_fields(&p, 1); // vsize
+    info->rss_kb = scan_ull(&p) * (unsigned long long)page_kb;
+    info->cpu_ticks = utime + stime;
+
+    return BLING_OK;
+}
+
+static int job_run(void *arg) {
+    struct scan_job *job = arg;
+    char path[32];
+    char buf[STAT_BUFFER_SIZE];
+
+    while (!__atomic_load_n(&job->cancelled, __ATOMIC_ACQUIRE)) {
+        size_t first = __atomic_fetch_add(&job->next, SCAN_CHUNK, __ATOMIC_RELAXED);
+        if (first >= job->count) {
+            break;
+        }
+        size_t last = first + SCAN_CHUNK < job->count ? first + SCAN_CHUNK : job->count;
+
+        for (size_t i = first; i < last; i++) {
+            struct scan_result *r = &job->results[i];
+            int state = SCAN_GONE;
+
+            stat_path(path, job->pids[i]);
+            int fd = file_openat(job->proc_fd, "/proc", path, O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                ssize_t n = read(fd, buf, sizeof(buf) - 1);
+                close(fd);
+                if (n > 0) {
+                    buf[n] = '\0';
+                    r->info.pid = job->pids[i];
+                    if (parse_stat(buf, (size_t)n, &r->info, job->page_kb) == BLING_OK) {
+                        state = SCAN_DONE;
+                    }
+                }
+            }
+            __atomic_store_n(&r->state, state, __ATOMIC_RELEASE);
+        }
+    }
+
+    return BLING_OK;
+}
+
+/**
+ * @brief Collects the numeric entries of /proc into pt->pids with getdents64 on the cached dirfd.
+ */
+static int list_pids(struct proc_top *pt, size_t *count) {
+    *count = 0;
+    if (lseek(pt->proc_fd, 0, SEEK_SET) < 0) {
+        return errno_status(errno);
+    }
+
+    for (;;) {
+        long n = syscall(SYS_getdents64, pt->proc_fd, pt->dents, pt->dents_capacity);
+        if (n < 0) {
+            return errno_status(errno);
+        }
+        if (n == 0) {
+            return BLING_OK;
+        }
+
+        for (long off = 0; off < n;) {
+            const struct linux_dirent64 *d = (const struct linux_dirent64 *)(pt->dents + off);
+            off += d->d_reclen;
+
+            const char *name = d->d_name;
+            if (*name < '1' || *name > '9') {
+                continue; // ".", "self", "sys", ...
+            }
+            unsigned long long pid = scan_ull(&name);
+            if (*name != '\0' || pid > INT32_MAX) {
+                continue;
+            }
+
+            if (*count == pt->pid_capacity) {
+                size_t capacity = pt->pid_capacity ? pt->pid_capacity * 2 : 1024;
+                int *pids = realloc(pt->pids, capacity * sizeof(*pids));
+                if (pids == NULL) {
+                    return BLING_ERR_NOMEM;
+                }
+                pt->pids = pids;
+                pt->pid_capacity = capacity;
+            }
+            pt->pids[(*count)++] = (int)pid;
+        }
+    }
+}
+
+static size_t pid_hash(int pid, size_t mask) {
+    return (size_t)(((uint64_t)(uint32_t)pid * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+/**
+ * @brief Empties table, growing it to at least twice count buckets so probes stay short.
+ */
+static int table_reset(struct pid_table *table, size_t count) {
+    size_t capacity = 64;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+
+    if (capacity > table->capacity) {
+        struct pid_slot *slots = malloc(capacity * sizeof(*slots));
+        if (slots == NULL) {
+            return BLING_ERR_NOMEM;
+        }
+        free(table->slots);
+        table->slots = slots;
+        table->capacity = capacity;
+    }
+    memset(table->slots, 0, table->capacity * sizeof(*table->slots));
+    return BLING_OK;
+}
+
+static const struct pid_slot *table_find(const struct pid_table *table, int pid) {
+    if (table->capacity == 0) {
+        return NULL;
+    }
+
+    size_t mask = table->capacity - 1;
+    for (size_t i = pid_hash(pid, mask);; i = (i + 1) & mask) {
+        const struct pid_slot *slot = &table->slots[i];
+        if (slot->pid == pid) {
+            return slot;
+        } else if (slot->pid == 0) {
+            return NULL;
+        }
+    }
+}
+
+static void table_insert(struct pid_table *table, const struct proc_info *info) {
+    size_t mask = table->capacity - 1;
+    size_t i = pid_hash(info->pid, mask);
+    while (table->slots[i].pid != 0) {
+        i = (i + 1) & mask;
+    }
+    table->slots[i] = (struct pid_slot){ .pid = info->pid, .start_time = info->start_time, .cpu_ticks = info->cpu_ticks };
+}
+
+static unsigned long long rss_key(const struct proc_info *p) {
+    return p->rss_kb;
+}
+
+static unsigned long long cpu_key(const struct proc_info *p) {
+    return p->cpu_delta;
+}
+
+/**
+ * @brief Offers p to a min-heap holding the limit largest entries by key.
+ */
+static void heap_offer(struct proc_info *heap, int *count, int limit, const struct proc_info *p,
+                       unsigned long long (*key)(const struct proc_info *)) {
+    int i;
+    if (*count < limit) {
+        // Sift up from the new leaf
+        i = (*count)++;
+        while (i > 0 && key(p) < key(&heap[(i - 1) / 2])) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = *p;
+        return;
+    }
+
+    if (limit == 0 || key(p) <= key(&heap[0])) {
+        return;
+    }
+
+    // Replace the smallest and sift down
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= *count) {
+            break;
+        }
+        if (child + 1 < *count && key(&heap[child + 1]) < key(&heap[child])) {
+            child++;
+        }
+        if (key(p) <= key(&heap[child])) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = *p;
+}
+
+static int compare_rss_desc(const void *a, const void *b) {
+    unsigned long long x = rss_key(a), y = rss_key(b);
+    return (x < y) - (x > y);
+}
+
+static int compare_cpu_desc(const void *a, const void *b) {
+    unsigned long long x = cpu_key(a), y = cpu_key(b);
+    return (x < y) - (x > y);
+}
+
+int proc_top_init(struct proc_top *pt, int n) {
+    memset(pt, 0, sizeof(*pt));
+    pt->proc_fd = -1;
+    if (n <= 0) {
+        return BLING_ERR_INVAL;
+    }
+
+    pt->limit = n;
+    pt->clock_ticks = sysconf(_SC_CLK_TCK);
+    pt->page_kb = sysconf(_SC_PAGESIZE) / 1024;
+    pt->top_rss = calloc((size_t)n, sizeof(*pt->top_rss));
+    pt->top_cpu = calloc((size_t)n, sizeof(*pt->top_cpu));
+    pt->dents = malloc(DENTS_BUFFER_SIZE);
+    pt->dents_capacity = DENTS_BUFFER_SIZE;
+    if (pt->top_rss == NULL || pt->top_cpu == NULL || pt->dents == NULL) {
+        proc_top_free(pt);
+        return BLING_ERR_NOMEM;
+    }
+
+    pt->proc_fd = file_open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (pt->proc_fd < 0) {
+        int status = errno_status(errno);
+        proc_top_free(pt);
+        return status;
+    }
+
+    return BLING_OK;
+}
+
+static struct scan_job *job_create(const struct proc_top *pt, size_t count) {
+    struct scan_job *job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        return NULL;
+    }
+
+    job->refs = 1;
+    job->count = count;
+    job->page_kb = pt->page_kb;
+    job->proc_fd = fcntl(pt->proc_fd, F_DUPFD_CLOEXEC, 0);
+    job->pids = malloc(count * sizeof(*job->pids));
+    job->results = calloc(count, sizeof(*job->results));
+    if (job->proc_fd < 0 || job->pids == NULL || job->results == NULL) {
+        job_unref(job);
+        return NULL;
+    }
+
+    memcpy(job->pids, pt->pids, count * sizeof(*job->pids));
+    return job;
+}
+
+/**
+ * @brief Ranks the scanned processes, computing CPU deltas against the previous scan's table.
+ */
+static void fold_results(struct proc_top *pt, const struct scan_job *job, long long elapsed_ms) {
+    pt->rss_count = 0;
+    pt->cpu_count = 0;
+    pt->scanned = 0;
+    pt->timed_out = 0;
+
+    double ticks_per_pct = elapsed_ms > 0 ? (double)pt->clock_ticks * (double)elapsed_ms / 1000.0 / 100.0 : 0.0;
+
+    for (size_t i = 0; i < job->count; i++) {
+        const struct scan_result *r = &job->results[i];
+        int state = __atomic_load_n(&r->state, __ATOMIC_ACQUIRE);
+        if (state == SCAN_PENDING) {
+            pt->timed_out++;
+            continue;
+        } else if (state != SCAN_DONE) {
+            continue; // Exited between listing and reading
+        }
+
+        struct proc_info info = r->info;
+        pt->scanned++;
+
+        // A pid seen before with the same start time is the same process; anything else started during the interval
+        const struct pid_slot *prev = table_find(&pt->prev, info.pid);
+        if (prev != NULL && prev->start_time == info.start_time && info.cpu_ticks >= prev->cpu_ticks) {
+            info.cpu_delta = info.cpu_ticks - prev->cpu_ticks;
+        } else {
+            info.cpu_delta = info.cpu_ticks;
+        }
+        info.cpu_pct = pt->samples > 0 && ticks_per_pct > 0.0 ? (double)info.cpu_delta / ticks_per_pct : 0.0;
+
+        table_insert(&pt->next, &info);
+        heap_offer(pt->top_rss, &pt->rss_count, pt->limit, &info, rss_key);
+        heap_offer(pt->top_cpu, &pt->cpu_count, pt->limit, &info, cpu_key);
+    }
+
+    qsort(pt->top_rss, (size_t)pt->rss_count, sizeof(*pt->top_rss), compare_rss_desc);
+    qsort(pt->top_cpu, (size_t)pt->cpu_count, sizeof(*pt->top_cpu), compare_cpu_desc);
+}
+
+int proc_top_sample(struct proc_top *pt, long deadline_ms) {
+    long long now = worker_now_ms();
+    long long deadline = now + deadline_ms;
+
+    size_t count;
+    int status = list_pids(pt, &count);
+    if (status != BLING_OK) {
+        return status;
+    }
+    if (table_reset(&pt->next, count) != BLING_OK) {
+        return BLING_ERR_NOMEM;
+    }
+
+    struct scan_job *job = job_create(pt, count);
+    if (job == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t chunks = (count + SCAN_CHUNK - 1) / SCAN_CHUNK;
+    size_t nthreads = cpus > 0 ? (size_t)cpus : 1;
+    nthreads = nthreads < MAX_SCAN_THREADS ? nthreads : MAX_SCAN_THREADS;
+    nthreads = nthreads < chunks ? nthreads : chunks;
+
+    struct worker *workers[MAX_SCAN_THREADS] = { 0 };
+    size_t started = 0;
+    for (size_t i = 0; i < nthreads; i++) {
+        __atomic_add_fetch(&job->refs, 1, __ATOMIC_RELAXED);
+        if (worker_start(&workers[i], job_run, job, job_unref) != BLING_OK) {
+            __atomic_sub_fetch(&job->refs, 1, __ATOMIC_RELAXED);
+            break;
+        }
+        started++;
+    }
+
+    if (started == 0) {
+        job_run(job); // No threads to be had, do it inline
+    }
+
+    for (size_t i = 0; i < started; i++) {
+        worker_wait(workers[i], deadline);
+    }
+    __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELEASE);
+
+    fold_results(pt, job, now - pt->sample_ms);
+
+    for (size_t i = 0; i < started; i++) {
+        worker_release(workers[i]);
+    }
+    job_unref(job);
+
+    struct pid_table tmp = pt->prev;
+    pt->prev = pt->next;
+    pt->next = tmp;
+
+    pt->sample_ms = now;
+    pt->samples++;
+
+    return BLING_OK;
+}
+
+void proc_top_free(struct proc_top *pt) {
+    if (pt->proc_fd >= 0) {
+        close(pt->proc_fd);
+    }
+    free(pt->top_rss);
+    free(pt->top_cpu);
+    free(pt->dents);
+    free(pt->pids);
+    free(pt->prev.slots);
+    free(pt->next.slots);
+    memset(pt, 0, sizeof(*pt));
+    pt->proc_fd = -1;
+}
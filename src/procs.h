@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef PROCS_H
+#define PROCS_H
+
+#include <stddef.h>
+
+#define PROC_COMM_SIZE 32
+
+struct proc_info {
+    int pid;
+    char comm[PROC_COMM_SIZE];
+    unsigned long long rss_kb;
+    unsigned long long cpu_ticks;  // utime + stime, cumulative
+    unsigned long long start_time; // Ticks after boot, tells a reused pid from the old process
+    unsigned long long cpu_delta;  // Ticks since the previous scan; on the first scan, all of cpu_ticks
+    double cpu_pct;                // Percent of one CPU since the previous scan, 0 on the first
+};
+
+/**
+ * @brief One bucket of the pid -> previous CPU ticks table. pid 0 marks an empty bucket.
+ */
+struct pid_slot {
+    int pid;
+    unsigned long long start_time;
+    unsigned long long cpu_ticks;
+};
+
+struct pid_table {
+    struct pid_slot *slots;
+    size_t capacity; // Power of two
+};
+
+/**
+ * @brief The top N processes by resident memory and by CPU use, rescanned on every sample.
+ */
+struct proc_top {
+    int limit; // N
+
+    struct proc_info *top_rss; // Largest first
+    int rss_count;
+    struct proc_info *top_cpu; // Busiest first
+    int cpu_count;
+
+    size_t scanned;   // Processes read in the latest scan
+    size_t timed_out; // Processes not read before the deadline
+    int samples;
+
+    long long sample_ms;
+    long clock_ticks; // sysconf(_SC_CLK_TCK)
+    long page_kb;
+
+    int proc_fd; // /proc, kept open and rewound for each scan
+    char *dents;
+    size_t dents_capacity;
+    int *pids;
+    size_t pid_capacity;
+
+    // CPU ticks per pid: the previous scan's table and the one being filled, swapped after each scan
+    struct pid_table prev;
+    struct pid_table next;
+};
+
+/**
+ * @brief Prepares a scanner for the top n processes. Free with proc_top_free().
+ */
+int proc_top_init(struct proc_top *pt, int n);
+
+/**
+ * @brief Lists /proc and reads every process's stat on worker threads.
+ *
+ * Processes not read by the deadline are left out and counted in timed_out.
+ */
+int proc_top_sample(struct proc_top *pt, long deadline_ms);
+
+void proc_top_free(struct proc_top *pt);
+
+#endif // PROCS_H
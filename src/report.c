@@ -0,0 +1,696 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "report.h"
+#include "colors.h"
+#include "mounts.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define BUFFER_SIZE 256
+#define GIB (1024.0 * 1024.0 * 1024.0)
+#define HEATMAP_COLUMNS 64
+
+/**
+ * @brief Returns s, or "unknown" when the field could not be collected.
+ */
+static const char *or_unknown(const char *s) {
+    return s != NULL ? s : "unknown";
+}
+
+/**
+ * @brief Suffix for a field whose last collection missed its deadline.
+ */
+static const char *stale_mark(const bling_snapshot *snap, unsigned int field) {
+    if (bling_field_stale(snap, field)) {
+        return " " BHBLK "(stale)" CRESET;
+    } else if (bling_field_status(snap, field) == BLING_ERR_TIMEOUT) {
+        return " " BHBLK "(timed out)" CRESET;
+    }
+    return "";
+}
+
+/**
+ * @brief Formats a count with a K/M/G suffix, e.g. 1234567 -> "1.2M".
+ */
+static void human_count(char *buf, size_t size, unsigned long long n) {
+    if (n >= 1000ull * 1000 * 1000) {
+        snprintf(buf, size, "%.1fG", n / 1e9);
+    } else if (n >= 1000ull * 1000) {
+        snprintf(buf, size, "%.1fM", n / 1e6);
+    } else if (n >= 1000) {
+        snprintf(buf, size, "%.1fK", n / 1e3);
+    } else {
+        snprintf(buf, size, "%llu", n);
+    }
+}
+
+static void print_topology(const struct topology *topo) {
+    char line[BUFFER_SIZE];
+    int n = 0;
+
+    for (int i = 0; i < topo->cache_count && n < BUFFER_SIZE; i++) {
+        const struct cache_info *c = &topo->caches[i];
+        const char *suffix = c->level == 1 ? (c->type == 'D' ? "d" : c->type == 'I' ? "i" : "") : "";
+
+        if (c->size_kb >= 1024 && c->size_kb % 1024 == 0) {
+            n += snprintf(line + n, BUFFER_SIZE - n, "%sL%d%s %lluM x%d", i ? ", " : "", c->level, suffix,
+                          c->size_kb / 1024, c->instances);
+        } else {
+            n += snprintf(line + n, BUFFER_SIZE - n, "%sL%d%s %lluK x%d", i ? ", " : "", c->level, suffix, c->size_kb,
+                          c->instances);
+        }
+    }
+    if (topo->cache_count > 0) {
+        printf("%scaches%s    %s\n", BHWHT, CRESET, line);
+    }
+
+    for (int i = 0; i < topo->node_count; i++) {
+        const struct numa_node *node = &topo->nodes[i];
+        printf("%snode%d%s     %d cpus, %.1f / %.1f GiB free\n", BHWHT, node->id, CRESET, node->cpus,
+               node->mem_free_kb / 1024.0 / 1024.0, node->mem_total_kb / 1024.0 / 1024.0);
+    }
+}
+
+static void print_mounts(const struct mount_table *table, int status) {
+    if (table->entries == NULL) {
+        printf("%smounts%s    %s\n", BHRED, CRESET, bling_strerror(status));
+        return;
+    }
+
+    printf("%smounts%s%s\n", BHRED, CRESET, status == BLING_ERR_TIMEOUT ? " (stale, a mount is not responding)" : "");
+    for (size_t i = 0; i < table->count; i++) {
+        const struct mount_entry *e = &table->entries[i];
+
+        if (e->status != BLING_OK) {
+            printf("  %-24s %-8s %s\n", e->mount_point, e->fstype, bling_strerror(e->status));
+            continue;
+        }
+
+        char inodes_used[16], inodes_total[16];
+        human_count(inodes_used, sizeof(inodes_used), e->inodes_used);
+        human_count(inodes_total, sizeof(inodes_total), e->inodes_total);
+
+        printf("  %-24s %-8s %7.1f / %7.1f GiB  inodes %6s / %-6s  reserved %.1f GiB\n", e->mount_point, e->fstype,
+               e->bytes_used / GIB, e->bytes_total / GIB, inodes_used, inodes_total, e->bytes_reserved / GIB);
+    }
+}
+
+/**
+ * @brief Appends "name=mitigation", the mitigation being the status up to its first ';'.
+ */
+static void print_mitigation(const struct vuln *vuln, int first) {
+    size_t len;
+    const char *text = vuln_mitigation(vuln, &len);
+    printf("%s%s=%.*s%s", first ? "" : ", ", vuln->name, (int)len, text, vuln->state == VULN_PARTIAL ? " (partial)" : "");
+}
+
+static void print_virt(const struct virt *v, const struct cpustat *cs) {
+    printf("%svirt%s      %s", BHWHT, CRESET, v->hypervisor);
+    if (v->source != NULL) {
+        printf(" (%s)", v->source);
+    }
+    if (cs != NULL) {
+        int cpu;
+        float max = cpustat_max_pct(cs, CPU_STEAL, &cpu);
+        printf(", steal %.1f%%", cs->all_pct[CPU_STEAL]);
+        if (cpu >= 0 && max > cs->all_pct[CPU_STEAL] + 0.05f) {
+            printf(" (max %.1f%% cpu%d)", max, cpu);
+        }
+    }
+
+    if (v->state_counts[VULN_VULNERABLE] > 0) {
+        printf(", %svulnerable:%s", BRED, CRESET);
+        for (int i = 0, first = 1; i < v->vuln_count; i++) {
+            if (v->vulns[i].state == VULN_VULNERABLE) {
+                printf("%s%s", first ? " " : ", ", v->vulns[i].name);
+                first = 0;
+            }
+        }
+    }
+    if (v->state_counts[VULN_MITIGATED] + v->state_counts[VULN_PARTIAL] > 0) {
+        printf(", mitigations: ");
+        for (int i = 0, first = 1; i < v->vuln_count; i++) {
+            if (v->vulns[i].state == VULN_MITIGATED || v->vulns[i].state == VULN_PARTIAL) {
+                print_mitigation(&v->vulns[i], first);
+                first = 0;
+            }
+        }
+    }
+    putchar('\n');
+}
+
+static void print_usage(const struct cpustat *cs) {
+    printf("%susage%s     %.1f%% (usr %.1f sys %.1f iow %.1f irq %.1f sirq %.1f steal %.1f)%s\n", BHGRN, CRESET,
+           cs->all_busy, cs->all_pct[CPU_USER], cs->all_pct[CPU_SYSTEM], cs->all_pct[CPU_IOWAIT], cs->all_pct[CPU_IRQ],
+           cs->all_pct[CPU_SOFTIRQ], cs->all_pct[CPU_STEAL], cs->samples < 2 ? " since boot" : "");
+}
+
+static void print_load(const struct pressure *pr) {
+    printf("%sload%s      %.2f %.2f %.2f (%llu running / %llu tasks)\n", BHYEL, CRESET, pr->load1, pr->load5, pr->load15,
+           pr->running, pr->tasks);
+
+    const struct psi *cpu = &pr->psi[PSI_CPU];
+    const struct psi *mem = &pr->psi[PSI_MEMORY];
+    const struct psi *io = &pr->psi[PSI_IO];
+    if (!cpu->present && !mem->present && !io->present) {
+        return;
+    }
+
+    // Live rates once there are two samples, the kernel's 10s average before that
+    int live = pr->samples >= 2;
+#define PSI_PCT(line) (live ? (line).rate : (line).avg10)
+    printf("%spressure%s  cpu %.1f%%  mem %.1f/%.1f%%  io %.1f/%.1f%% (some/full%s)\n", BHYEL, CRESET, PSI_PCT(cpu->some),
+           PSI_PCT(mem->some), PSI_PCT(mem->full), PSI_PCT(io->some), PSI_PCT(io->full), live ? "" : ", avg10");
+#undef PSI_PCT
+}
+
+/**
+ * @brief Appends the cgroup's effective CPU limit to the cpu summary, e.g. "1S/4C/8T, limit 2.0".
+ *
+ * Nothing is appended when the quota and cpuset leave every one of the host_cpus online CPUs usable.
+ */
+static void append_cpu_limit(char *buf, size_t size, const struct cgroup *cg, int host_cpus) {
+    double cpus = cgroup_effective_cpus(cg);
+    size_t n = strlen(buf);
+    if (cpus > 0.0 && (host_cpus <= 0 || cpus < host_cpus) && n < size) {
+        snprintf(buf + n, size - n, ", limit %.1f", cpus);
+    }
+}
+
+static void print_cgroup(const struct cgroup *cg) {
+    printf("%scgroup%s    %s", BHBLU, CRESET, cg->path);
+
+    if (cg->samples >= 2) {
+        // Live: CPUs' worth of usage and the share of quota periods that ran out since the last redraw
+        printf("  using %.2f cpus", cg->cpu_used);
+        if (cg->delta_periods > 0) {
+            printf(", throttled %.0f%% of periods (%llu ms)", 100.0 * cg->delta_throttled / cg->delta_periods,
+                   cg->delta_throttled_usec / 1000);
+        }
+    } else if (cg->nr_periods > 0) {
+        printf("  throttled %llu / %llu periods, %.1f s total", cg->nr_throttled, cg->nr_periods,
+               cg->throttled_usec / 1e6);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Prints "tcp 12: 8 established, 3 listen, 1 time_wait" listing only the states in use.
+ */
+static void print_socket_states(const char *proto, unsigned long long total, const unsigned long long *counts) {
+    printf("%s %llu", proto, total);
+    const char *sep = ": ";
+    for (int s = 1; s < SOCK_STATES; s++) {
+        if (counts[s] > 0) {
+            printf("%s%llu %s", sep, counts[s], socket_state_name(s));
+            sep = ", ";
+        }
+    }
+}
+
+static void print_sockets(const struct socket_summary *ss) {
+    printf("%ssockets%s   ", BHCYN, CRESET);
+    print_socket_states("tcp", ss->tcp_total, ss->tcp);
+    printf("\n          ");
+    print_socket_states("udp", ss->udp_total, ss->udp);
+    printf("%s\n", ss->source == SOCKET_SOURCE_PROC ? " (from /proc/net)" : "");
+}
+
+/**
+ * @brief Disks with any I/O since boot: IOPS and throughput per direction, await, queue depth and utilization.
+ *
+ * The queue depth is shown against the block layer's queue size, "qd 0.42/64" ("-" when sysfs has no nr_requests).
+ */
+static void print_io(const struct diskstats *ds) {
+    printf("%sio%s%s\n", BHRED, CRESET, ds->samples < 2 ? " (averages since boot)" : "");
+    for (size_t i = 0; i < ds->count; i++) {
+        const struct disk_dev *d = &ds->devs[i];
+        if (!d->whole || d->counters[DISK_READS] + d->counters[DISK_WRITES] == 0) {
+            continue;
+        }
+
+        char read_bps[16], write_bps[16];
+        human_count(read_bps, sizeof(read_bps), (unsigned long long)d->read_bps);
+        human_count(write_bps, sizeof(write_bps), (unsigned long long)d->write_bps);
+        char queue[16] = "-";
+        if (d->nr_requests > 0) {
+            snprintf(queue, sizeof(queue), "%d", d->nr_requests);
+        }
+
+        printf("  %-10s %-3s %-11s r %7.1f/s %6sB/s  w %7.1f/s %6sB/s  await %6.2f ms  qd %5.2f/%-4s  util %5.1f%%\n",
+               d->name, d->rotational ? "hdd" : "ssd", d->scheduler, d->read_iops, read_bps, d->write_iops, write_bps,
+               d->await_ms, d->queue_depth, queue, d->util_pct);
+    }
+}
+
+static void print_ioprobe(const struct ioprobe *p) {
+    printf("%sioprobe%s   %s, %s, %zu MiB file, qd %d, %lld ms%s\n", BHRED, CRESET, p->dir, p->engine, p->file_bytes >> 20,
+           IOPROBE_QUEUE_DEPTH, p->elapsed_ms, p->direct ? "" : ", buffered: O_DIRECT refused, page cache measured");
+    for (int t = 0; t < IOPROBE_TESTS; t++) {
+        const struct ioprobe_result *r = &p->results[t];
+        printf("  %-10s %8.1f MB/s %9.0f IOPS  p50 %8.1f us  p99 %8.1f us  max %8.1f us%s\n", ioprobe_test_name(t),
+               r->mbps, r->iops, r->p50_us, r->p99_us, r->max_us, r->failed ? "  (I/O error)" : "");
+    }
+}
+
+/**
+ * @brief One interface (or collapsed group) per line: rates once it has two samples, totals before that.
+ */
+static void print_iface(const struct net_iface *iface, const char *detail) {
+    char rx[16], tx[16], rx_pkts[16], tx_pkts[16];
+    int live = iface->samples >= 2;
+    const unsigned long long *totals = iface->counters;
+
+#define NET_VALUE(buf, c) human_count(buf, sizeof(buf), live ? (unsigned long long)iface->rates[c] : totals[c])
+    NET_VALUE(rx, NET_RX_BYTES);
+    NET_VALUE(tx, NET_TX_BYTES);
+    NET_VALUE(rx_pkts, NET_RX_PACKETS);
+    NET_VALUE(tx_pkts, NET_TX_PACKETS);
+#undef NET_VALUE
+
+    const double *rates = iface->rates;
+    const char *per = live ? "/s" : "  ";
+    printf("  %-12s %-22s rx %6sB%s %6s pkt%s  tx %6sB%s %6s pkt%s", iface->name, detail, rx, per, rx_pkts, per, tx, per,
+           tx_pkts, per);
+    if (live ? rates[NET_RX_ERRORS] + rates[NET_TX_ERRORS] + rates[NET_RX_DROPS] + rates[NET_TX_DROPS] > 0.0
+             : totals[NET_RX_ERRORS] + totals[NET_TX_ERRORS] + totals[NET_RX_DROPS] + totals[NET_TX_DROPS] > 0) {
+        if (live) {
+            printf("  %serr %.0f/s drop %.0f/s%s", BHRED, rates[NET_RX_ERRORS] + rates[NET_TX_ERRORS],
+                   rates[NET_RX_DROPS] + rates[NET_TX_DROPS], CRESET);
+        } else {
+            printf("  %serr %llu drop %llu%s", BHRED, totals[NET_RX_ERRORS] + totals[NET_TX_ERRORS],
+                   totals[NET_RX_DROPS] + totals[NET_TX_DROPS], CRESET);
+        }
+    }
+    printf("\n");
+}
+
+static void print_net(const struct netdev *nd, int show_all) {
+    char detail[64];
+
+    printf("%snet%s%s\n", BHGRN, CRESET, nd->samples < 2 ? " (totals since boot)" : "");
+    for (size_t i = 0; i < NETDEV_SLOTS; i++) {
+        const struct net_iface *iface = &nd->ifaces[i];
+        if (iface->ifindex == 0 || iface->seen != nd->samples || (iface->group >= 0 && !show_all)) {
+            continue;
+        }
+
+        if (iface->speed_mbps > 0) {
+            snprintf(detail, sizeof(detail), "%s %ldM mtu %d", iface->operstate, iface->speed_mbps, iface->mtu);
+        } else {
+            snprintf(detail, sizeof(detail), "%s mtu %d", iface->operstate, iface->mtu);
+        }
+        print_iface(iface, detail);
+    }
+
+    if (!show_all) {
+        struct net_iface groups[NET_GROUPS];
+        netdev_group_totals(nd, groups);
+        for (int g = 0; g < NET_GROUPS; g++) {
+            if (groups[g].ifindex > 0) {
+                snprintf(detail, sizeof(detail), "%d interface%s", groups[g].ifindex, groups[g].ifindex == 1 ? "" : "s");
+                print_iface(&groups[g], detail);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Top processes by memory and by CPU side by side; CPU is cumulative time until there are two scans.
+ */
+static void print_top(const struct proc_top *pt) {
+    int live = pt->samples >= 2;
+
+    printf("%sprocesses%s %zu scanned", BHMAG, CRESET, pt->scanned);
+    if (pt->timed_out > 0) {
+        printf(", %s%zu timed out%s", BHBLK, pt->timed_out, CRESET);
+    }
+    printf("\n  %-34s %s\n", "memory", live ? "cpu" : "cpu time");
+
+    int rows = pt->rss_count > pt->cpu_count ? pt->rss_count : pt->cpu_count;
+    for (int i = 0; i < rows; i++) {
+        if (i < pt->rss_count) {
+            const struct proc_info *p = &pt->top_rss[i];
+            printf("  %8.1f MiB %7d %-14.14s ", p->rss_kb / 1024.0, p->pid, p->comm);
+        } else {
+            printf("  %34s ", "");
+        }
+
+        if (i < pt->cpu_count) {
+            const struct proc_info *p = &pt->top_cpu[i];
+            if (live) {
+                printf("%7.1f%% %7d %s\n", p->cpu_pct, p->pid, p->comm);
+            } else {
+                printf("%7.1fs %7d %s\n", (double)p->cpu_ticks / pt->clock_ticks, p->pid, p->comm);
+            }
+        } else {
+            printf("\n");
+        }
+    }
+}
+
+static void print_vmstat(const struct vmstat *vm) {
+    const double *r = vm->rates;
+    char ctxt[16];
+    const char *since = vm->samples < 2 ? " since boot" : "";
+
+    printf("%spaging%s    majflt %.1f/s  swap in/out %.1f/%.1f/s  scan %.0f/%.0f steal %.0f/%.0f/s (kswapd/direct)"
+           "  thp fallback %.1f/s%s\n",
+           BHBLU, CRESET, r[VM_PGMAJFAULT], r[VM_PSWPIN], r[VM_PSWPOUT], r[VM_PGSCAN_KSWAPD], r[VM_PGSCAN_DIRECT],
+           r[VM_PGSTEAL_KSWAPD], r[VM_PGSTEAL_DIRECT], r[VM_THP_FAULT_FALLBACK] + r[VM_THP_COLLAPSE_ALLOC_FAILED], since);
+    if (vm->has_sched) {
+        human_count(ctxt, sizeof(ctxt), (unsigned long long)r[VM_CTXT]);
+        printf("%ssched%s     %s ctxt/s  %.1f forks/s%s\n", BHYEL, CRESET, ctxt, r[VM_FORKS], since);
+    }
+}
+
+/**
+ * @brief Prints one pool as "<size> free/total", e.g. "2M 512/1024".
+ */
+static void print_hugepage_pool(const struct hugepage_pool *pool) {
+    if (pool->size_kb >= 1024 * 1024) {
+        printf("%lluG %llu/%llu", pool->size_kb / (1024 * 1024), pool->free, pool->total);
+    } else {
+        printf("%lluM %llu/%llu", pool->size_kb / 1024, pool->free, pool->total);
+    }
+}
+
+static void print_frag(const struct memfrag *mf, int details) {
+    unsigned long long huge_free_kb;
+    double unusable;
+    memfrag_totals(mf, &huge_free_kb, &unusable);
+
+    printf("%shugepages%s ", BHMAG, CRESET);
+    for (int i = 0; i < mf->pool_count; i++) {
+        printf(i ? ", " : "");
+        print_hugepage_pool(&mf->pools[i]);
+    }
+    printf("%sfree  order %d blocks %.1f GiB free, %.0f%% of free memory fragmented\n", mf->pool_count ? " " : "",
+           mf->huge_order, huge_free_kb / (1024.0 * 1024.0), unusable * 100.0);
+    if (!details) {
+        return;
+    }
+
+    for (size_t z = 0; z < mf->zone_count; z++) {
+        const struct frag_zone *zone = &mf->zones[z];
+        printf("  node%-3d %-8s", zone->node, zone->name);
+        for (int o = 0; o < zone->orders; o++) {
+            printf(" %6llu", zone->free[o]);
+        }
+        if (zone->frag_index < 0.0) {
+            printf("  unusable %.2f index ok", zone->unusable);
+        } else {
+            printf("  unusable %.2f index %.2f", zone->unusable, zone->frag_index);
+        }
+        if (mf->has_pagetypes) {
+            printf("  pageblocks");
+            for (int t = 0; t < FRAG_TYPES; t++) {
+                printf(" %s %llu", frag_type_names[t], zone->pageblocks[t]);
+            }
+        }
+        putchar('\n');
+    }
+
+    for (size_t i = 0; i < mf->node_pool_count; i++) {
+        const struct hugepage_pool *pool = &mf->node_pools[i];
+        if (i == 0 || mf->node_pools[i - 1].node != pool->node) {
+            printf("%s  node%-3d hugepages ", i ? "\n" : "", pool->node);
+        } else {
+            printf(", ");
+        }
+        print_hugepage_pool(pool);
+        if (pool->surplus > 0) {
+            printf(" (%llu surplus)", pool->surplus);
+        }
+    }
+    if (mf->node_pool_count > 0) {
+        printf(" free\n");
+    }
+}
+
+static void print_thermal(const struct thermal *t) {
+    printf("%sthermal%s  ", BHRED, CRESET);
+    const struct thermal_sensor *hottest = thermal_hottest(t);
+    if (hottest != NULL) {
+        printf(" hottest %.1f°C %s", hottest->celsius, hottest->name);
+    } else {
+        printf(" no temperature sensors");
+    }
+    if (t->core_count + t->package_count > 0) {
+        printf(", throttling core %.2f/s package %.2f/s%s", t->core_throttle_rate, t->package_throttle_rate,
+               t->samples < 2 ? " since boot" : "");
+    }
+    if (t->rapl_count > 0) {
+        printf(", power");
+        for (int i = 0; i < t->rapl_count; i++) {
+            if (t->samples < 2) {
+                printf("%s %s -", i ? "," : "", t->rapl[i].name);
+            } else {
+                printf("%s %s %.1f W", i ? "," : "", t->rapl[i].name, t->rapl[i].watts);
+            }
+        }
+    } else if (t->rapl_denied) {
+        printf(", power needs root");
+    }
+    putchar('\n');
+
+    for (int i = 0; i < t->sensor_count; i++) {
+        const struct thermal_sensor *s = &t->sensors[i];
+        if (!s->valid) {
+            continue;
+        }
+        printf("  %-32s %6.1f°C", s->name, s->celsius);
+        if (s->crit_celsius > 0.0) {
+            printf("  crit %.0f°C", s->crit_celsius);
+        }
+        putchar('\n');
+    }
+}
+
+static void print_bench(const struct bench *b) {
+    printf("%sbench%s     %lld ms, pinned to the CPUs this process may use\n", BHMAG, CRESET, b->elapsed_ms);
+    for (int i = 0; i < b->stream_count; i++) {
+        printf("  stream    node%d %.1f GB/s triad (%d thread%s)\n", b->stream[i].node, b->stream[i].gbps,
+               b->stream[i].threads, b->stream[i].threads == 1 ? "" : "s");
+    }
+    if (b->latency_count > 0) {
+        printf("  latency  ");
+        for (int i = 0; i < b->latency_count; i++) {
+            printf(" %s %.1f ns", b->latency[i].label, b->latency[i].ns);
+        }
+        putchar('\n');
+    }
+    printf("  compute   int %.1f / %.1f Gop/s, fp %.1f / %.1f GFLOP/s (1 / %d thread%s)\n", b->int_single, b->int_all,
+           b->fp_single, b->fp_all, b->threads, b->threads == 1 ? "" : "s");
+    printf("  syscall   getppid %.0f ns, clock_gettime %.0f ns\n", b->syscall_ns, b->vdso_ns);
+}
+
+static void print_audit(const struct audit *a) {
+    static const char *const verdicts[] = { [AUDIT_OK] = GRN "ok  ", [AUDIT_WARN] = BRED "warn", [AUDIT_INFO] = YEL "info" };
+    size_t warnings = 0;
+    for (size_t i = 0; i < a->count; i++) {
+        warnings += a->findings[i].verdict == AUDIT_WARN;
+    }
+
+    printf("%saudit%s     %s profile, %zu warning%s (%.2f ms)\n", BHCYN, CRESET, audit_profile_name(a->profile), warnings,
+           warnings == 1 ? "" : "s", a->elapsed_us / 1000.0);
+    for (size_t i = 0; i < a->count; i++) {
+        const struct audit_finding *f = &a->findings[i];
+        char value[AUDIT_VALUE_SIZE + 24];
+        if (f->policies > 0) {
+            snprintf(value, sizeof(value), "%s (%d polic%s)", f->value, f->policies, f->policies == 1 ? "y" : "ies");
+        } else {
+            snprintf(value, sizeof(value), "%s", f->value);
+        }
+        printf("  %s%s %-26s ", verdicts[f->verdict], CRESET, f->knob);
+        if (f->verdict == AUDIT_OK || f->expected == NULL) {
+            printf("%s\n", value);
+        } else if (f->expected[0] == '!') {
+            printf("%-32s want other than %s\n", value, f->expected + 1);
+        } else {
+            printf("%-32s want %s\n", value, f->expected);
+        }
+    }
+}
+
+/**
+ * @brief One block character per CPU, height and color by how busy it was.
+ */
+static void print_heatmap(const struct cpustat *cs) {
+    static const char *const blocks[] = { " ", "\u2581", "\u2582", "\u2583", "\u2584",
+                                          "\u2585", "\u2586", "\u2587", "\u2588" };
+
+    for (int row = 0; row < cs->count; row += HEATMAP_COLUMNS) {
+        printf("  %4d ", row);
+        for (int cpu = row; cpu < row + HEATMAP_COLUMNS && cpu < cs->count; cpu++) {
+            if (!cs->online[cpu]) {
+                printf("%s.%s", BHBLK, CRESET);
+                continue;
+            }
+
+            float busy = cs->busy[cpu];
+            const char *color = busy >= 80.0f ? BHRED : busy >= 50.0f ? BHYEL : BHGRN;
+            int level = (int)(busy / 100.0f * 8.0f + 0.5f);
+            if (level > 8) {
+                level = 8;
+            } else if (level < 1 && busy > 0.0f) {
+                level = 1;
+            }
+            printf("%s%s%s", color, blocks[level], CRESET);
+        }
+        printf("\n");
+    }
+}
+
+void print_report(const struct report *r) {
+    bling_snapshot *snap = r->snap;
+
+    const char *os_name = bling_os_name(snap);
+    const char *os_version = bling_os_version(snap);
+    const char *os_build_id = bling_os_build_id(snap);
+
+    unsigned long long uptime = bling_uptime_seconds(snap);
+
+    char cpu_summary[64];
+    int host_cpus = r->topo != NULL ? r->topo->cpus : bling_cpu_count(snap);
+    if (r->topo != NULL) {
+        topology_summary(r->topo, cpu_summary, sizeof(cpu_summary));
+    } else {
+        snprintf(cpu_summary, sizeof(cpu_summary), "%d", host_cpus);
+    }
+    if (r->cgroup != NULL) {
+        append_cpu_limit(cpu_summary, sizeof(cpu_summary), r->cgroup, host_cpus);
+    }
+
+    char cgroup_mem[64] = "";
+    if (r->cgroup != NULL && r->cgroup->has_memory) {
+        if (r->cgroup->mem_max != CGROUP_UNLIMITED) {
+            snprintf(cgroup_mem, sizeof(cgroup_mem), " (cgroup %.1f / %.1f GiB)", r->cgroup->mem_current / GIB,
+                     r->cgroup->mem_max / GIB);
+        } else {
+            snprintf(cgroup_mem, sizeof(cgroup_mem), " (cgroup %.1f GiB, no limit)", r->cgroup->mem_current / GIB);
+        }
+    }
+
+    char user_host_buffer[BUFFER_SIZE];
+    snprintf(user_host_buffer, BUFFER_SIZE, "%suser/host%s %s@%s%s", BHGRN, CRESET, r->username,
+             or_unknown(bling_hostname(snap)), stale_mark(snap, BLING_FIELD_HOSTNAME));
+
+    char os_buffer[BUFFER_SIZE];
+    if (os_name != NULL && os_version != NULL && os_build_id != NULL) {
+        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        %s %s (%s)", BHCYN, CRESET, os_name, os_version, os_build_id);
+    } else if (os_name != NULL && os_version != NULL) {
+        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        %s %s", BHCYN, CRESET, os_name, os_version);
+    } else if (os_name != NULL) {
+        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        %s", BHCYN, CRESET, os_name);
+    } else {
+        snprintf(os_buffer, BUFFER_SIZE, "%sos%s        unknown", BHCYN, CRESET);
+    }
+
+    printf("%s\n", user_host_buffer);
+    printf("%s%s\n", os_buffer, stale_mark(snap, BLING_FIELD_OS));
+    printf("%skernel%s    %s%s\n", BHYEL, CRESET, or_unknown(bling_kernel(snap)), stale_mark(snap, BLING_FIELD_KERNEL));
+    printf("%sshell%s     %s\n", BHMAG, CRESET, r->shell);
+    printf("%scpu%s       %s (%s) @ %.2f GHz%s\n", BHWHT, CRESET, or_unknown(bling_cpu_name(snap)), cpu_summary,
+           (float)bling_cpu_max_khz(snap) / 1000 / 1000, stale_mark(snap, BLING_FIELD_CPU));
+    if (r->virt != NULL) {
+        print_virt(r->virt, r->cpustat);
+    }
+    if (r->opts.show_topology && r->topo != NULL) {
+        print_topology(r->topo);
+    }
+    if (r->cpustat != NULL) {
+        print_usage(r->cpustat);
+        if (r->opts.show_heatmap) {
+            print_heatmap(r->cpustat);
+        }
+    }
+    if (r->pressure != NULL) {
+        print_load(r->pressure);
+    }
+    if (r->vmstat != NULL) {
+        print_vmstat(r->vmstat);
+    }
+    printf("%sram%s       %.1f / %.1f GiB%s%s\n", BHBLU, CRESET, bling_mem_used_gib(snap), bling_mem_total_gib(snap),
+           cgroup_mem, stale_mark(snap, BLING_FIELD_MEM));
+    if (r->cgroup != NULL && strcmp(r->cgroup->path, "/") != 0) {
+        print_cgroup(r->cgroup);
+    }
+    if (r->frag != NULL) {
+        print_frag(r->frag, r->opts.show_frag == 2);
+    }
+    printf("%suptime%s    %llud %lluh %llum %llus%s\n", BHBLK, CRESET, uptime / 86400, uptime % 86400 / 3600,
+           uptime % 3600 / 60, uptime % 60, stale_mark(snap, BLING_FIELD_UPTIME));
+    printf("%sdisk%s      %.1f / %.1f GiB%s\n", BHRED, CRESET, bling_disk_used_gib(snap), bling_disk_total_gib(snap),
+           stale_mark(snap, BLING_FIELD_DISK));
+
+    if (r->thermal != NULL) {
+        print_thermal(r->thermal);
+    }
+    if (r->io != NULL) {
+        print_io(r->io);
+    }
+    if (r->ioprobe != NULL) {
+        print_ioprobe(r->ioprobe);
+    }
+    if (r->net != NULL) {
+        print_net(r->net, r->opts.show_net == 2);
+    }
+    if (r->sockets != NULL) {
+        print_sockets(r->sockets);
+    }
+    if (r->top != NULL) {
+        print_top(r->top);
+    }
+
+    if (r->audit != NULL) {
+        print_audit(r->audit);
+    }
+    if (r->bench != NULL) {
+        print_bench(r->bench);
+    }
+
+    if (r->opts.show_mounts) {
+        print_mounts(r->mounts, r->mounts_status);
+    }
+}
+
+void print_timings(const bling_snapshot *snap, const struct run_timings *t) {
+    static const struct {
+        const char *name;
+        unsigned int field;
+    } collectors[] = {
+        { "get_hostname", BLING_FIELD_HOSTNAME }, { "get_os", BLING_FIELD_OS },     { "get_kernel", BLING_FIELD_KERNEL },
+        { "get_meminfo", BLING_FIELD_MEM },       { "get_diskinfo", BLING_FIELD_DISK }, { "get_cpu", BLING_FIELD_CPU },
+        { "get_uptime", BLING_FIELD_UPTIME },
+    };
+    int counted = 0;
+
+    fprintf(stderr, "timings\n  %-14s %9s %9s %7s %11s %7s\n", "collector", "wall ms", "cpu ms", "opens", "bytes read",
+            "allocs");
+    for (size_t i = 0; i < sizeof(collectors) / sizeof(collectors[0]); i++) {
+        struct bling_timing timing;
+        int status = bling_field_status(snap, collectors[i].field);
+        if (bling_field_timing(snap, collectors[i].field, &timing) != BLING_OK) {
+            fprintf(stderr, "  %-14s %s\n", collectors[i].name, bling_strerror(status));
+            continue;
+        }
+
+        fprintf(stderr, "  %-14s %9.3f %9.3f", collectors[i].name, timing.wall_ns / 1e6, timing.cpu_ns / 1e6);
+        if (timing.opens >= 0) {
+            fprintf(stderr, " %7lld %11lld %7lld", timing.opens, timing.bytes_read, timing.allocs);
+            counted = 1;
+        } else {
+            fprintf(stderr, " %7s %11s %7s", "-", "-", "-");
+        }
+        fprintf(stderr, "%s%s\n", status != BLING_OK ? "  " : "", status != BLING_OK ? bling_strerror(status) : "");
+    }
+
+    fprintf(stderr, "  %-14s %9.3f  (fields in parallel, from start)\n", "snapshot", t->snapshot_ns / 1e6);
+    fprintf(stderr, "  %-14s %9.3f\n", "first byte", t->first_byte_ns / 1e6);
+    fprintf(stderr, "  %-14s %9.3f\n", "total", t->total_ns / 1e6);
+    if (!counted) {
+        fprintf(stderr, "  opens, bytes read and allocs are counted by build/bling-instrumented\n");
+    }
+}
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef REPORT_H
+#define REPORT_H
+
+#include "audit.h"
+#include "bench.h"
+#include "bling.h"
+#include "cgroup.h"
+#include "diskstats.h"
+#include "ioprobe.h"
+#include "memfrag.h"
+#include "mounts.h"
+#include "netdev.h"
+#include "cpustat.h"
+#include "pressure.h"
+#include "procs.h"
+#include "sockets.h"
+#include "thermal.h"
+#include "topology.h"
+#include "virt.h"
+#include "vmstat.h"
+
+struct report_options {
+    int show_mounts;
+    int show_topology;
+    int show_heatmap;
+    int show_sockets;
+    int show_io;
+    int show_net; // 1 = virtual interfaces collapsed per prefix, 2 = every interface
+    int show_frag; // 1 = one-line summary, 2 = per zone and per node
+    int show_audit;
+    int show_thermal;
+    int show_bench;
+    const char *ioprobe_dir; // NULL = no storage probe
+    size_t ioprobe_size_mb;
+    enum audit_profile audit_profile;
+    int json;
+    int top_count; // 0 = no top processes section
+    long mounts_deadline;
+    long top_deadline;
+    long ioprobe_deadline; // Time budget of the whole probe
+};
+
+/**
+ * @brief Everything one rendering of the report needs. Collectors that failed are NULL.
+ */
+struct report {
+    struct report_options opts;
+    const char *username;
+    const char *shell;
+
+    bling_snapshot *snap;
+    const struct topology *topo;
+    const struct mount_table *mounts; // With show_mounts; no entries if mounts_status says why
+    int mounts_status;                // BLING_ERR_TIMEOUT: still the last table, a mount is hung
+    const struct cpustat *cpustat;
+    const struct virt *virt;
+    const struct pressure *pressure;
+    const struct vmstat *vmstat;
+    const struct memfrag *frag;
+    const struct cgroup *cgroup;
+    const struct proc_top *top;
+    const struct socket_summary *sockets;
+    const struct netdev *net;
+    const struct diskstats *io;
+    const struct audit *audit;
+    const struct thermal *thermal;
+    const struct bench *bench; // Measured once, before the first rendering
+    const struct ioprobe *ioprobe; // Likewise
+};
+
+/**
+ * @brief Prints the colored text report to stdout.
+ */
+void print_report(const struct report *r);
+
+/**
+ * @brief Prints the report as a single line of JSON, so --watch --json streams NDJSON.
+ */
+void print_report_json(const struct report *r);
+
+/**
+ * @brief Where one run's time went, for --timings. Each is measured from the start of main().
+ */
+struct run_timings {
+    long long snapshot_ns;   // bling_collect() returned, every field having run in parallel
+    long long first_byte_ns; // The report started printing
+    long long total_ns;      // The report was written out
+};
+
+/**
+ * @brief Prints the cost of each snapshot collector and the run's totals to stderr, so JSON on stdout stays valid.
+ */
+void print_timings(const bling_snapshot *snap, const struct run_timings *t);
+
+#endif // REPORT_H
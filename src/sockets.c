@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sockets.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+
+#include <errno.h>
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Netlink dumps fill each message up to the reader's buffer size (capped by the kernel), so read big
+#define DIAG_BUFFER_SIZE (64 * 1024)
+#define DIAG_SOCKET_RCVBUF (4 * 1024 * 1024)
+
+// Every state the kernel can report, bit n for state n
+#define ALL_STATES (((1u << SOCK_STATES) - 1) & ~1u)
+
+static const char *const state_names[SOCK_STATES] = {
+    [SOCK_STATE_ESTABLISHED] = "established", [SOCK_STATE_SYN_SENT] = "syn_sent",
+    [SOCK_STATE_SYN_RECV] = "syn_recv",       [SOCK_STATE_FIN_WAIT1] = "fin_wait1",
+    [SOCK_STATE_FIN_WAIT2] = "fin_wait2",     [SOCK_STATE_TIME_WAIT] = "time_wait",
+    [SOCK_STATE_CLOSE] = "close",             [SOCK_STATE_CLOSE_WAIT] = "close_wait",
+    [SOCK_STATE_LAST_ACK] = "last_ack",       [SOCK_STATE_LISTEN] = "listen",
+    [SOCK_STATE_CLOSING] = "closing",         [SOCK_STATE_NEW_SYN_RECV] = "new_syn_recv",
+};
+
+const char *socket_state_name(int state) {
+    return state > 0 && state < SOCK_STATES ? state_names[state] : NULL;
+}
+
+/**
+ * @brief Runs one SOCK_DIAG_BY_FAMILY dump and adds each socket's state to counts.
+ */
+static int diag_dump(int fd, char *buf, int family, int protocol, unsigned long long *counts) {
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } msg = {
+        .nlh = {
+            .nlmsg_len = sizeof(msg),
+            .nlmsg_type = SOCK_DIAG_BY_FAMILY,
+            .nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP,
+        },
+        .req = {
+            .sdiag_family = (unsigned char)family,
+            .sdiag_protocol = (unsigned char)protocol,
+            .idiag_states = ALL_STATES, // Filtered in the kernel; no extensions, so replies stay minimal
+        },
+    };
+
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    if (sendto(fd, &msg, sizeof(msg), 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0) {
+        return errno_status(errno);
+    }
+
+    for (;;) {
+        ssize_t n = recv(fd, buf, DIAG_BUFFER_SIZE, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno_status(errno);
+        }
+
+        for (struct nlmsghdr *h = (struct nlmsghdr *)buf; NLMSG_OK(h, n); h = NLMSG_NEXT(h, n)) {
+            if (h->nlmsg_type == NLMSG_DONE) {
+                return BLING_OK;
+            }
+            if (h->nlmsg_type == NLMSG_ERROR) {
+                const struct nlmsgerr *err = NLMSG_DATA(h);
+                return err->error != 0 ? errno_status(-err->error) : BLING_OK;
+            }
+
+            const struct inet_diag_msg *diag = NLMSG_DATA(h);
+            if (diag->idiag_state < SOCK_STATES) {
+                counts[diag->idiag_state]++;
+            }
+        }
+    }
+}
+
+static int summary_netlink(struct socket_summary *out) {
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (fd < 0) {
+        return errno_status(errno);
+    }
+
+    int rcvbuf = DIAG_SOCKET_RCVBUF;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)); // Best effort, capped by rmem_max
+
+    char *buf = malloc(DIAG_BUFFER_SIZE);
+    if (buf == NULL) {
+        close(fd);
+        return BLING_ERR_NOMEM;
+    }
+
+    static const int families[] = { AF_INET, AF_INET6 };
+    int status = BLING_OK;
+    for (size_t i = 0; i < sizeof(families) / sizeof(families[0]) && status == BLING_OK; i++) {
+        status = diag_dump(fd, buf, families[i], IPPROTO_TCP, out->tcp);
+        if (status == BLING_OK) {
+            status = diag_dump(fd, buf, families[i], IPPROTO_UDP, out->udp);
+        }
+        if (status == BLING_ERR_NOTFOUND && families[i] == AF_INET6) {
+            status = BLING_OK; // No IPv6 (ENOENT from the kernel): nothing to count
+        }
+    }
+
+    free(buf);
+    close(fd);
+    return status;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Adds the state column ("st", hex) of each line of a /proc/net/{tcp,udp}[6] table to counts.
+ *
+ * "   0: 0100007F:BC8F 00000000:0000 0A 00000000:00000000 ..."
+ */
+static void count_proc_table(const char *buf, unsigned long long *counts) {
+    for (const char *p = next_line(buf); *p != '\0'; p = next_line(p)) {
+        const char *f = p;
+        while (*f == ' ') {
+            f++;
+        }
+        skip_field(&f); // sl
+        skip_field(&f); // local address
+        skip_field(&f); // remote address
+
+        int hi = hex_digit(f[0]);
+        int lo = hex_digit(f[1]);
+        if (hi >= 0 && lo >= 0 && hi * 16 + lo < SOCK_STATES) {
+            counts[hi * 16 + lo]++;
+        }
+    }
+}
+
+static int summary_proc(struct socket_summary *out) {
+    static const struct {
+        const char *path;
+        int tcp;
+    } tables[] = {
+        { "/proc/net/tcp", 1 },
+        { "/proc/net/tcp6", 1 },
+        { "/proc/net/udp", 0 },
+        { "/proc/net/udp6", 0 },
+    };
+
+    char *buf = NULL;
+    size_t capacity = 0;
+    int found = 0;
+
+    for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++) {
+        if (read_file_buf(tables[i].path, &buf, &capacity) < 0) {
+            continue; // tcp6/udp6 are missing without IPv6
+        }
+        count_proc_table(buf, tables[i].tcp ? out->tcp : out->udp);
+        found = 1;
+    }
+
+    free(buf);
+    return found ? BLING_OK : BLING_ERR_NOTFOUND;
+}
+
+int get_socket_summary(struct socket_summary *out) {
+    memset(out, 0, sizeof(*out));
+
+    // Netlink answers for the live host and leaves nothing to capture, so capture and replay use /proc/net
+    out->source = SOCKET_SOURCE_NETLINK;
+    int status = file_rooted() || file_capturing() ? BLING_ERR_NOTFOUND : summary_netlink(out);
+    if (status != BLING_OK) {
+        memset(out, 0, sizeof(*out));
+        out->source = SOCKET_SOURCE_PROC;
+        status = summary_proc(out);
+    }
+
+    for (int s = 0; s < SOCK_STATES; s++) {
+        out->tcp_total += out->tcp[s];
+        out->udp_total += out->udp[s];
+    }
+    return status;
+}
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef SOCKETS_H
+#define SOCKETS_H
+
+// Kernel TCP state numbers (include/net/tcp_states.h); UDP reuses ESTABLISHED and CLOSE
+enum socket_state {
+    SOCK_STATE_ESTABLISHED = 1,
+    SOCK_STATE_SYN_SENT,
+    SOCK_STATE_SYN_RECV,
+    SOCK_STATE_FIN_WAIT1,
+    SOCK_STATE_FIN_WAIT2,
+    SOCK_STATE_TIME_WAIT,
+    SOCK_STATE_CLOSE,
+    SOCK_STATE_CLOSE_WAIT,
+    SOCK_STATE_LAST_ACK,
+    SOCK_STATE_LISTEN,
+    SOCK_STATE_CLOSING,
+    SOCK_STATE_NEW_SYN_RECV,
+    SOCK_STATES
+};
+
+enum socket_source { SOCKET_SOURCE_NETLINK, SOCKET_SOURCE_PROC };
+
+/**
+ * @brief Socket counts per state for IPv4 and IPv6 together, indexed by enum socket_state.
+ */
+struct socket_summary {
+    int source; // enum socket_source
+    unsigned long long tcp[SOCK_STATES];
+    unsigned long long udp[SOCK_STATES];
+    unsigned long long tcp_total;
+    unsigned long long udp_total;
+};
+
+/**
+ * @brief Counts TCP and UDP sockets by state.
+ *
+ * Asks the kernel through NETLINK_SOCK_DIAG and only tallies the state byte of each
+ * reply, so nothing per socket is kept. Falls back to /proc/net/{tcp,tcp6,udp,udp6}
+ * when sock_diag is unavailable (kernel without inet_diag, seccomp, ...).
+ */
+int get_socket_summary(struct socket_summary *out);
+
+/**
+ * @brief Lowercase name of a state ("established", "time_wait", ...), or NULL.
+ */
+const char *socket_state_name(int state);
+
+#endif // SOCKETS_H
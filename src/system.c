@@ -1,22 +1,24 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "system.h"
+#include "bling.h"
 #include "file.h"
 #include "util.h"
 
 #include <ctype.h>
+#include <errno.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/statvfs.h>
 
-struct os get_os() {
-    struct os os = {
-        .name = NULL,
-        .version = NULL,
-        .build_id = NULL,
-    };
+int get_os(struct os *os) {
+    os->name = NULL;
+    os->version = NULL;
+    os->build_id = NULL;
 
     char *name_ptr = NULL;
     char *version_ptr = NULL;
@@ -24,6 +26,9 @@ struct os get_os() {
 
     int num_lines = 0;
     char **fileLines = lines("/etc/os-release", &num_lines);
+    if (fileLines == NULL) {
+        return errno_status(errno);
+    }
 
     for (int i = 0; i < num_lines; i++) {
         char *line = fileLines[i];
@@ -40,35 +45,45 @@ struct os get_os() {
     // Remove quotes in-place *before* copying
     if (name_ptr != NULL) {
         removeChars(name_ptr, '"');
-        os.name = strdup(name_ptr);
+        os->name = strdup(name_ptr);
     }
 
     if (version_ptr != NULL) {
         removeChars(version_ptr, '"');
-        os.version = strdup(version_ptr);
+        os->version = strdup(version_ptr);
     }
 
     if (build_id_ptr != NULL) {
         removeChars(build_id_ptr, '"');
-        os.build_id = strdup(build_id_ptr);
+        os->build_id = strdup(build_id_ptr);
     }
 
     free_string_array(fileLines);
 
-    return os;
+    if ((name_ptr != NULL && os->name == NULL) || (version_ptr != NULL && os->version == NULL) ||
+        (build_id_ptr != NULL && os->build_id == NULL)) {
+        free(os->name);
+        free(os->version);
+        free(os->build_id);
+        os->name = os->version = os->build_id = NULL;
+        return BLING_ERR_NOMEM;
+    }
+
+    return name_ptr != NULL ? BLING_OK : BLING_ERR_PARSE;
 }
 
-struct mem get_meminfo() {
-    struct mem mem = {
-        .max_memory = 0.0,
-        .used_memory = 0.0,
-    };
+int get_meminfo(struct mem *mem) {
+    mem->max_memory = 0.0;
+    mem->used_memory = 0.0;
 
     double total_mem_kb = 0.0;
     double avail_mem_kb = 0.0;
 
     int num_lines = 0;
     char **fileLines = lines("/proc/meminfo", &num_lines);
+    if (fileLines == NULL) {
+        return errno_status(errno);
+    }
 
     for (int i = 0; i < num_lines; i++) {
         char *line = fileLines[i];
@@ -88,72 +103,78 @@ struct mem get_meminfo() {
         }
     }
 
-    mem.max_memory = total_mem_kb / 1024.0 / 1024.0; // KiB to GiB
+    mem->max_memory = total_mem_kb / 1024.0 / 1024.0; // KiB to GiB
     if (total_mem_kb > 0 && avail_mem_kb > 0) {
-        mem.used_memory = (total_mem_kb - avail_mem_kb) / 1024.0 / 1024.0; // KiB to GiB
+        mem->used_memory = (total_mem_kb - avail_mem_kb) / 1024.0 / 1024.0; // KiB to GiB
     }
 
     free_string_array(fileLines);
 
-    return mem;
+    return total_mem_kb > 0 ? BLING_OK : BLING_ERR_PARSE;
 }
 
-struct uptime get_uptime() {
+int get_uptime(struct uptime *up) {
     const unsigned long long SEC_PER_MIN = 60;
     const unsigned long long SEC_PER_HOUR = 3600;
     const unsigned long long SEC_PER_DAY = 86400;
 
     int num_lines = 0;
     char **fileLines = lines("/proc/uptime", &num_lines);
+    if (fileLines == NULL) {
+        return errno_status(errno);
+    }
 
-    struct uptime up = { 0, 0, 0, 0 };
+    *up = (struct uptime){ 0, 0, 0, 0, 0 };
 
-    if (fileLines != NULL && num_lines > 0) {
+    int status = BLING_ERR_PARSE;
+    if (num_lines > 0) {
         // strtoull stops at the first non-numeric char (the space)
         unsigned long long total_seconds = strtoull(fileLines[0], NULL, 10);
 
-        up.days = total_seconds / SEC_PER_DAY;
-        up.hours = (total_seconds % SEC_PER_DAY) / SEC_PER_HOUR;
-        up.minutes = (total_seconds % SEC_PER_HOUR) / SEC_PER_MIN;
-        up.seconds = total_seconds % SEC_PER_MIN;
+        up->days = total_seconds / SEC_PER_DAY;
+        up->hours = (total_seconds % SEC_PER_DAY) / SEC_PER_HOUR;
+        up->minutes = (total_seconds % SEC_PER_HOUR) / SEC_PER_MIN;
+        up->seconds = total_seconds % SEC_PER_MIN;
+        up->total_seconds = total_seconds;
+        status = BLING_OK;
     }
 
     free_string_array(fileLines);
 
-    return up;
+    return status;
 }
 
-struct disk get_diskinfo() {
-    struct disk d = {
-        .total_memory_gb = 0.0,
-        .used_memory_gb = 0.0,
-    };
+double uptime_seconds(void) {
+    char buf[64];
+    if (read_file("/proc/uptime", buf, sizeof(buf)) <= 0) {
+        return 0.0;
+    }
+    const char *p = buf;
+    return scan_decimal(&p);
+}
+
+int get_diskinfo(struct disk *d) {
+    d->total_memory_gb = 0.0;
+    d->used_memory_gb = 0.0;
     struct statvfs disk_info;
 
-    if (statvfs("/", &disk_info) == 0) {
-        // Use 1024.0 for floating point division
-        const double to_gib = 1024.0 * 1024.0 * 1024.0;
-        d.total_memory_gb = (double)disk_info.f_blocks * disk_info.f_frsize / to_gib;
-        d.used_memory_gb = (double)(disk_info.f_blocks - disk_info.f_bfree) * disk_info.f_frsize / to_gib;
-    } else {
-        perror("statvfs failed");
+    if (file_statvfs("/", &disk_info) != 0) {
+        return errno_status(errno);
     }
 
-    return d;
+    // Use 1024.0 for floating point division
+    const double to_gib = 1024.0 * 1024.0 * 1024.0;
+    d->total_memory_gb = (double)disk_info.f_blocks * disk_info.f_frsize / to_gib;
+    d->used_memory_gb = (double)(disk_info.f_blocks - disk_info.f_bfree) * disk_info.f_frsize / to_gib;
+
+    return BLING_OK;
 }
 
 static int _read_first_frequency_khz(const char *path_khz) {
-    FILE *file = fopen(path_khz, "r");
-    if (file == NULL) {
-        return 0;
-    }
-
     char line[64];
-    if (fgets(line, sizeof(line), file) == NULL) {
-        fclose(file);
+    if (read_file(path_khz, line, sizeof(line)) <= 0) {
         return 0;
     }
-    fclose(file);
 
     char *end_ptr = NULL;
     long value_khz = strtol(line, &end_ptr, 10);
@@ -181,15 +202,16 @@ static int _read_max_frequency_khz_for_cores(int cores, const char *path_fmt) {
     return max_khz;
 }
 
-struct cpu get_cpu() {
+int get_cpu(struct cpu *cpu) {
+    cpu->name = NULL;
+    cpu->cores = 0;
+    cpu->base_frequency = 0;
+
     int num_lines = 0;
     char **fileLines = lines("/proc/cpuinfo", &num_lines);
-
-    struct cpu cpu = {
-        .name = NULL,
-        .cores = 0,
-        .base_frequency = 0,
-    };
+    if (fileLines == NULL) {
+        return errno_status(errno);
+    }
 
     double cpuinfo_mhz_sum = 0.0;
     int cpuinfo_mhz_count = 0;
@@ -197,12 +219,12 @@ struct cpu get_cpu() {
     int first_iter = 1;
     for (int i = 0; i < num_lines; i++) {
         if (strncmp(fileLines[i], "model name", 10) == 0) {
-            cpu.cores++;
+            cpu->cores++;
 
             if (first_iter) {
                 char *colon = strchr(fileLines[i], ':');
                 if (colon) {
-                    cpu.name = strdup(colon + 2);
+                    cpu->name = strdup(colon + 2);
                 }
                 first_iter = 0;
             }
@@ -224,63 +246,77 @@ struct cpu get_cpu() {
     free_string_array(fileLines);
 
     int cpu_max_frequency =
-            _read_max_frequency_khz_for_cores(cpu.cores, "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq");
+            _read_max_frequency_khz_for_cores(cpu->cores, "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq");
     int cpu_base_frequency =
-            _read_max_frequency_khz_for_cores(cpu.cores, "/sys/devices/system/cpu/cpu%d/cpufreq/base_frequency");
+            _read_max_frequency_khz_for_cores(cpu->cores, "/sys/devices/system/cpu/cpu%d/cpufreq/base_frequency");
 
     if (cpu_max_frequency > 0) {
-        cpu.base_frequency = cpu_max_frequency;
+        cpu->base_frequency = cpu_max_frequency;
     } else if (cpu_base_frequency > 0) {
-        cpu.base_frequency = cpu_base_frequency;
+        cpu->base_frequency = cpu_base_frequency;
     }
 
-    if (cpu.base_frequency == 0) {
+    if (cpu->base_frequency == 0) {
         if (cpuinfo_mhz_count > 0) {
-            cpu.base_frequency = (int)((cpuinfo_mhz_sum / cpuinfo_mhz_count) * 1000);
+            cpu->base_frequency = (int)((cpuinfo_mhz_sum / cpuinfo_mhz_count) * 1000);
         }
     }
 
-    return cpu;
+    return cpu->cores > 0 ? BLING_OK : BLING_ERR_PARSE;
 }
 
-char *get_hostname() {
+int get_hostname(char **out) {
     int num_lines = 0;
     char **fileLines = lines("/etc/hostname", &num_lines);
+    if (fileLines == NULL) {
+        return errno_status(errno);
+    }
 
-    char *hostname = NULL;
+    int status = BLING_ERR_PARSE;
 
-    if (fileLines != NULL && num_lines > 0) {
-        hostname = strdup(fileLines[0]);
-    } else {
-        hostname = strdup("unknown");
+    if (num_lines > 0) {
+        char *hostname = strdup(fileLines[0]);
+        if (hostname != NULL) {
+            *out = hostname;
+            status = BLING_OK;
+        } else {
+            status = BLING_ERR_NOMEM;
+        }
     }
 
     free_string_array(fileLines);
 
-    return hostname;
+    return status;
 }
 
-char *get_kernel() {
+int get_kernel(char **out) {
     int num_lines = 0;
     char **fileLines = lines("/proc/version", &num_lines);
+    if (fileLines == NULL) {
+        return errno_status(errno);
+    }
 
-    char *kernel = NULL;
+    int status = BLING_ERR_PARSE;
 
-    if (fileLines != NULL && num_lines > 0) {
+    if (num_lines > 0) {
         char **kernel_parts = split(fileLines[0], " ");
 
-        if (kernel_parts != NULL && kernel_parts[0] != NULL && kernel_parts[1] != NULL && kernel_parts[2] != NULL) {
-            kernel = strdup(kernel_parts[2]);
-        } else {
-            kernel = strdup("unknown");
+        if (kernel_parts == NULL) {
+            status = BLING_ERR_NOMEM;
+        } else if (kernel_parts[0] != NULL && kernel_parts[1] != NULL && kernel_parts[2] != NULL) {
+            char *kernel = strdup(kernel_parts[2]);
+            if (kernel != NULL) {
+                *out = kernel;
+                status = BLING_OK;
+            } else {
+                status = BLING_ERR_NOMEM;
+            }
         }
 
         free_string_array(kernel_parts);
-    } else {
-        kernel = strdup("unknown");
     }
 
     free_string_array(fileLines);
 
-    return kernel;
+    return status;
 }
@@ -5,6 +5,11 @@
 
 #include <stddef.h>
 
+/*
+ * Collectors. Each one fills the struct it is given and returns an
+ * enum bling_status code (see bling.h); none of them print.
+ */
+
 struct os {
     char *name;
     char *version;
@@ -17,7 +22,7 @@ struct os {
  * NOTE: This function now uses strdup to safely copy strings.
  * The caller is responsible for freeing os.name, os.version, and os.build_id.
  */
-struct os get_os();
+int get_os(struct os *os);
 
 struct mem {
     double max_memory;
@@ -29,16 +34,22 @@ struct mem {
  *
  * This version is more robust and doesn't modify the input lines.
  */
-struct mem get_meminfo();
+int get_meminfo(struct mem *mem);
 
 struct uptime {
     size_t seconds;
     size_t minutes;
     size_t hours;
     size_t days;
+    unsigned long long total_seconds;
 };
 
-struct uptime get_uptime();
+int get_uptime(struct uptime *up);
+
+/**
+ * @brief Fractional seconds since boot with one small read, for samplers averaging since boot. 0 on failure.
+ */
+double uptime_seconds(void);
 
 struct disk {
     double total_memory_gb;
@@ -50,7 +61,7 @@ struct disk {
  *
  * Corrected to use double for GiB calculations.
  */
-struct disk get_diskinfo();
+int get_diskinfo(struct disk *disk);
 
 struct cpu {
     char *name;
@@ -58,9 +69,13 @@ struct cpu {
     int base_frequency; // kHz (max frequency)
 };
 
-struct cpu get_cpu();
+int get_cpu(struct cpu *cpu);
 
-char *get_hostname();
-char *get_kernel();
+/**
+ * @brief Hostname and kernel release. *out is heap-allocated on success and
+ * left untouched on failure.
+ */
+int get_hostname(char **out);
+int get_kernel(char **out);
 
 #endif // SYSTEM_H
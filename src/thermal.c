@@ -0,0 +1,407 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "thermal.h"
+#include "bling.h"
+#include "file.h"
+#include "system.h"
+#include "topology.h"
+#include "util.h"
+#include "worker.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SYSFS_THERMAL "/sys/class/thermal"
+#define SYSFS_HWMON "/sys/class/hwmon"
+#define SYSFS_POWERCAP "/sys/class/powercap"
+#define SYSFS_CPU "/sys/devices/system/cpu"
+#define MAX_TRIP_POINTS 16
+
+static int open_attr(const char *path) {
+    return file_open(path, O_RDONLY | O_CLOEXEC);
+}
+
+/**
+ * @brief Reads a one-line attribute into buf without the newline; "" on failure.
+ */
+static void read_attr(const char *path, char *buf, size_t size) {
+    if (read_file(path, buf, size) <= 0) {
+        buf[0] = '\0';
+    }
+    buf[strcspn(buf, "\n")] = '\0';
+}
+
+static int read_fd_ll(int fd, long long *out) {
+    char buf[32];
+    if (pread_file(fd, buf, sizeof(buf)) <= 0) {
+        return 0;
+    }
+    char *end;
+    *out = strtoll(buf, &end, 10);
+    return end != buf;
+}
+
+static double read_millicelsius(const char *path) {
+    char buf[32];
+    read_attr(path, buf, sizeof(buf));
+    return buf[0] != '\0' ? strtoll(buf, NULL, 10) / 1000.0 : 0.0;
+}
+
+static struct thermal_sensor *add_sensor(struct thermal *t, const char *temp_path) {
+    if (t->sensor_count == THERMAL_MAX_SENSORS) {
+        return NULL;
+    }
+    int fd = open_attr(temp_path);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct thermal_sensor *s = &t->sensors[t->sensor_count++];
+    memset(s, 0, sizeof(*s));
+    s->fd = fd;
+    return s;
+}
+
+static void discover_zones(struct thermal *t) {
+    DIR *dir = file_opendir(SYSFS_THERMAL);
+    if (dir == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+    char path[160];
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), SYSFS_THERMAL "/%.32s/temp", entry->d_name);
+        struct thermal_sensor *s = add_sensor(t, path);
+        if (s == NULL) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), SYSFS_THERMAL "/%.32s/type", entry->d_name);
+        read_attr(path, s->name, sizeof(s->name));
+
+        // The critical trip point, where the kernel shuts the machine down
+        for (int trip = 0; trip < MAX_TRIP_POINTS; trip++) {
+            char type[32];
+            snprintf(path, sizeof(path), SYSFS_THERMAL "/%.32s/trip_point_%d_type", entry->d_name, trip);
+            read_attr(path, type, sizeof(type));
+            if (type[0] == '\0') {
+                break;
+            }
+            if (strcmp(type, "critical") == 0) {
+                snprintf(path, sizeof(path), SYSFS_THERMAL "/%.32s/trip_point_%d_temp", entry->d_name, trip);
+                s->crit_celsius = read_millicelsius(path);
+                break;
+            }
+        }
+    }
+    closedir(dir);
+}
+
+static void discover_hwmon_device(struct thermal *t, const char *device) {
+    char path[192];
+    char chip[24];
+    snprintf(path, sizeof(path), SYSFS_HWMON "/%s/name", device);
+    read_attr(path, chip, sizeof(chip));
+
+    snprintf(path, sizeof(path), SYSFS_HWMON "/%s", device);
+    DIR *dir = file_opendir(path);
+    if (dir == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        // "temp3_input"
+        int index;
+        char suffix[8];
+        if (sscanf(entry->d_name, "temp%d_%7s", &index, suffix) != 2 || strcmp(suffix, "input") != 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), SYSFS_HWMON "/%s/%.32s", device, entry->d_name);
+        struct thermal_sensor *s = add_sensor(t, path);
+        if (s == NULL) {
+            continue;
+        }
+
+        char label[32];
+        snprintf(path, sizeof(path), SYSFS_HWMON "/%s/temp%d_label", device, index);
+        read_attr(path, label, sizeof(label));
+        if (label[0] != '\0') {
+            snprintf(s->name, sizeof(s->name), "%.23s %.23s", chip, label);
+        } else {
+            snprintf(s->name, sizeof(s->name), "%s temp%d", chip, index);
+        }
+
+        snprintf(path, sizeof(path), SYSFS_HWMON "/%s/temp%d_crit", device, index);
+        s->crit_celsius = read_millicelsius(path);
+    }
+    closedir(dir);
+}
+
+static void discover_hwmon(struct thermal *t) {
+    DIR *dir = file_opendir(SYSFS_HWMON);
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "hwmon", 5) == 0 && strlen(entry->d_name) < 32) {
+            discover_hwmon_device(t, entry->d_name);
+        }
+    }
+    closedir(dir);
+}
+
+static int append_fd(int **fds, int *count, int fd) {
+    int *grown = realloc(*fds, (size_t)(*count + 1) * sizeof(**fds));
+    if (grown == NULL) {
+        close(fd);
+        return BLING_ERR_NOMEM;
+    }
+    *fds = grown;
+    (*fds)[(*count)++] = fd;
+    return BLING_OK;
+}
+
+/**
+ * @brief Opens core_throttle_count once per physical core and package_throttle_count once per package.
+ */
+static int discover_throttle(struct thermal *t) {
+    char buf[1024];
+    struct cpuset *online = malloc(sizeof(*online));
+    if (online == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+    if (read_file(SYSFS_CPU "/online", buf, sizeof(buf)) <= 0 || cpuset_parse_list(online, buf) != BLING_OK) {
+        free(online);
+        return BLING_OK;
+    }
+
+    // (package, core) pairs already covered; packages are the entries with core == -1
+    unsigned long long *seen = NULL;
+    size_t seen_count = 0;
+    int status = BLING_OK;
+
+    char path[128];
+    for (int cpu = cpuset_next(online, 0); cpu >= 0 && status == BLING_OK; cpu = cpuset_next(online, cpu + 1)) {
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+        read_attr(path, buf, sizeof(buf));
+        unsigned long long package = (unsigned long long)strtoll(buf, NULL, 10);
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/core_id", cpu);
+        read_attr(path, buf, sizeof(buf));
+        unsigned long long core = (unsigned long long)strtoll(buf, NULL, 10);
+
+        unsigned long long keys[2] = { package << 32 | (core & 0xffffffff), package << 32 | 0xffffffff };
+        const char *attrs[2] = { "core_throttle_count", "package_throttle_count" };
+        for (int k = 0; k < 2 && status == BLING_OK; k++) {
+            size_t i = 0;
+            while (i < seen_count && seen[i] != keys[k]) {
+                i++;
+            }
+            if (i < seen_count) {
+                continue;
+            }
+
+            snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/thermal_throttle/%s", cpu, attrs[k]);
+            int fd = open_attr(path);
+            if (fd < 0) {
+                continue; // No thermal_throttle on this CPU (not Intel, or a VM)
+            }
+            unsigned long long *grown = realloc(seen, (seen_count + 1) * sizeof(*seen));
+            if (grown == NULL) {
+                close(fd);
+                status = BLING_ERR_NOMEM;
+                break;
+            }
+            seen = grown;
+            seen[seen_count++] = keys[k];
+            status = k == 0 ? append_fd(&t->core_fds, &t->core_count, fd)
+                            : append_fd(&t->package_fds, &t->package_count, fd);
+        }
+    }
+
+    free(seen);
+    free(online);
+    return status;
+}
+
+static void discover_rapl(struct thermal *t) {
+    DIR *dir = file_opendir(SYSFS_POWERCAP);
+    if (dir == NULL) {
+        return;
+    }
+
+    struct dirent *entry;
+    char path[160];
+    while ((entry = readdir(dir)) != NULL && t->rapl_count < THERMAL_MAX_RAPL) {
+        // "intel-rapl:0" is a package, "intel-rapl:0:1" a subzone (core, uncore, dram) of it.
+        // "intel-rapl" is the control type, and intel-rapl-mmio repeats the package domains.
+        if (strncmp(entry->d_name, "intel-rapl:", 11) != 0 || strlen(entry->d_name) > 24) {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), SYSFS_POWERCAP "/%.24s/energy_uj", entry->d_name);
+        int fd = open_attr(path);
+        if (fd < 0) {
+            t->rapl_denied |= errno == EACCES;
+            continue;
+        }
+
+        struct rapl_domain *d = &t->rapl[t->rapl_count++];
+        memset(d, 0, sizeof(*d));
+        d->fd = fd;
+
+        char name[24];
+        snprintf(path, sizeof(path), SYSFS_POWERCAP "/%.24s/name", entry->d_name);
+        read_attr(path, name, sizeof(name));
+        const char *sub = strchr(entry->d_name + 11, ':');
+        if (sub != NULL) {
+            char parent[24];
+            snprintf(path, sizeof(path), SYSFS_POWERCAP "/%.*s/name", (int)(sub - entry->d_name), entry->d_name);
+            read_attr(path, parent, sizeof(parent));
+            snprintf(d->name, sizeof(d->name), "%.15s/%.15s", parent, name);
+        } else {
+            snprintf(d->name, sizeof(d->name), "%s", name);
+        }
+
+        snprintf(path, sizeof(path), SYSFS_POWERCAP "/%.24s/max_energy_range_uj", entry->d_name);
+        char max[32];
+        read_attr(path, max, sizeof(max));
+        d->max_energy_uj = strtoull(max, NULL, 10);
+    }
+    closedir(dir);
+}
+
+static int compare_sensors(const void *a, const void *b) {
+    return strcmp(((const struct thermal_sensor *)a)->name, ((const struct thermal_sensor *)b)->name);
+}
+
+static int compare_rapl(const void *a, const void *b) {
+    return strcmp(((const struct rapl_domain *)a)->name, ((const struct rapl_domain *)b)->name);
+}
+
+int thermal_init(struct thermal *t) {
+    memset(t, 0, sizeof(*t));
+
+    discover_zones(t);
+    discover_hwmon(t);
+    discover_rapl(t);
+    int status = discover_throttle(t);
+    if (status != BLING_OK) {
+        thermal_free(t);
+        return status;
+    }
+
+    qsort(t->sensors, (size_t)t->sensor_count, sizeof(t->sensors[0]), compare_sensors);
+    qsort(t->rapl, (size_t)t->rapl_count, sizeof(t->rapl[0]), compare_rapl);
+
+    if (t->sensor_count + t->rapl_count + t->core_count + t->package_count == 0 && !t->rapl_denied) {
+        thermal_free(t);
+        return BLING_ERR_NOTFOUND;
+    }
+    return BLING_OK;
+}
+
+/**
+ * @brief Energy consumed between two readings; energy_uj counts up to max_energy_range_uj and wraps to 0.
+ */
+static unsigned long long energy_delta(unsigned long long cur, unsigned long long prev, unsigned long long max) {
+    if (cur >= prev) {
+        return cur - prev;
+    }
+    return max >= prev ? max - prev + cur : 0;
+}
+
+static unsigned long long sum_counters(const int *fds, int count) {
+    unsigned long long sum = 0;
+    for (int i = 0; i < count; i++) {
+        long long value;
+        if (read_fd_ll(fds[i], &value) && value > 0) {
+            sum += (unsigned long long)value;
+        }
+    }
+    return sum;
+}
+
+int thermal_sample(struct thermal *t) {
+    long long now = worker_now_ms();
+    double seconds = t->samples > 0 ? (double)(now - t->sample_ms) / 1000.0 : uptime_seconds();
+
+    for (int i = 0; i < t->sensor_count; i++) {
+        struct thermal_sensor *s = &t->sensors[i];
+        long long millicelsius;
+        s->valid = read_fd_ll(s->fd, &millicelsius);
+        s->celsius = s->valid ? millicelsius / 1000.0 : 0.0;
+    }
+
+    t->prev_core_throttles = t->core_throttles;
+    t->prev_package_throttles = t->package_throttles;
+    t->core_throttles = sum_counters(t->core_fds, t->core_count);
+    t->package_throttles = sum_counters(t->package_fds, t->package_count);
+    if (seconds > 0.0) {
+        unsigned long long core = t->core_throttles >= t->prev_core_throttles
+                                          ? t->core_throttles - t->prev_core_throttles
+                                          : 0;
+        unsigned long long package = t->package_throttles >= t->prev_package_throttles
+                                             ? t->package_throttles - t->prev_package_throttles
+                                             : 0;
+        t->core_throttle_rate = (double)core / seconds;
+        t->package_throttle_rate = (double)package / seconds;
+    }
+
+    for (int i = 0; i < t->rapl_count; i++) {
+        struct rapl_domain *d = &t->rapl[i];
+        long long energy;
+        if (!read_fd_ll(d->fd, &energy)) {
+            continue;
+        }
+        d->prev_uj = d->energy_uj;
+        d->energy_uj = (unsigned long long)energy;
+        // The counter's origin is arbitrary, so there is no average since boot
+        if (t->samples > 0 && seconds > 0.0) {
+            d->watts = (double)energy_delta(d->energy_uj, d->prev_uj, d->max_energy_uj) / 1e6 / seconds;
+        }
+    }
+
+    t->sample_ms = now;
+    t->samples++;
+    return BLING_OK;
+}
+
+const struct thermal_sensor *thermal_hottest(const struct thermal *t) {
+    const struct thermal_sensor *hottest = NULL;
+    for (int i = 0; i < t->sensor_count; i++) {
+        if (t->sensors[i].valid && (hottest == NULL || t->sensors[i].celsius > hottest->celsius)) {
+            hottest = &t->sensors[i];
+        }
+    }
+    return hottest;
+}
+
+void thermal_free(struct thermal *t) {
+    for (int i = 0; i < t->sensor_count; i++) {
+        close(t->sensors[i].fd);
+    }
+    for (int i = 0; i < t->rapl_count; i++) {
+        close(t->rapl[i].fd);
+    }
+    for (int i = 0; i < t->core_count; i++) {
+        close(t->core_fds[i]);
+    }
+    for (int i = 0; i < t->package_count; i++) {
+        close(t->package_fds[i]);
+    }
+    free(t->core_fds);
+    free(t->package_fds);
+    memset(t, 0, sizeof(*t));
+}
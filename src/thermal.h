@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef THERMAL_H
+#define THERMAL_H
+
+#include <stddef.h>
+
+#define THERMAL_MAX_SENSORS 128
+#define THERMAL_MAX_RAPL 16
+
+struct thermal_sensor {
+    char name[48]; // Thermal zone type ("x86_pkg_temp") or hwmon "<name> <label>" ("coretemp Package id 0")
+    int fd;        // temp or tempN_input, kept open
+    double celsius;
+    double crit_celsius; // 0 if the driver gives none
+    int valid;           // The last read succeeded
+};
+
+struct rapl_domain {
+    char name[32]; // "package-0", "package-0/dram"
+    int fd;        // energy_uj, kept open (root only since 5.10)
+    unsigned long long max_energy_uj; // max_energy_range_uj, where energy_uj wraps to 0
+    unsigned long long energy_uj;
+    unsigned long long prev_uj;
+    double watts; // Over the last interval, 0 until two samples
+};
+
+/**
+ * @brief Temperatures, thermal throttling and RAPL power.
+ *
+ * thermal_init() walks sysfs once and keeps an fd per attribute; thermal_sample() is then
+ * one pread per fd, with no path lookups or directory scans.
+ */
+struct thermal {
+    struct thermal_sensor sensors[THERMAL_MAX_SENSORS];
+    int sensor_count;
+
+    struct rapl_domain rapl[THERMAL_MAX_RAPL];
+    int rapl_count;
+    int rapl_denied; // Domains exist but energy_uj is not readable by this user
+
+    // thermal_throttle counters, one fd per physical core and one per package so SMT
+    // siblings and the cores of a package are not counted twice
+    int *core_fds;
+    int core_count;
+    int *package_fds;
+    int package_count;
+
+    unsigned long long core_throttles; // Since boot, summed over cores
+    unsigned long long package_throttles;
+    unsigned long long prev_core_throttles;
+    unsigned long long prev_package_throttles;
+    double core_throttle_rate; // Events per second; averages since boot on the first sample
+    double package_throttle_rate;
+
+    int samples;
+    long long sample_ms;
+};
+
+/**
+ * @brief Discovers sensors, throttle counters and RAPL domains, and opens them.
+ *
+ * @return BLING_OK, or BLING_ERR_NOTFOUND when the box exposes none of them.
+ */
+int thermal_init(struct thermal *t);
+
+int thermal_sample(struct thermal *t);
+
+/**
+ * @brief Hottest sensor with a valid reading, or NULL.
+ */
+const struct thermal_sensor *thermal_hottest(const struct thermal *t);
+
+void thermal_free(struct thermal *t);
+
+#endif // THERMAL_H
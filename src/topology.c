@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "topology.h"
+#include "bling.h"
+#include "file.h"
+#include "util.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SYSFS_CPU "/sys/devices/system/cpu"
+#define SYSFS_NODE "/sys/devices/system/node"
+
+// Room for a cpulist of every other CPU at MAX_CPUS ("0,2,4,...")
+#define CPULIST_BUFFER_SIZE (MAX_CPUS * 3)
+#define MAX_DIES 256
+
+static void cpuset_set_range(struct cpuset *set, int first, int last) {
+    while (first <= last) {
+        if (first % 64 == 0 && last - first >= 63) {
+            set->bits[first / 64] = ~0ull; // Whole word at once
+            first += 64;
+        } else {
+            cpuset_set(set, first++);
+        }
+    }
+}
+
+int cpuset_parse_list(struct cpuset *set, const char *s) {
+    memset(set, 0, sizeof(*set));
+
+    const char *p = s;
+    while (*p != '\0' && *p != '\n') {
+        if (*p < '0' || *p > '9') {
+            return BLING_ERR_PARSE;
+        }
+
+        unsigned long long first = scan_ull(&p);
+        unsigned long long last = first;
+        if (*p == '-') {
+            p++;
+            last = scan_ull(&p);
+        }
+        if (first > last || last >= MAX_CPUS) {
+            return BLING_ERR_PARSE;
+        }
+        cpuset_set_range(set, (int)first, (int)last);
+
+        if (*p == ',') {
+            p++;
+        }
+    }
+
+    return BLING_OK;
+}
+
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+int cpuset_parse_mask(struct cpuset *set, const char *s) {
+    memset(set, 0, sizeof(*set));
+
+    size_t len = strcspn(s, "\n");
+    int bit = 0;
+
+    // Walk from the least significant (rightmost) digit, 4 bits per digit, commas separate 32-bit words
+    for (size_t i = len; i-- > 0;) {
+        if (s[i] == ',') {
+            continue;
+        }
+
+        int v = hex_value(s[i]);
+        if (v < 0) {
+            return BLING_ERR_PARSE;
+        }
+        if (v != 0 && bit >= MAX_CPUS) {
+            return BLING_ERR_PARSE;
+        }
+        if (v != 0) {
+            set->bits[bit / 64] |= (uint64_t)v << (bit % 64);
+        }
+        bit += 4;
+    }
+
+    return BLING_OK;
+}
+
+int cpuset_count(const struct cpuset *set) {
+    int n = 0;
+    for (size_t i = 0; i < MAX_CPUS / 64; i++) {
+        n += __builtin_popcountll(set->bits[i]);
+    }
+    return n;
+}
+
+int cpuset_next(const struct cpuset *set, int start) {
+    if (start < 0 || start >= MAX_CPUS) {
+        return -1;
+    }
+
+    size_t word = (size_t)start / 64;
+    uint64_t bits = set->bits[word] & (~0ull << (start % 64));
+
+    for (;;) {
+        if (bits != 0) {
+            return (int)(word * 64) + __builtin_ctzll(bits);
+        }
+        if (++word == MAX_CPUS / 64) {
+            return -1;
+        }
+        bits = set->bits[word];
+    }
+}
+
+static void cpuset_or(struct cpuset *dst, const struct cpuset *src) {
+    for (size_t i = 0; i < MAX_CPUS / 64; i++) {
+        dst->bits[i] |= src->bits[i];
+    }
+}
+
+/**
+ * @brief Reads a sysfs cpulist file into set. Returns BLING_OK or an error code.
+ */
+static int read_cpulist(const char *path, struct cpuset *set) {
+    char buf[CPULIST_BUFFER_SIZE];
+    if (read_file(path, buf, sizeof(buf)) < 0) {
+        return errno_status(errno);
+    }
+    return cpuset_parse_list(set, buf);
+}
+
+/**
+ * @brief Reads a sysfs file holding a single integer, or returns fallback.
+ */
+static long long read_int(const char *path, long long fallback) {
+    char buf[32];
+    if (read_file(path, buf, sizeof(buf)) <= 0) {
+        return fallback;
+    }
+
+    const char *p = buf;
+    int negative = *p == '-';
+    if (negative) {
+        p++;
+    }
+    if (*p < '0' || *p > '9') {
+        return fallback;
+    }
+
+    long long value = (long long)scan_ull(&p);
+    return negative ? -value : value;
+}
+
+static void read_cores(struct topology *topo) {
+    struct cpuset covered = { 0 };
+    struct cpuset packages = { 0 };
+    struct cpuset siblings;
+    long long dies[MAX_DIES]; // package << 32 | die
+    int die_count = 0;
+    char path[128];
+
+    for (int cpu = cpuset_next(&topo->online, 0); cpu >= 0; cpu = cpuset_next(&topo->online, cpu + 1)) {
+        if (cpuset_test(&covered, cpu)) {
+            continue; // SMT sibling of a core we already counted
+        }
+
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/core_cpus_list", cpu);
+        if (read_cpulist(path, &siblings) != BLING_OK) {
+            // Kernels before 5.7 only have the older name
+            snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/thread_siblings_list", cpu);
+            if (read_cpulist(path, &siblings) != BLING_OK) {
+                memset(&siblings, 0, sizeof(siblings));
+            }
+        }
+        cpuset_set(&siblings, cpu);
+        cpuset_or(&covered, &siblings);
+
+        topo->cores++;
+        int threads = cpuset_count(&siblings);
+        if (threads > topo->max_threads_per_core) {
+            topo->max_threads_per_core = threads;
+        }
+
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/physical_package_id", cpu);
+        long long package = read_int(path, 0);
+        if (package >= 0 && package < MAX_CPUS) {
+            cpuset_set(&packages, (int)package);
+        }
+
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/topology/die_id", cpu);
+        long long die = (package << 32) | (read_int(path, 0) & 0xffffffff);
+
+        int known = 0;
+        for (int i = 0; i < die_count && !known; i++) {
+            known = dies[i] == die;
+        }
+        if (!known && die_count < MAX_DIES) {
+            dies[die_count++] = die;
+        }
+    }
+
+    topo->sockets = cpuset_count(&packages);
+    topo->dies = die_count;
+}
+
+static char cache_type(const char *type) {
+    switch (type[0]) {
+    case 'D':
+        return 'D';
+    case 'I':
+        return 'I';
+    default:
+        return 'U';
+    }
+}
+
+/**
+ * @brief Parses a sysfs cache size such as "48K" or "2048K" into KiB.
+ */
+static unsigned long long parse_cache_size_kb(const char *s) {
+    const char *p = s;
+    unsigned long long size = scan_ull(&p);
+    switch (*p) {
+    case 'M':
+        return size * 1024;
+    case 'G':
+        return size * 1024 * 1024;
+    case 'K':
+        return size;
+    default:
+        return size / 1024;
+    }
+}
+
+static void read_caches(struct topology *topo) {
+    int first = cpuset_next(&topo->online, 0);
+    struct cpuset covered;
+    struct cpuset shared;
+    char path[128];
+    char buf[64];
+
+    for (int index = 0; index < MAX_CACHES && first >= 0; index++) {
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/level", first, index);
+        long long level = read_int(path, -1);
+        if (level < 0) {
+            break;
+        }
+
+        struct cache_info *cache = &topo->caches[topo->cache_count++];
+        cache->level = (int)level;
+
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/type", first, index);
+        cache->type = read_file(path, buf, sizeof(buf)) > 0 ? cache_type(buf) : 'U';
+
+        snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/size", first, index);
+        cache->size_kb = read_file(path, buf, sizeof(buf)) > 0 ? parse_cache_size_kb(buf) : 0;
+
+        // One shared_cpu_list read per cache instance, not per CPU
+        memset(&covered, 0, sizeof(covered));
+        for (int cpu = first; cpu >= 0; cpu = cpuset_next(&topo->online, cpu + 1)) {
+            if (cpuset_test(&covered, cpu)) {
+                continue;
+            }
+
+            snprintf(path, sizeof(path), SYSFS_CPU "/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+            if (read_cpulist(path, &shared) != BLING_OK) {
+                memset(&shared, 0, sizeof(shared));
+            }
+            cpuset_set(&shared, cpu);
+            cpuset_or(&covered, &shared);
+            cache->instances++;
+        }
+    }
+}
+
+static void read_nodes(struct topology *topo) {
+    struct cpuset node_ids; // Node numbers, not CPUs, but the list format is the same
+    struct cpuset cpus;
+    char path[128];
+    char buf[4096];
+
+    if (read_cpulist(SYSFS_NODE "/online", &node_ids) != BLING_OK) {
+        return; // Kernel without NUMA support
+    }
+
+    for (int id = cpuset_next(&node_ids, 0); id >= 0 && topo->node_count < MAX_NUMA_NODES;
+         id = cpuset_next(&node_ids, id + 1)) {
+        struct numa_node *node = &topo->nodes[topo->node_count++];
+        node->id = id;
+
+        snprintf(path, sizeof(path), SYSFS_NODE "/node%d/cpulist", id);
+        node->cpus = read_cpulist(path, &cpus) == BLING_OK ? cpuset_count(&cpus) : 0;
+
+        // "Node 0 MemTotal:        4292344 kB"
+        snprintf(path, sizeof(path), SYSFS_NODE "/node%d/meminfo", id);
+        if (read_file(path, buf, sizeof(buf)) > 0) {
+            const char *p = strstr(buf, "MemTotal:");
+            if (p != NULL) {
+                p += 9;
+                node->mem_total_kb = scan_ull(&p);
+            }
+            p = strstr(buf, "MemFree:");
+            if (p != NULL) {
+                p += 8;
+                node->mem_free_kb = scan_ull(&p);
+            }
+        }
+    }
+}
+
+int get_topology(struct topology *topo) {
+    memset(topo, 0, sizeof(*topo));
+
+    int status = read_cpulist(SYSFS_CPU "/online", &topo->online);
+    if (status != BLING_OK) {
+        return status;
+    }
+    topo->cpus = cpuset_count(&topo->online);
+
+    read_cores(topo);
+    read_caches(topo);
+    read_nodes(topo);
+
+    if (topo->sockets == 0 && topo->cores > 0) {
+        topo->sockets = 1;
+    }
+
+    return BLING_OK;
+}
+
+void topology_summary(const struct topology *topo, char *buf, size_t size) {
+    int n = snprintf(buf, size, "%dS/%dC/%dT", topo->sockets, topo->cores, topo->cpus);
+    if (n > 0 && (size_t)n < size && topo->node_count > 1) {
+        snprintf(buf + n, size - n, ", %d nodes", topo->node_count);
+    }
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_CPUS 4096
+#define MAX_NUMA_NODES 1024
+#define MAX_CACHES 8
+
+/**
+ * @brief A set of CPU numbers as a fixed-size bitset, 512 bytes at MAX_CPUS.
+ */
+struct cpuset {
+    uint64_t bits[MAX_CPUS / 64];
+};
+
+static inline void cpuset_set(struct cpuset *set, int cpu) {
+    set->bits[cpu / 64] |= 1ull << (cpu % 64);
+}
+
+static inline int cpuset_test(const struct cpuset *set, int cpu) {
+    return (set->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+/**
+ * @brief Parses a kernel cpulist ("0-3,8-11,16") into set, replacing its contents.
+ *
+ * @return BLING_OK, or BLING_ERR_PARSE on malformed input or CPUs >= MAX_CPUS.
+ */
+int cpuset_parse_list(struct cpuset *set, const char *s);
+
+/**
+ * @brief Parses a kernel cpumask ("ff,ffffffff", most significant word first) into set.
+ */
+int cpuset_parse_mask(struct cpuset *set, const char *s);
+
+int cpuset_count(const struct cpuset *set);
+
+/**
+ * @brief Lowest CPU number at or after start, or -1.
+ */
+int cpuset_next(const struct cpuset *set, int start);
+
+struct cache_info {
+    int level;
+    char type;                    // 'D'ata, 'I'nstruction or 'U'nified
+    unsigned long long size_kb;   // Per instance
+    int instances;                // How many separate caches of this kind exist
+};
+
+struct numa_node {
+    int id;
+    int cpus;
+    unsigned long long mem_total_kb;
+    unsigned long long mem_free_kb;
+};
+
+/**
+ * @brief CPU topology from sysfs. Fixed-size, so a single allocation at any CPU count.
+ */
+struct topology {
+    int cpus;    // Online logical CPUs
+    int sockets; // Physical packages
+    int dies;
+    int cores; // Physical cores
+    int max_threads_per_core;
+
+    struct cpuset online;
+
+    struct cache_info caches[MAX_CACHES];
+    int cache_count;
+
+    struct numa_node nodes[MAX_NUMA_NODES];
+    int node_count;
+};
+
+/**
+ * @brief Reads /sys/devices/system/cpu/{online,cpu*\/topology,cpu*\/cache} and /sys/devices/system/node.
+ *
+ * Files are read once per core, cache instance and node rather than once per CPU:
+ * every sibling listed by a core or cache is marked covered and skipped.
+ *
+ * @return BLING_OK, or an error code if not even the online CPU list could be read.
+ */
+int get_topology(struct topology *topo);
+
+/**
+ * @brief Compact summary like "2S/64C/128T, 2 nodes" (NUMA part only when there is more than one node).
+ */
+void topology_summary(const struct topology *topo, char *buf, size_t size);
+
+#endif // TOPOLOGY_H
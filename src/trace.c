@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _GNU_SOURCE // syscall()
+
+#include "trace.h"
+#include "bling.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+struct trace_rec {
+    uint64_t ts_ns;
+    const char *name;
+    int tid; // Per event: a ring outlives its thread and is handed to the next one
+    char phase;
+    char arg[TRACE_ARG_SIZE];
+};
+
+/*
+ * Single writer (the owning thread), any number of readers. head counts every event ever
+ * written; event i lives in slot i % size and is complete once head > i.
+ */
+struct trace_ring {
+    struct trace_ring *next;
+    int in_use;
+    uint64_t head;
+    size_t size;
+    struct trace_rec recs[];
+};
+
+int trace_on;
+
+static size_t ring_size;
+static struct trace_ring *rings; // Push-only list, rings are never freed
+static pthread_key_t ring_key;
+static __thread struct trace_ring *my_ring;
+static __thread int my_tid;
+
+static void ring_release(void *arg) {
+    struct trace_ring *ring = arg;
+    __atomic_store_n(&ring->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static struct trace_ring *ring_claim(void) {
+    struct trace_ring *r;
+    for (r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&r->in_use, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            break;
+        }
+    }
+
+    if (r == NULL) {
+        r = malloc(sizeof(*r) + ring_size * sizeof(r->recs[0]));
+        if (r == NULL) {
+            return NULL;
+        }
+        r->in_use = 1;
+        r->head = 0;
+        r->size = ring_size;
+        r->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&rings, &r->next, r, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        }
+    }
+
+    // The destructor hands the ring back when a worker thread exits
+    pthread_setspecific(ring_key, r);
+    my_tid = (int)syscall(SYS_gettid);
+    return r;
+}
+
+int trace_enable(size_t events_per_thread) {
+    if (events_per_thread == 0) {
+        return BLING_ERR_INVAL;
+    }
+    if (trace_on) {
+        return BLING_OK;
+    }
+    if (pthread_key_create(&ring_key, ring_release) != 0) {
+        return BLING_ERR_NOMEM;
+    }
+    ring_size = events_per_thread;
+    trace_on = 1;
+    return BLING_OK;
+}
+
+void trace_event(char phase, const char *name, const char *arg) {
+    struct trace_ring *ring = my_ring;
+    if (ring == NULL) {
+        ring = my_ring = ring_claim();
+        if (ring == NULL) {
+            return;
+        }
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    // The last event's head store must be visible before any write to the slot it now overwrites
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    struct trace_rec *rec = &ring->recs[head % ring->size];
+    rec->ts_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    rec->name = name;
+    rec->tid = my_tid;
+    rec->phase = phase;
+    rec->arg[0] = '\0';
+    if (arg != NULL) {
+        size_t len = strlen(arg);
+        if (len >= sizeof(rec->arg)) { // The end of a path says more than its start
+            arg += len - (sizeof(rec->arg) - 1);
+            len = sizeof(rec->arg) - 1;
+        }
+        memcpy(rec->arg, arg, len + 1);
+    }
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void put_escaped(FILE *f, const char *s) {
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fprintf(f, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+}
+
+/**
+ * @brief Copies the events still in ring into out (ring->size entries), oldest first.
+ *
+ * The owner keeps writing meanwhile, so the copy is checked against head afterwards and
+ * entries that may have been overwritten during it are dropped.
+ *
+ * @return Number of events copied.
+ */
+static size_t ring_copy(struct trace_ring *ring, struct trace_rec *out) {
+    uint64_t end = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t start = end > ring->size ? end - ring->size : 0;
+    for (uint64_t i = start; i < end; i++) {
+        out[i - start] = ring->recs[i % ring->size];
+    }
+
+    // Slot head % size may be half written by now, so it and everything older are suspect.
+    // The fence keeps the slot reads above from moving past this second load of head.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    uint64_t after = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    uint64_t valid = after + 1 > ring->size ? after + 1 - ring->size : 0;
+    if (valid <= start) {
+        return (size_t)(end - start);
+    }
+    if (valid >= end) {
+        return 0;
+    }
+    memmove(out, out + (valid - start), (size_t)(end - valid) * sizeof(*out));
+    return (size_t)(end - valid);
+}
+
+int trace_write(const char *path) {
+    if (!trace_on) {
+        return BLING_ERR_INVAL;
+    }
+
+    struct trace_rec *buf = malloc(ring_size * sizeof(*buf));
+    if (buf == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        free(buf);
+        return BLING_ERR_IO;
+    }
+
+    int pid = (int)getpid();
+    const char *sep = "";
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+    for (struct trace_ring *r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+        size_t count = ring_copy(r, buf);
+        for (size_t i = 0; i < count; i++) {
+            const struct trace_rec *e = &buf[i];
+            fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"bling\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":%d,\"tid\":%d", sep,
+                    e->name, e->phase, (unsigned long long)(e->ts_ns / 1000), (unsigned)(e->ts_ns % 1000), pid, e->tid);
+            if (e->arg[0] != '\0') {
+                fputs(",\"args\":{\"detail\":\"", f);
+                put_escaped(f, e->arg);
+                fputs("\"}", f);
+            }
+            fputc('}', f);
+            sep = ",";
+        }
+    }
+    fputs("\n]}\n", f);
+    free(buf);
+
+    int failed = ferror(f);
+    if (fclose(f) != 0 || failed) {
+        return BLING_ERR_IO;
+    }
+    return BLING_OK;
+}
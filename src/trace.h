@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef TRACE_H
+#define TRACE_H
+
+/*
+ * Span recorder for long-running modes (--watch, --watch --json), exported as Chrome
+ * trace-event JSON that chrome://tracing and Perfetto load as a timeline.
+ *
+ * Every thread writes begin/end events into a ring of its own, so recording takes no
+ * lock and never waits for the writer of the trace file. A ring keeps the most recent
+ * events and overwrites the oldest. Rings are handed to the next thread when their
+ * thread exits, because collector workers are one-shot threads.
+ *
+ * Until trace_enable() is called, TRACE_BEGIN/TRACE_END cost one load and one branch
+ * marked unlikely; the arguments are not evaluated.
+ */
+
+#include <stddef.h>
+
+#define TRACE_DEFAULT_EVENTS 8192 // Per thread
+#define TRACE_ARG_SIZE 64         // Longer arguments (paths) keep their last characters
+
+extern int trace_on;
+
+#define TRACE_BEGIN(name, arg)                   \
+    do {                                         \
+        if (__builtin_expect(trace_on, 0)) {     \
+            trace_event('B', (name), (arg));     \
+        }                                        \
+    } while (0)
+
+#define TRACE_END(name)                          \
+    do {                                         \
+        if (__builtin_expect(trace_on, 0)) {     \
+            trace_event('E', (name), NULL);      \
+        }                                        \
+    } while (0)
+
+/**
+ * @brief Starts recording, with rings of events_per_thread events. Call before starting threads.
+ *
+ * @return BLING_OK, BLING_ERR_INVAL for a zero size.
+ */
+int trace_enable(size_t events_per_thread);
+
+/**
+ * @brief Records one event on the calling thread's ring; use the macros instead.
+ *
+ * @param name A string literal: only the pointer is stored.
+ * @param arg Copied, may be NULL; shown as args.detail in the viewer.
+ */
+void trace_event(char phase, const char *name, const char *arg);
+
+/**
+ * @brief Writes every ring's events to path as Chrome trace JSON, replacing the file.
+ *
+ * Threads keep recording while this runs; events they overwrite during the copy are left out.
+ *
+ * @return BLING_OK, BLING_ERR_INVAL if tracing is off, BLING_ERR_IO / BLING_ERR_NOMEM.
+ */
+int trace_write(const char *path);
+
+#endif // TRACE_H
@@ -1,18 +1,12 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "util.h"
+#include "bling.h"
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 
-char *strdup(const char *src) {
-    char *dst = malloc(strlen(src) + 1);
-    if (dst == NULL)
-        return NULL;
-    strcpy(dst, src);
-    return dst;
-}
-
 void removeChars(char *str, char c) {
     int i, j = 0;
     for (i = 0; str[i]; i++) {
@@ -22,3 +16,67 @@ void removeChars(char *str, char c) {
     }
     str[j] = '\0';
 }
+
+unsigned long long scan_ull(const char **p) {
+    const char *s = *p;
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+
+    unsigned long long value = 0;
+    while (*s >= '0' && *s <= '9') {
+        value = value * 10 + (unsigned long long)(*s - '0');
+        s++;
+    }
+
+    *p = s;
+    return value;
+}
+
+double scan_decimal(const char **p) {
+    double value = (double)scan_ull(p);
+
+    const char *s = *p;
+    if (*s == '.') {
+        s++;
+        double scale = 0.1;
+        while (*s >= '0' && *s <= '9') {
+            value += (*s - '0') * scale;
+            scale *= 0.1;
+            s++;
+        }
+    }
+
+    *p = s;
+    return value;
+}
+
+void skip_field(const char **p) {
+    const char *s = *p;
+    while (*s != '\0' && *s != ' ' && *s != '\t' && *s != '\n') {
+        s++;
+    }
+    while (*s == ' ' || *s == '\t') {
+        s++;
+    }
+    *p = s;
+}
+
+const char *next_line(const char *p) {
+    const char *nl = strchr(p, '\n');
+    return nl != NULL ? nl + 1 : p + strlen(p);
+}
+
+int errno_status(int err) {
+    switch (err) {
+    case ENOMEM:
+        return BLING_ERR_NOMEM;
+    case ENOENT:
+    case ENOTDIR:
+        return BLING_ERR_NOTFOUND;
+    case EINVAL:
+        return BLING_ERR_INVAL;
+    default:
+        return BLING_ERR_IO;
+    }
+}
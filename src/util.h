@@ -4,15 +4,36 @@
 #define UTIL_H
 
 /**
- * @brief A portable implementation of strdup.
- * @param src The source string to duplicate.
- * @return A pointer to the newly allocated duplicate string, or NULL on failure.
+ * @brief Removes all occurrences of a character 'c' from 'str' in-place.
  */
-char *strdup(const char *src);
+void removeChars(char *str, char c);
 
 /**
- * @brief Removes all occurrences of a character 'c' from 'str' in-place.
+ * @brief Skips blanks, parses an unsigned decimal number and advances *p past it.
+ *
+ * Hand-rolled instead of sscanf/strtoull: the hot procfs parsers call this
+ * millions of times and never need locale, sign or base handling.
  */
-void removeChars(char *str, char c);
+unsigned long long scan_ull(const char **p);
+
+/**
+ * @brief Like scan_ull() for an unsigned decimal fraction such as "1.85".
+ */
+double scan_decimal(const char **p);
+
+/**
+ * @brief Advances *p past the current whitespace-separated field and the blanks after it.
+ */
+void skip_field(const char **p);
+
+/**
+ * @brief Returns a pointer to the character after the next newline, or to the terminator.
+ */
+const char *next_line(const char *p);
+
+/**
+ * @brief Maps an errno value to the closest enum bling_status code.
+ */
+int errno_status(int err);
 
 #endif // UTIL_H
@@ -0,0 +1,226 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "virt.h"
+#include "bling.h"
+#include "file.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#define SYSFS_VULNS "/sys/devices/system/cpu/vulnerabilities"
+#define SYSFS_DMI "/sys/class/dmi/id"
+#define VULN_PATH_SIZE 96
+
+/**
+ * @brief Vendor signatures of the CPUID hypervisor leaf (0x40000000, EBX:ECX:EDX).
+ */
+static const struct {
+    char signature[13];
+    const char *name;
+} cpuid_vendors[] = {
+    { "KVMKVMKVM\0\0\0", "KVM" },
+    { "Linux KVM Hv", "KVM" }, // KVM exposing Hyper-V enlightenments
+    { "Microsoft Hv", "Hyper-V" },
+    { "VMwareVMware", "VMware" },
+    { "XenVMMXenVMM", "Xen" },
+    { "TCGTCGTCGTCG", "QEMU TCG" },
+    { "bhyve bhyve ", "bhyve" },
+    { " lrpepyh  vr", "Parallels" },
+    { "ACRNACRNACRN", "ACRN" },
+    { "VBoxVBoxVBox", "VirtualBox" },
+    { "QNXQVMBSQG\0\0", "QNX" },
+};
+
+/**
+ * @brief DMI vendor/product strings of virtual machines whose CPUID leaf is hidden or generic.
+ */
+static const struct {
+    const char *match;
+    const char *name;
+} dmi_vendors[] = {
+    { "Amazon EC2", "AWS EC2" },
+    { "Google", "GCE" },
+    { "QEMU", "QEMU" },
+    { "KVM", "KVM" },
+    { "VMware", "VMware" },
+    { "VirtualBox", "VirtualBox" },
+    { "innotek", "VirtualBox" },
+    { "Xen", "Xen" },
+    { "Microsoft Corporation", "Hyper-V" }, // Only as a fallback: also the vendor of Surface laptops
+    { "Parallels", "Parallels" },
+    { "BHYVE", "bhyve" },
+    { "OpenStack", "OpenStack" },
+};
+
+static int cpuid_hypervisor(char *out, size_t size) {
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1u << 31))) {
+        return 0; // The hypervisor-present bit
+    }
+
+    char signature[13];
+    __cpuid(0x40000000, eax, ebx, ecx, edx);
+    memcpy(signature, &ebx, 4);
+    memcpy(signature + 4, &ecx, 4);
+    memcpy(signature + 8, &edx, 4);
+    signature[12] = '\0';
+
+    for (size_t i = 0; i < sizeof(cpuid_vendors) / sizeof(cpuid_vendors[0]); i++) {
+        if (memcmp(signature, cpuid_vendors[i].signature, 12) == 0) {
+            snprintf(out, size, "%s", cpuid_vendors[i].name);
+            return 1;
+        }
+    }
+    // Present but unknown: show the printable part of the signature
+    snprintf(out, size, "%s", signature[0] >= ' ' && signature[0] <= '~' ? signature : "unknown");
+    return 1;
+#else
+    (void)out;
+    (void)size;
+    return 0;
+#endif
+}
+
+static void read_dmi(const char *attr, char *out, size_t size) {
+    char path[64];
+    snprintf(path, sizeof(path), SYSFS_DMI "/%s", attr);
+    if (read_file(path, out, size) <= 0) {
+        out[0] = '\0';
+        return;
+    }
+    out[strcspn(out, "\n")] = '\0';
+}
+
+static const char *dmi_hypervisor(const struct virt *v) {
+    for (size_t i = 0; i < sizeof(dmi_vendors) / sizeof(dmi_vendors[0]); i++) {
+        if (strstr(v->dmi_vendor, dmi_vendors[i].match) != NULL ||
+            strstr(v->dmi_product, dmi_vendors[i].match) != NULL) {
+            // "Microsoft Corporation" is only a VM when the product says so
+            if (strcmp(dmi_vendors[i].name, "Hyper-V") == 0 && strstr(v->dmi_product, "Virtual Machine") == NULL) {
+                continue;
+            }
+            return dmi_vendors[i].name;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Whether a mitigation still leaves something open, "SMT vulnerable" or "BHI: Vulnerable".
+ */
+static int mentions_vulnerable(const char *status) {
+    for (const char *p = status; *p != '\0'; p++) {
+        if (strncasecmp(p, "vulnerable", 10) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static enum vuln_state classify(const char *status) {
+    if (strncmp(status, "Not affected", 12) == 0) {
+        return VULN_NOT_AFFECTED;
+    }
+    if (strncmp(status, "Mitigation", 10) == 0) {
+        return mentions_vulnerable(status) ? VULN_PARTIAL : VULN_MITIGATED;
+    }
+    if (strncmp(status, "Vulnerable", 10) == 0) {
+        return VULN_VULNERABLE;
+    }
+    return VULN_UNKNOWN;
+}
+
+/**
+ * @brief Reads every vulnerabilities file in one read_files() batch, sorted by name.
+ */
+static void read_vulns(struct virt *v) {
+    DIR *dir = file_opendir(SYSFS_VULNS);
+    if (dir == NULL) {
+        return; // Before 4.15, or not x86/arm64
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && v->vuln_count < VIRT_MAX_VULNS) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        int i = v->vuln_count++;
+        for (; i > 0 && strcmp(v->vulns[i - 1].name, entry->d_name) > 0; i--) {
+            v->vulns[i] = v->vulns[i - 1];
+        }
+        snprintf(v->vulns[i].name, sizeof(v->vulns[i].name), "%.31s", entry->d_name);
+    }
+    closedir(dir);
+
+    char paths[VIRT_MAX_VULNS][VULN_PATH_SIZE];
+    struct file_read files[VIRT_MAX_VULNS];
+    char arena[VIRT_MAX_VULNS * 128];
+    for (int i = 0; i < v->vuln_count; i++) {
+        snprintf(paths[i], sizeof(paths[i]), SYSFS_VULNS "/%s", v->vulns[i].name);
+        files[i].path = paths[i];
+    }
+    read_files(files, (size_t)v->vuln_count, arena, sizeof(arena));
+
+    for (int i = 0; i < v->vuln_count; i++) {
+        struct vuln *vuln = &v->vulns[i];
+        if (files[i].data != NULL) {
+            snprintf(vuln->status, sizeof(vuln->status), "%.*s", (int)strcspn(files[i].data, "\n"), files[i].data);
+        } else {
+            snprintf(vuln->status, sizeof(vuln->status), "unreadable");
+        }
+        vuln->state = classify(vuln->status);
+        v->state_counts[vuln->state]++;
+    }
+}
+
+int virt_detect(struct virt *v) {
+    memset(v, 0, sizeof(*v));
+
+    read_dmi("sys_vendor", v->dmi_vendor, sizeof(v->dmi_vendor));
+    read_dmi("product_name", v->dmi_product, sizeof(v->dmi_product));
+
+    const char *dmi = dmi_hypervisor(v);
+    char xen[16];
+    // Under a replay root the CPU executing this is not the one the fixture came from
+    if (!file_rooted() && cpuid_hypervisor(v->hypervisor, sizeof(v->hypervisor))) {
+        v->source = "cpuid";
+        // The leaf names the hypervisor (KVM); DMI often names the cloud on top of it
+        if (dmi != NULL && strcmp(dmi, v->hypervisor) != 0) {
+            size_t len = strlen(v->hypervisor);
+            snprintf(v->hypervisor + len, sizeof(v->hypervisor) - len, "/%s", dmi);
+        }
+    } else if (dmi != NULL) {
+        snprintf(v->hypervisor, sizeof(v->hypervisor), "%s", dmi);
+        v->source = "dmi";
+    } else if (read_file("/sys/hypervisor/type", xen, sizeof(xen)) > 0) {
+        // Xen PV guests on any architecture
+        xen[strcspn(xen, "\n")] = '\0';
+        snprintf(v->hypervisor, sizeof(v->hypervisor), "%s", xen);
+        v->source = "sysfs";
+    } else {
+        snprintf(v->hypervisor, sizeof(v->hypervisor), "none");
+    }
+
+    read_vulns(v);
+    return BLING_OK;
+}
+
+const char *vuln_mitigation(const struct vuln *vuln, size_t *len_out) {
+    const char *s = vuln->status;
+    if (strncmp(s, "Mitigation: ", 12) == 0) {
+        s += 12;
+    } else if (strncmp(s, "Vulnerable: ", 12) == 0) {
+        s += 12;
+    }
+    *len_out = strcspn(s, ";");
+    return s;
+}
@@ -0,0 +1,47 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef VIRT_H
+#define VIRT_H
+
+#include <stddef.h>
+
+#define VIRT_MAX_VULNS 48
+
+enum vuln_state {
+    VULN_NOT_AFFECTED,
+    VULN_MITIGATED,
+    VULN_PARTIAL, // "Mitigation: ..." that still lists a vulnerable part ("BHI: Vulnerable")
+    VULN_VULNERABLE,
+    VULN_UNKNOWN,
+};
+
+struct vuln {
+    char name[32];    // File name under /sys/devices/system/cpu/vulnerabilities, "spectre_v2"
+    char status[160]; // The file's line, "Mitigation: Enhanced / Automatic IBRS; IBPB: conditional"
+    enum vuln_state state;
+};
+
+/**
+ * @brief Hypervisor and speculative-execution mitigations. Static for the life of the boot, so read once.
+ */
+struct virt {
+    char hypervisor[32]; // "KVM", "Hyper-V", "none" on bare metal
+    const char *source;  // How it was detected: "cpuid", "dmi", "sysfs", or NULL on bare metal
+    char dmi_vendor[64]; // /sys/class/dmi/id/sys_vendor, "" if absent
+    char dmi_product[64];
+
+    struct vuln vulns[VIRT_MAX_VULNS];
+    int vuln_count;
+    int state_counts[VULN_UNKNOWN + 1];
+};
+
+int virt_detect(struct virt *v);
+
+/**
+ * @brief The mitigation part of a status, "Enhanced / Automatic IBRS" for the example above, up to the first ';'.
+ *
+ * @return Length of the span starting at the returned pointer, via len_out.
+ */
+const char *vuln_mitigation(const struct vuln *vuln, size_t *len_out);
+
+#endif // VIRT_H
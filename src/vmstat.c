@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vmstat.h"
+#include "bling.h"
+#include "file.h"
+#include "system.h"
+#include "util.h"
+#include "worker.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * /proc/vmstat has ~180 "key value" lines and only a dozen are wanted. Each key is
+ * hashed from its length, second and last character, which are known as soon as the
+ * separating blank is found, and the hash indexes a table built at compile time.
+ * Empty buckets skip the line with no string comparison at all; only keys landing in
+ * a wanted bucket are confirmed with one memcmp. The multipliers were picked so the
+ * wanted keys do not collide with each other, and so that few of the other keys in a
+ * current kernel land in a wanted bucket.
+ */
+#define VM_HASH_SIZE 128
+#define VM_HASH(len, second, last) ((unsigned int)((len) * 14 + (second) * 13 + (last) * 10) & (VM_HASH_SIZE - 1))
+
+struct vm_key {
+    const char *name;
+    unsigned char len;
+    unsigned char slot; // enum vm_counter + 1, 0 = empty bucket
+};
+
+#define VM_KEY(key, second, last, counter)                                                                             \
+    [VM_HASH(sizeof(key) - 1, second, last)] = { key, sizeof(key) - 1, (counter) + 1 }
+
+static const struct vm_key vm_keys[VM_HASH_SIZE] = {
+    VM_KEY("pgfault", 'g', 't', VM_PGFAULT),
+    VM_KEY("pgmajfault", 'g', 't', VM_PGMAJFAULT),
+    VM_KEY("pswpin", 's', 'n', VM_PSWPIN),
+    VM_KEY("pswpout", 's', 't', VM_PSWPOUT),
+    VM_KEY("pgscan_kswapd", 'g', 'd', VM_PGSCAN_KSWAPD),
+    VM_KEY("pgscan_direct", 'g', 't', VM_PGSCAN_DIRECT),
+    VM_KEY("pgsteal_kswapd", 'g', 'd', VM_PGSTEAL_KSWAPD),
+    VM_KEY("pgsteal_direct", 'g', 't', VM_PGSTEAL_DIRECT),
+    VM_KEY("thp_fault_alloc", 'h', 'c', VM_THP_FAULT_ALLOC),
+    VM_KEY("thp_fault_fallback", 'h', 'k', VM_THP_FAULT_FALLBACK),
+    VM_KEY("thp_collapse_alloc_failed", 'h', 'd', VM_THP_COLLAPSE_ALLOC_FAILED),
+    VM_KEY("oom_kill", 'o', 'l', VM_OOM_KILL),
+};
+
+static const char *const vm_names[VM_COUNTERS] = {
+    [VM_PGFAULT] = "pgfault",
+    [VM_PGMAJFAULT] = "pgmajfault",
+    [VM_PSWPIN] = "pswpin",
+    [VM_PSWPOUT] = "pswpout",
+    [VM_PGSCAN_KSWAPD] = "pgscan_kswapd",
+    [VM_PGSCAN_DIRECT] = "pgscan_direct",
+    [VM_PGSTEAL_KSWAPD] = "pgsteal_kswapd",
+    [VM_PGSTEAL_DIRECT] = "pgsteal_direct",
+    [VM_THP_FAULT_ALLOC] = "thp_fault_alloc",
+    [VM_THP_FAULT_FALLBACK] = "thp_fault_fallback",
+    [VM_THP_COLLAPSE_ALLOC_FAILED] = "thp_collapse_alloc_failed",
+    [VM_OOM_KILL] = "oom_kill",
+    [VM_CTXT] = "ctxt",
+    [VM_FORKS] = "processes",
+};
+
+const char *vmstat_name(int counter) {
+    return counter >= 0 && counter < VM_COUNTERS ? vm_names[counter] : NULL;
+}
+
+static void parse_vmstat(struct vmstat *vm) {
+    for (const char *p = vm->buf; *p != '\0';) {
+        const char *blank = p;
+        while (*blank != ' ' && *blank != '\n' && *blank != '\0') {
+            blank++;
+        }
+        size_t len = (size_t)(blank - p);
+
+        if (len >= 2 && *blank == ' ') {
+            const struct vm_key *key = &vm_keys[VM_HASH(len, (unsigned char)p[1], (unsigned char)blank[-1])];
+            if (key->slot != 0 && key->len == len && memcmp(key->name, p, len) == 0) {
+                const char *v = blank;
+                vm->counters[key->slot - 1] = scan_ull(&v);
+            }
+        }
+
+        p = next_line(blank);
+    }
+}
+
+int vmstat_sample(struct vmstat *vm, const struct cpustat *cs) {
+    long long now = worker_now_ms();
+    if (read_file_buf("/proc/vmstat", &vm->buf, &vm->buf_capacity) < 0) {
+        return errno_status(errno);
+    }
+
+    memcpy(vm->prev, vm->counters, sizeof(vm->prev));
+    parse_vmstat(vm);
+
+    vm->has_sched = cs != NULL && cs->samples > 0;
+    if (vm->has_sched) {
+        vm->counters[VM_CTXT] = cs->ctxt;
+        vm->counters[VM_FORKS] = cs->processes;
+    }
+
+    double seconds = vm->samples > 0 ? (double)(now - vm->sample_ms) / 1000.0 : uptime_seconds();
+    for (int c = 0; c < VM_COUNTERS; c++) {
+        unsigned long long delta = vm->counters[c] >= vm->prev[c] ? vm->counters[c] - vm->prev[c] : 0;
+        vm->rates[c] = seconds > 0.0 ? (double)delta / seconds : 0.0;
+    }
+
+    vm->sample_ms = now;
+    vm->samples++;
+
+    return BLING_OK;
+}
+
+void vmstat_free(struct vmstat *vm) {
+    free(vm->buf);
+    memset(vm, 0, sizeof(*vm));
+}
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef VMSTAT_H
+#define VMSTAT_H
+
+#include "cpustat.h"
+
+#include <stddef.h>
+
+enum vm_counter {
+    VM_PGFAULT,
+    VM_PGMAJFAULT,
+    VM_PSWPIN,
+    VM_PSWPOUT,
+    VM_PGSCAN_KSWAPD,
+    VM_PGSCAN_DIRECT,
+    VM_PGSTEAL_KSWAPD,
+    VM_PGSTEAL_DIRECT,
+    VM_THP_FAULT_ALLOC,
+    VM_THP_FAULT_FALLBACK,
+    VM_THP_COLLAPSE_ALLOC_FAILED,
+    VM_OOM_KILL,
+    VM_CTXT,  // From /proc/stat, via cpustat
+    VM_FORKS, // "processes" in /proc/stat
+    VM_COUNTERS
+};
+
+/**
+ * @brief Paging, reclaim and scheduler event rates from /proc/vmstat and /proc/stat.
+ */
+struct vmstat {
+    unsigned long long counters[VM_COUNTERS];
+    unsigned long long prev[VM_COUNTERS];
+    double rates[VM_COUNTERS]; // Per second since the previous sample; averages since boot on the first
+    int has_sched;             // VM_CTXT and VM_FORKS are valid
+    int samples;
+    long long sample_ms;
+
+    char *buf;
+    size_t buf_capacity;
+};
+
+/**
+ * @brief Re-reads /proc/vmstat and computes rates. Zero-initialize the struct before the first call.
+ *
+ * @param cs Latest cpustat sample for the context switch and fork counters, so /proc/stat
+ *           is not read twice; NULL leaves them out.
+ */
+int vmstat_sample(struct vmstat *vm, const struct cpustat *cs);
+
+/**
+ * @brief Key of a counter as it appears in /proc/vmstat ("pgmajfault"), or "ctxt"/"processes".
+ */
+const char *vmstat_name(int counter);
+
+void vmstat_free(struct vmstat *vm);
+
+#endif // VMSTAT_H
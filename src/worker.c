@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "worker.h"
+#include "bling.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+struct worker {
+    pthread_mutex_t lock;
+    pthread_cond_t done_cond;
+    int refs; // Thread + caller
+    int done;
+    int status;
+
+    int (*fn)(void *);
+    void *arg;
+    void (*discard)(void *);
+};
+
+static void worker_unref(struct worker *w) {
+    pthread_mutex_lock(&w->lock);
+    int last = --w->refs == 0;
+    pthread_mutex_unlock(&w->lock);
+
+    if (last) {
+        w->discard(w->arg);
+        pthread_cond_destroy(&w->done_cond);
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+    }
+}
+
+static void *worker_main(void *p) {
+    struct worker *w = p;
+
+    int status = w->fn(w->arg);
+
+    pthread_mutex_lock(&w->lock);
+    w->status = status;
+    w->done = 1;
+    pthread_cond_broadcast(&w->done_cond);
+    pthread_mutex_unlock(&w->lock);
+
+    worker_unref(w);
+    return NULL;
+}
+
+long long worker_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int worker_start(struct worker **out, int (*fn)(void *), void *arg, void (*discard)(void *)) {
+    struct worker *w = calloc(1, sizeof(*w));
+    if (w == NULL) {
+        return BLING_ERR_NOMEM;
+    }
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&w->done_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    pthread_mutex_init(&w->lock, NULL);
+
+    w->refs = 2;
+    w->fn = fn;
+    w->arg = arg;
+    w->discard = discard;
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    // Collectors only parse small files; don't reserve the default 8 MiB per stuck thread
+    pthread_attr_setstacksize(&attr, 256 * 1024);
+
+    pthread_t thread;
+    int err = pthread_create(&thread, &attr, worker_main, w);
+    pthread_attr_destroy(&attr);
+
+    if (err != 0) {
+        pthread_cond_destroy(&w->done_cond);
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return err == EAGAIN ? BLING_ERR_IO : BLING_ERR_NOMEM;
+    }
+
+    *out = w;
+    return BLING_OK;
+}
+
+int worker_wait(struct worker *w, long long deadline_ms) {
+    struct timespec ts = {
+        .tv_sec = deadline_ms / 1000,
+        .tv_nsec = (deadline_ms % 1000) * 1000000,
+    };
+
+    pthread_mutex_lock(&w->lock);
+    while (!w->done) {
+        if (pthread_cond_timedwait(&w->done_cond, &w->lock, &ts) == ETIMEDOUT) {
+            break;
+        }
+    }
+    int status = w->done ? w->status : BLING_ERR_TIMEOUT;
+    pthread_mutex_unlock(&w->lock);
+
+    return status;
+}
+
+int worker_finished(struct worker *w) {
+    pthread_mutex_lock(&w->lock);
+    int done = w->done;
+    pthread_mutex_unlock(&w->lock);
+    return done;
+}
+
+void worker_release(struct worker *w) {
+    if (w != NULL) {
+        worker_unref(w);
+    }
+}
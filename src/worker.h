@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef WORKER_H
+#define WORKER_H
+
+/*
+ * One-shot worker threads with a deadline.
+ *
+ * A worker runs fn(arg) on its own detached thread. The caller waits for it with a
+ * deadline; if the deadline passes the caller can simply keep its reference (to
+ * check on the worker later) or drop it. The worker and arg are freed when both
+ * the thread and the caller are done with them, so a collector stuck in the kernel
+ * never blocks the caller and never leaks into the next collection.
+ */
+
+struct worker;
+
+/**
+ * @brief Starts fn(arg) on a new thread.
+ *
+ * @param discard Called with arg once the last reference is released; frees arg.
+ * @return BLING_OK, or an error if the thread could not be created (arg is untouched).
+ */
+int worker_start(struct worker **out, int (*fn)(void *), void *arg, void (*discard)(void *));
+
+/**
+ * @brief Waits until the worker finishes or the monotonic deadline (ms, see worker_now_ms) passes.
+ *
+ * @return fn's return value, or BLING_ERR_TIMEOUT.
+ */
+int worker_wait(struct worker *w, long long deadline_ms);
+
+/**
+ * @brief Non-zero once fn has returned.
+ */
+int worker_finished(struct worker *w);
+
+/**
+ * @brief Drops the caller's reference. The worker may still be running.
+ */
+void worker_release(struct worker *w);
+
+/**
+ * @brief CLOCK_MONOTONIC in milliseconds, the clock deadlines are measured on.
+ */
+long long worker_now_ms(void);
+
+#endif // WORKER_H